@@ -0,0 +1,161 @@
+#pragma once
+
+// DESCRIPTION:
+//  A bump-pointer arena for short-lived allocations.
+//
+//  Allocation is a pointer increment inside the current chunk; when a chunk is
+//  exhausted a new one, twice as large, is taken from the upstream resource.
+//  Individual deallocations are no-ops. All memory is returned at once with
+//  release(), or recycled with reset(), which keeps the largest chunk so a
+//  steady-state workload stops touching the upstream allocator entirely.
+//
+//  Arena is a std::pmr::memory_resource, so it plugs into every std::pmr
+//  container, and ArenaAllocator<T> is a plain standard allocator whose
+//  allocate() is inlined instead of going through a virtual call.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+
+namespace allocators {
+
+class Arena : public std::pmr::memory_resource {
+public:
+  static constexpr size_t kDefaultChunkSize = 64 * 1024;
+
+  explicit Arena(size_t initial_chunk_size = kDefaultChunkSize,
+                 std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+      : next_chunk_size_(std::max(initial_chunk_size, sizeof(Chunk) * 2)), upstream_(upstream) {}
+
+  /// Use `buffer` (e.g. on the stack) as the first chunk. It is never freed.
+  Arena(void *buffer, size_t size,
+        std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+      : Arena(size * 2, upstream) {
+    initial_ = static_cast<std::byte *>(buffer);
+    initial_size_ = size;
+    cur_ = initial_;
+    end_ = initial_ + initial_size_;
+  }
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  ~Arena() override { release(); }
+
+  /// Inline fast path, also used by ArenaAllocator.
+  void *allocate_bytes(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+    auto p = reinterpret_cast<uintptr_t>(cur_);
+    auto aligned = (p + alignment - 1) & ~(uintptr_t{alignment} - 1);
+    if (aligned + bytes > reinterpret_cast<uintptr_t>(end_) || cur_ == nullptr)
+      return allocate_slow(bytes, alignment);
+    cur_ = reinterpret_cast<std::byte *>(aligned + bytes);
+    bytes_allocated_ += bytes;
+    return reinterpret_cast<void *>(aligned);
+  }
+
+  /// Return every chunk to the upstream resource.
+  void release() {
+    while (chunks_) {
+      Chunk *prev = chunks_->prev;
+      upstream_->deallocate(chunks_, chunks_->size, alignof(Chunk));
+      chunks_ = prev;
+    }
+    cur_ = initial_;
+    end_ = initial_ + initial_size_;
+    bytes_allocated_ = 0;
+  }
+
+  /// Drop every allocation but keep the most recent (largest) chunk for reuse.
+  void reset() {
+    if (!chunks_ || initial_) {
+      release();
+      return;
+    }
+    Chunk *keep = chunks_;
+    chunks_ = keep->prev;
+    release();
+    keep->prev = nullptr;
+    chunks_ = keep;
+    cur_ = reinterpret_cast<std::byte *>(keep + 1);
+    end_ = reinterpret_cast<std::byte *>(keep) + keep->size;
+    bytes_allocated_ = 0;
+  }
+
+  /// Bytes handed out since the last release()/reset(), excluding padding.
+  [[nodiscard]] size_t bytes_allocated() const { return bytes_allocated_; }
+
+  /// Number of chunks currently held from the upstream resource.
+  [[nodiscard]] size_t chunk_count() const {
+    size_t n = 0;
+    for (Chunk *c = chunks_; c; c = c->prev)
+      ++n;
+    return n;
+  }
+
+protected:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    return allocate_bytes(bytes, alignment);
+  }
+
+  void do_deallocate(void *, size_t, size_t) override {}
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+private:
+  struct alignas(std::max_align_t) Chunk {
+    Chunk *prev;
+    size_t size;
+  };
+
+  void *allocate_slow(size_t bytes, size_t alignment) {
+    const size_t needed = sizeof(Chunk) + bytes + alignment;
+    size_t size = std::max(next_chunk_size_, needed);
+    next_chunk_size_ = size * 2;
+
+    auto *chunk = static_cast<Chunk *>(upstream_->allocate(size, alignof(Chunk)));
+    chunk->prev = chunks_;
+    chunk->size = size;
+    chunks_ = chunk;
+    cur_ = reinterpret_cast<std::byte *>(chunk + 1);
+    end_ = reinterpret_cast<std::byte *>(chunk) + size;
+    return allocate_bytes(bytes, alignment);
+  }
+
+  std::byte *cur_ = nullptr;
+  std::byte *end_ = nullptr;
+  std::byte *initial_ = nullptr; // caller-supplied first buffer, if any
+  size_t initial_size_ = 0;
+  Chunk *chunks_ = nullptr;
+  size_t next_chunk_size_;
+  size_t bytes_allocated_ = 0;
+  std::pmr::memory_resource *upstream_;
+};
+
+/// Standard allocator drawing from an Arena. deallocate() is a no-op; the
+/// memory comes back when the arena is released or reset.
+template <typename T> class ArenaAllocator {
+public:
+  using value_type = T;
+
+  explicit ArenaAllocator(Arena &arena) noexcept : arena_(&arena) {}
+  template <typename U> ArenaAllocator(const ArenaAllocator<U> &other) noexcept : arena_(other.arena_) {}
+
+  T *allocate(size_t n) { return static_cast<T *>(arena_->allocate_bytes(n * sizeof(T), alignof(T))); }
+  void deallocate(T *, size_t) noexcept {}
+
+  [[nodiscard]] Arena &arena() const noexcept { return *arena_; }
+
+  template <typename U> bool operator==(const ArenaAllocator<U> &other) const noexcept {
+    return arena_ == other.arena_;
+  }
+
+private:
+  template <typename U> friend class ArenaAllocator;
+  Arena *arena_;
+};
+
+} // end of namespace allocators
@@ -0,0 +1,64 @@
+#include "arena.hpp"
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+TEST(arena, bump_allocation_and_alignment) {
+  allocators::Arena arena{1024};
+
+  auto *a = static_cast<char *>(arena.allocate_bytes(3, 1));
+  auto *b = static_cast<double *>(arena.allocate_bytes(sizeof(double), alignof(double)));
+  auto *c = arena.allocate_bytes(100, 64);
+
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % alignof(double), 0);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(c) % 64, 0);
+  EXPECT_LT(a, reinterpret_cast<char *>(b));
+  EXPECT_EQ(arena.bytes_allocated(), 3 + sizeof(double) + 100);
+  EXPECT_EQ(arena.chunk_count(), 1);
+
+  // Larger than a chunk: the arena grows.
+  arena.allocate_bytes(4096);
+  EXPECT_EQ(arena.chunk_count(), 2);
+
+  arena.reset();
+  EXPECT_EQ(arena.chunk_count(), 1);
+  EXPECT_EQ(arena.bytes_allocated(), 0);
+
+  arena.release();
+  EXPECT_EQ(arena.chunk_count(), 0);
+}
+
+TEST(arena, initial_buffer_is_used_first) {
+  alignas(std::max_align_t) std::byte buffer[256];
+  allocators::Arena arena{buffer, sizeof(buffer)};
+
+  auto *p = static_cast<std::byte *>(arena.allocate_bytes(128));
+  EXPECT_GE(p, buffer);
+  EXPECT_LT(p, buffer + sizeof(buffer));
+  EXPECT_EQ(arena.chunk_count(), 0);
+
+  arena.allocate_bytes(256);
+  EXPECT_EQ(arena.chunk_count(), 1);
+
+  arena.release();
+  EXPECT_EQ(arena.allocate_bytes(16), buffer);
+}
+
+TEST(arena, pmr_containers_and_allocator) {
+  allocators::Arena arena;
+  {
+    std::pmr::vector<std::pmr::string> words{&arena};
+    for (int i = 0; i < 100; ++i)
+      words.emplace_back("a string long enough to defeat SSO #" + std::to_string(i));
+    EXPECT_EQ(words[42], "a string long enough to defeat SSO #42");
+  }
+  EXPECT_GT(arena.bytes_allocated(), 100 * 36);
+
+  std::vector<int, allocators::ArenaAllocator<int>> v{allocators::ArenaAllocator<int>{arena}};
+  for (int i = 0; i < 1000; ++i)
+    v.push_back(i);
+  EXPECT_EQ(v[999], 999);
+  EXPECT_EQ(&v.get_allocator().arena(), &arena);
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+// DESCRIPTION:
+//  A memory resource for large, dense buffers, backed by 2MB huge pages.
+//
+//  Walking a big buffer through 4KB pages costs one TLB entry per 4KB; the
+//  data TLB covers only a few MB that way, so large streaming or strided
+//  kernels spend much of their time on page walks. With 2MB pages one entry
+//  covers 512 times as much.
+//
+//  Requests of at least `threshold` bytes are served by their own anonymous
+//  mapping, aligned to and rounded up to 2MB, and marked MADV_HUGEPAGE so
+//  transparent huge pages back it even when the system policy is "madvise".
+//  With `populate`, the mapping is pre-faulted before it is handed out, so
+//  the first pass over the buffer does not take the page faults. Smaller
+//  requests go to the upstream resource.
+//
+//  Huge pages are a hint: if the kernel has none to give, the mapping still
+//  works with normal pages. Without mmap (non-POSIX) everything goes
+//  upstream.
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define ALLOCATORS_HAVE_MMAP 1
+#endif
+
+namespace allocators {
+
+struct HugePageOptions {
+  size_t threshold = size_t{1} << 20; // smaller requests go upstream
+  bool populate = false;              // pre-fault the whole mapping
+};
+
+class HugePageResource : public std::pmr::memory_resource {
+public:
+  static constexpr size_t kHugePageSize = size_t{2} << 20;
+
+  explicit HugePageResource(HugePageOptions options = {},
+                            std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+      : options_(options), upstream_(upstream) {}
+
+  [[nodiscard]] const HugePageOptions &options() const { return options_; }
+
+  /// Bytes a request of `bytes` actually maps.
+  static constexpr size_t mapped_size(size_t bytes) {
+    return (bytes + kHugePageSize - 1) & ~(kHugePageSize - 1);
+  }
+
+protected:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+#ifdef ALLOCATORS_HAVE_MMAP
+    if (bytes >= options_.threshold && alignment <= kHugePageSize)
+      return map(mapped_size(bytes));
+#endif
+    return upstream_->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+#ifdef ALLOCATORS_HAVE_MMAP
+    if (bytes >= options_.threshold && alignment <= kHugePageSize) {
+      ::munmap(p, mapped_size(bytes));
+      return;
+    }
+#endif
+    upstream_->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    auto *o = dynamic_cast<const HugePageResource *>(&other);
+    return o && o->options_.threshold == options_.threshold && o->upstream_ == upstream_;
+  }
+
+private:
+#ifdef ALLOCATORS_HAVE_MMAP
+  void *map(size_t size) const {
+    // Over-map by one huge page so a 2MB-aligned window of `size` fits, then
+    // give back the ragged ends.
+    void *raw = ::mmap(nullptr, size + kHugePageSize, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+      throw std::bad_alloc();
+    const auto start = reinterpret_cast<uintptr_t>(raw);
+    const auto aligned = (start + kHugePageSize - 1) & ~(uintptr_t{kHugePageSize} - 1);
+    if (aligned > start)
+      ::munmap(raw, aligned - start);
+    if (const size_t tail = kHugePageSize - (aligned - start))
+      ::munmap(reinterpret_cast<void *>(aligned + size), tail);
+
+    auto *p = reinterpret_cast<void *>(aligned);
+#ifdef MADV_HUGEPAGE
+    ::madvise(p, size, MADV_HUGEPAGE);
+#endif
+    if (options_.populate)
+      prefault(p, size);
+    return p;
+  }
+
+  static void prefault(void *p, size_t size) {
+#ifdef MADV_POPULATE_WRITE
+    // Faults the range in after the MADV_HUGEPAGE hint, so it is populated
+    // with huge pages; MAP_POPULATE at mmap time would come too early.
+    if (::madvise(p, size, MADV_POPULATE_WRITE) == 0)
+      return;
+#endif
+    // Touch one byte per huge page; the kernel fills the rest of each page.
+    auto *bytes = static_cast<volatile char *>(p);
+    for (size_t off = 0; off < size; off += kHugePageSize)
+      bytes[off] = 0;
+  }
+#endif
+
+  HugePageOptions options_;
+  std::pmr::memory_resource *upstream_;
+};
+
+/// Process-wide resources with the default threshold, lazily faulted or
+/// pre-faulted.
+inline HugePageResource *huge_page_resource(bool populate = false) {
+  static HugePageResource lazy{HugePageOptions{}};
+  static HugePageResource eager{HugePageOptions{.populate = true}};
+  return populate ? &eager : &lazy;
+}
+
+/// Standard allocator over a HugePageResource; for std::vector<T> and the like.
+template <typename T> class HugePageAllocator {
+public:
+  using value_type = T;
+
+  HugePageAllocator() noexcept : resource_(huge_page_resource()) {}
+  explicit HugePageAllocator(HugePageResource *resource) noexcept : resource_(resource) {}
+  template <typename U>
+  HugePageAllocator(const HugePageAllocator<U> &other) noexcept : resource_(other.resource_) {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(resource_->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *p, size_t n) noexcept { resource_->deallocate(p, n * sizeof(T), alignof(T)); }
+
+  [[nodiscard]] HugePageResource *resource() const noexcept { return resource_; }
+
+  template <typename U> bool operator==(const HugePageAllocator<U> &other) const noexcept {
+    return resource_ == other.resource_;
+  }
+
+private:
+  template <typename U> friend class HugePageAllocator;
+  HugePageResource *resource_;
+};
+
+} // end of namespace allocators
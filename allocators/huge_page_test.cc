@@ -0,0 +1,239 @@
+#include "huge_page.hpp"
+#include "my_timer.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+/// Counts data-TLB read misses of this thread, user space only. valid() is
+/// false where perf events are unavailable (non-Linux, containers, a strict
+/// perf_event_paranoid).
+class DtlbMissCounter {
+public:
+  DtlbMissCounter() {
+#if defined(__linux__)
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+  }
+  ~DtlbMissCounter() {
+#if defined(__linux__)
+    if (fd_ >= 0)
+      ::close(fd_);
+#endif
+  }
+  DtlbMissCounter(const DtlbMissCounter &) = delete;
+  DtlbMissCounter &operator=(const DtlbMissCounter &) = delete;
+
+  [[nodiscard]] bool valid() const { return fd_ >= 0; }
+
+  void start() {
+#if defined(__linux__)
+    if (valid()) {
+      ::ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ::ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  uint64_t stop() {
+    uint64_t count = 0;
+#if defined(__linux__)
+    if (valid()) {
+      ::ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+      if (::read(fd_, &count, sizeof(count)) != sizeof(count))
+        count = 0;
+    }
+#endif
+    return count;
+  }
+
+private:
+  int fd_ = -1;
+};
+
+/// kB of AnonHugePages backing the mapping that contains `p`, or -1 if
+/// /proc/self/smaps can't tell.
+long anon_huge_kb(const void *p) {
+  std::ifstream smaps("/proc/self/smaps");
+  const auto addr = reinterpret_cast<uintptr_t>(p);
+  std::string line;
+  bool inside = false;
+  while (std::getline(smaps, line)) {
+    uintptr_t lo = 0, hi = 0;
+    char dash = 0;
+    std::istringstream head(line);
+    if (head >> std::hex >> lo >> dash >> hi && dash == '-') {
+      inside = lo <= addr && addr < hi;
+      continue;
+    }
+    if (inside && line.rfind("AnonHugePages:", 0) == 0)
+      return std::stol(line.substr(std::strlen("AnonHugePages:")));
+  }
+  return -1;
+}
+
+/// The bracketed transparent huge page mode ("always", "madvise" or
+/// "never"), or "" where the kernel doesn't report one.
+std::string thp_mode() {
+  std::ifstream enabled("/sys/kernel/mm/transparent_hugepage/enabled");
+  std::string word;
+  while (enabled >> word)
+    if (word.size() > 2 && word.front() == '[' && word.back() == ']')
+      return word.substr(1, word.size() - 2);
+  return "";
+}
+
+} // namespace
+
+TEST(huge_page, large_requests_are_2mb_aligned) {
+  allocators::HugePageResource resource{{.threshold = 1 << 20}};
+  constexpr size_t big = (3 << 20) + 123;
+
+  void *p = resource.allocate(big, 64);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % allocators::HugePageResource::kHugePageSize, 0);
+  EXPECT_EQ(allocators::HugePageResource::mapped_size(big), 4 << 20);
+  std::memset(p, 0x5a, big); // the whole request is writable
+  resource.deallocate(p, big, 64);
+
+  // Small requests come from upstream, with the alignment asked for.
+  void *q = resource.allocate(100, 32);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(q) % 32, 0);
+  resource.deallocate(q, 100, 32);
+}
+
+TEST(huge_page, allocator_and_pmr_containers) {
+  std::vector<double, allocators::HugePageAllocator<double>> v(1 << 20, 1.0);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(v.data()) % allocators::HugePageResource::kHugePageSize,
+            0);
+  EXPECT_EQ(std::accumulate(v.begin(), v.end(), 0.0), double{1 << 20});
+
+  // Node containers allocate node by node; put an arena on top so the nodes
+  // land in huge-page blocks.
+  std::pmr::monotonic_buffer_resource arena{4 << 20, allocators::huge_page_resource()};
+  std::pmr::set<int> s{&arena};
+  for (int i = 0; i < 100000; ++i)
+    s.insert((i * 7919) % 100000);
+  EXPECT_EQ(s.size(), 100000);
+  EXPECT_EQ(*s.rbegin(), 99999);
+}
+
+TEST(huge_page, populate_backs_mapping_with_huge_pages) {
+  constexpr size_t size = 16 << 20;
+  auto *resource = allocators::huge_page_resource(true);
+  const std::string mode = thp_mode();
+  if (mode != "always" && mode != "madvise")
+    GTEST_SKIP() << "transparent huge pages are " << (mode.empty() ? "unavailable" : mode);
+
+  void *p = resource->allocate(size);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % allocators::HugePageResource::kHugePageSize, 0);
+  const long huge_kb = anon_huge_kb(p);
+  EXPECT_LE(huge_kb, long{size >> 10});
+  if (huge_kb <= 0) {
+    resource->deallocate(p, size);
+    // Huge pages are a hint: with memory short or fragmented the kernel
+    // falls back to 4KB pages, which is not a failure.
+    GTEST_SKIP() << (huge_kb < 0 ? "/proc/self/smaps does not report AnonHugePages"
+                                 : "the kernel gave no huge pages this time");
+  }
+#ifndef NDEBUG
+  std::cout << "AnonHugePages after populate: " << huge_kb << " kB of " << (size >> 10)
+            << " kB\n";
+#endif
+  resource->deallocate(p, size);
+}
+
+namespace {
+
+struct KernelResult {
+  uint64_t ns;
+  uint64_t dtlb_misses;
+};
+
+/// Sum the buffer in page-sized hops (one load per 4KB page, cycling over an
+/// offset within the page), the pattern a column walk over a row-major matrix
+/// makes. `passes` times over the whole buffer.
+KernelResult page_stride_sum(const uint64_t *data, size_t n, size_t passes, uint64_t &checksum) {
+  constexpr size_t stride = 4096 / sizeof(uint64_t);
+  DtlbMissCounter counter;
+  counter.start();
+  Timer t("page_stride_sum");
+  for (size_t pass = 0; pass < passes; ++pass)
+    for (size_t offset = 0; offset < stride; offset += 8)
+      for (size_t i = offset; i < n; i += stride)
+        checksum += data[i];
+  auto ns = t.eclipse();
+  return {ns, counter.stop()};
+}
+
+/// Plain sequential sum: the hardware prefetcher hides most of the misses.
+KernelResult stream_sum(const uint64_t *data, size_t n, size_t passes, uint64_t &checksum) {
+  DtlbMissCounter counter;
+  counter.start();
+  Timer t("stream_sum");
+  for (size_t pass = 0; pass < passes; ++pass)
+    checksum += std::accumulate(data, data + n, uint64_t{0});
+  auto ns = t.eclipse();
+  return {ns, counter.stop()};
+}
+
+} // namespace
+
+TEST(huge_page, dtlb_benchmark) {
+  constexpr size_t bytes = 256 << 20;
+  constexpr size_t n = bytes / sizeof(uint64_t);
+
+  // Same buffer size both ways; the baseline is a plain 4KB-page mapping
+  // (std::vector goes to mmap without MADV_HUGEPAGE at this size).
+  std::vector<uint64_t> plain(n);
+  std::iota(plain.begin(), plain.end(), 0);
+  std::vector<uint64_t, allocators::HugePageAllocator<uint64_t>> huge(
+      n, allocators::HugePageAllocator<uint64_t>{allocators::huge_page_resource(true)});
+  std::iota(huge.begin(), huge.end(), 0);
+
+  uint64_t a = 0, b = 0;
+  auto plain_stride = page_stride_sum(plain.data(), n, 1, a);
+  auto huge_stride = page_stride_sum(huge.data(), n, 1, b);
+  auto plain_stream = stream_sum(plain.data(), n, 2, a);
+  auto huge_stream = stream_sum(huge.data(), n, 2, b);
+  EXPECT_EQ(a, b);
+
+#ifndef NDEBUG
+  const bool counted = DtlbMissCounter{}.valid();
+  auto report = [&](const char *name, KernelResult r) {
+    std::cout << "  " << name << ": " << r.ns / 1000000.0 << " ms, dTLB misses "
+              << (counted ? std::to_string(r.dtlb_misses) : std::string("unavailable")) << '\n';
+  };
+  std::cout << "256 MB, page-stride walk:\n";
+  report("4KB pages", plain_stride);
+  report("huge pages", huge_stride);
+  std::cout << "256 MB, sequential sum x2:\n";
+  report("4KB pages", plain_stream);
+  report("huge pages", huge_stream);
+  std::cout << "AnonHugePages: " << anon_huge_kb(huge.data()) << " kB\n";
+#else
+  (void)plain_stride, (void)huge_stride, (void)plain_stream, (void)huge_stream;
+#endif
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+// DESCRIPTION:
+//  A typed object pool: placement new into slots carved from chunks, with
+//  freed slots kept on an intrusive free list (the link lives in the dead
+//  object's own bytes).
+//
+//  * create(args...) pops a free slot, or bumps into the newest chunk, and
+//    constructs T there. destroy(p) runs ~T and pushes the slot. Both O(1).
+//  * Chunks double in size up to kMaxChunkSlots and are never moved or freed
+//    before the pool, so objects have stable addresses.
+//  * object_pool<T> is single-threaded, like allocators::Arena.
+//    concurrent_object_pool<T> (ThreadCaches = true) gives every thread a
+//    magazine of free slots: create/destroy touch only that magazine, and the
+//    pool lock is taken once per kMagazineSize operations to refill or drain
+//    it. An object may be destroyed on a different thread than created it.
+//
+//  Destroying the pool frees its chunks without running destructors; destroy
+//  every object first unless T is trivially destructible.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace allocators {
+
+template <typename T, bool ThreadCaches = false> class object_pool {
+public:
+  static constexpr size_t kMaxChunkSlots = 4096;
+  static constexpr size_t kMagazineSize = 32;
+
+  explicit object_pool(size_t first_chunk_slots = 32)
+      : next_chunk_slots_(std::max<size_t>(first_chunk_slots, 1)) {}
+
+  object_pool(const object_pool &) = delete;
+  object_pool &operator=(const object_pool &) = delete;
+
+  ~object_pool() {
+    if constexpr (ThreadCaches) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (auto &m : magazines_)
+        m->pool_alive.store(false, std::memory_order_release);
+    }
+    for (auto [chunk, slots] : chunks_)
+      ::operator delete(chunk, slots * sizeof(Slot), std::align_val_t{alignof(Slot)});
+  }
+
+  template <typename... Args> T *create(Args &&...args) {
+    Slot *s = take_slot();
+    try {
+      return ::new (static_cast<void *>(s->storage)) T(std::forward<Args>(args)...);
+    } catch (...) {
+      give_slot(s);
+      throw;
+    }
+  }
+
+  void destroy(T *p) {
+    if (!p)
+      return;
+    p->~T();
+    give_slot(reinterpret_cast<Slot *>(p));
+  }
+
+  /// Slots carved so far, free or in use.
+  [[nodiscard]] size_t capacity() const {
+    std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+    if constexpr (ThreadCaches)
+      lock.lock();
+    size_t n = 0;
+    for (auto [chunk, slots] : chunks_)
+      n += slots;
+    return n;
+  }
+
+  [[nodiscard]] size_t chunk_count() const {
+    std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+    if constexpr (ThreadCaches)
+      lock.lock();
+    return chunks_.size();
+  }
+
+private:
+  union Slot {
+    Slot *next;
+    alignas(T) std::byte storage[sizeof(T)];
+  };
+
+  // Magazines are shared between the pool and the owning thread's cache, so
+  // whichever goes first leaves the other something valid to look at.
+  struct Magazine {
+    Slot *slots[2 * kMagazineSize];
+    size_t count = 0;
+    std::atomic<bool> orphaned{false};  // owner thread exited; pool may take the slots
+    std::atomic<bool> pool_alive{true}; // pool destroyed; drop the magazine
+  };
+
+  Slot *take_slot() {
+    if constexpr (!ThreadCaches) {
+      return pop_free();
+    } else {
+      Magazine &m = local_magazine();
+      if (m.count == 0)
+        refill(m);
+      return m.slots[--m.count];
+    }
+  }
+
+  void give_slot(Slot *s) {
+    if constexpr (!ThreadCaches) {
+      push_free(s);
+    } else {
+      Magazine &m = local_magazine();
+      if (m.count == 2 * kMagazineSize)
+        drain(m);
+      m.slots[m.count++] = s;
+    }
+  }
+
+  // Shared free list and bump pointer; under mutex_ when ThreadCaches.
+  Slot *pop_free() {
+    if (free_) {
+      Slot *s = free_;
+      free_ = s->next;
+      return s;
+    }
+    if (bump_ == bump_end_)
+      add_chunk();
+    return bump_++;
+  }
+
+  void push_free(Slot *s) {
+    s->next = free_;
+    free_ = s;
+  }
+
+  void add_chunk() {
+    const size_t slots = next_chunk_slots_;
+    next_chunk_slots_ = std::min(slots * 2, kMaxChunkSlots);
+    auto *chunk =
+        static_cast<Slot *>(::operator new(slots * sizeof(Slot), std::align_val_t{alignof(Slot)}));
+    chunks_.emplace_back(chunk, slots);
+    bump_ = chunk;
+    bump_end_ = chunk + slots;
+  }
+
+  void refill(Magazine &m) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reclaim_orphans();
+    while (m.count < kMagazineSize)
+      m.slots[m.count++] = pop_free();
+  }
+
+  void drain(Magazine &m) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (m.count > kMagazineSize)
+      push_free(m.slots[--m.count]);
+  }
+
+  // Caller holds mutex_.
+  void reclaim_orphans() {
+    std::erase_if(magazines_, [this](const std::shared_ptr<Magazine> &m) {
+      if (!m->orphaned.load(std::memory_order_acquire))
+        return false;
+      while (m->count)
+        push_free(m->slots[--m->count]);
+      return true;
+    });
+  }
+
+  Magazine &local_magazine() {
+    // The hot path reads only this trivially destructible slot, which needs
+    // no thread_local init guard.
+    struct Last {
+      uint64_t pool_id;
+      Magazine *magazine;
+    };
+    thread_local constinit Last last{0, nullptr};
+    if (last.pool_id == id_)
+      return *last.magazine;
+
+    struct Owned {
+      std::vector<std::pair<uint64_t, std::shared_ptr<Magazine>>> all;
+      ~Owned() {
+        for (auto &[id, m] : all)
+          m->orphaned.store(true, std::memory_order_release);
+      }
+    };
+    thread_local Owned owned;
+    std::erase_if(owned.all, [](const auto &e) {
+      return !e.second->pool_alive.load(std::memory_order_acquire);
+    });
+    auto it = std::find_if(owned.all.begin(), owned.all.end(),
+                           [this](const auto &e) { return e.first == id_; });
+    if (it == owned.all.end()) {
+      auto m = std::make_shared<Magazine>();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        magazines_.push_back(m);
+      }
+      it = owned.all.emplace(owned.all.end(), id_, std::move(m));
+    }
+    last = {id_, it->second.get()};
+    return *last.magazine;
+  }
+
+  static uint64_t next_id() {
+    static std::atomic<uint64_t> ids{0};
+    return ++ids;
+  }
+
+  Slot *free_ = nullptr;
+  Slot *bump_ = nullptr;
+  Slot *bump_end_ = nullptr;
+  size_t next_chunk_slots_;
+  std::vector<std::pair<Slot *, size_t>> chunks_;
+
+  // ThreadCaches only. Pool ids are never reused, unlike addresses, so a
+  // thread's cached magazine can't be mistaken for a later pool's.
+  const uint64_t id_ = ThreadCaches ? next_id() : 0;
+  mutable std::mutex mutex_;
+  std::vector<std::shared_ptr<Magazine>> magazines_;
+};
+
+template <typename T> using concurrent_object_pool = object_pool<T, true>;
+
+} // end of namespace allocators
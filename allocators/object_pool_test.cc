@@ -0,0 +1,189 @@
+#include "my_timer.h"
+#include "object_pool.hpp"
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Point {
+  double x, y, z;
+  std::string label;
+  Point(double x_, double y_, double z_, std::string l) : x(x_), y(y_), z(z_), label(std::move(l)) {}
+};
+
+struct Fragile {
+  explicit Fragile(bool fail) {
+    if (fail)
+      throw std::runtime_error("construction failed");
+  }
+};
+
+} // namespace
+
+TEST(object_pool, create_destroy_and_reuse) {
+  allocators::object_pool<Point> pool{4};
+
+  Point *a = pool.create(1, 2, 3, "a");
+  Point *b = pool.create(4, 5, 6, "b");
+  EXPECT_EQ(a->label, "a");
+  EXPECT_EQ(b->z, 6);
+
+  pool.destroy(a);
+  Point *c = pool.create(7, 8, 9, "c");
+  EXPECT_EQ(c, a); // the freed slot is handed out first
+
+  // Growing never moves existing objects.
+  std::vector<Point *> more;
+  for (int i = 0; i < 100; ++i)
+    more.push_back(pool.create(i, i, i, std::to_string(i)));
+  EXPECT_EQ(b->label, "b");
+  EXPECT_EQ(more[42]->label, "42");
+  EXPECT_EQ(pool.chunk_count(), 5); // 4 + 8 + 16 + 32 + 64 slots
+  EXPECT_EQ(pool.capacity(), 124);
+
+  for (Point *p : more)
+    pool.destroy(p);
+  pool.destroy(b);
+  pool.destroy(c);
+}
+
+TEST(object_pool, constructor_exception_returns_slot) {
+  allocators::object_pool<Fragile> pool{1};
+  Fragile *ok = pool.create(false);
+  pool.destroy(ok);
+  EXPECT_THROW(pool.create(true), std::runtime_error);
+  EXPECT_EQ(pool.create(false), ok);
+  EXPECT_EQ(pool.capacity(), 1);
+}
+
+TEST(object_pool, cross_thread_destroy) {
+  using Pool = allocators::concurrent_object_pool<std::array<int, 8>>;
+  Pool pool;
+  constexpr int rounds = 4;
+  constexpr int items = 20000;
+  // The producer waits while this many items are queued, so the number of
+  // live slots doesn't depend on how the threads get scheduled.
+  constexpr size_t in_flight = 256;
+
+  for (int r = 0; r < rounds; ++r) {
+    std::mutex m;
+    std::condition_variable not_empty, not_full;
+    std::deque<std::array<int, 8> *> queue;
+    bool done = false;
+
+    std::thread consumer([&] {
+      long sum = 0;
+      while (true) {
+        std::unique_lock<std::mutex> lock(m);
+        not_empty.wait(lock, [&] { return done || !queue.empty(); });
+        if (queue.empty())
+          break;
+        auto *item = queue.front();
+        queue.pop_front();
+        lock.unlock();
+        not_full.notify_one();
+        sum += (*item)[0];
+        pool.destroy(item);
+      }
+      EXPECT_EQ(sum, long{items} * (items - 1) / 2);
+    });
+    std::thread producer([&] {
+      for (int i = 0; i < items; ++i) {
+        auto *item = pool.create();
+        (*item)[0] = i;
+        {
+          std::unique_lock<std::mutex> lock(m);
+          not_full.wait(lock, [&] { return queue.size() < in_flight; });
+          queue.push_back(item);
+        }
+        not_empty.notify_one();
+      }
+      {
+        std::lock_guard<std::mutex> lock(m);
+        done = true;
+      }
+      not_empty.notify_one();
+    });
+    producer.join();
+    consumer.join();
+
+    // Slots left in the exited threads' magazines are reclaimed, so later
+    // rounds reuse memory instead of carving more. At most, live slots are
+    // the queue plus a full magazine (2 * kMagazineSize) for each of this
+    // round's two threads and the last round's two, not yet reclaimed.
+    // Chunks double in size, so capacity stays below twice that.
+    constexpr size_t peak = in_flight + 4 * 2 * Pool::kMagazineSize;
+    EXPECT_LE(pool.capacity(), 2 * peak) << "round " << r;
+  }
+}
+
+namespace {
+
+/// Keep `live` objects alive and replace one per step, in a scattered order.
+template <typename Create, typename Destroy>
+uint64_t churn(size_t steps, size_t live, Create create, Destroy destroy) {
+  std::vector<Point *> objs(live, nullptr);
+  Timer t("churn");
+  for (size_t i = 0; i < steps; ++i) {
+    Point *&slot = objs[(i * 7919) % live];
+    destroy(slot);
+    slot = create(i);
+  }
+  for (Point *p : objs)
+    destroy(p);
+  return t.eclipse();
+}
+
+template <typename Create, typename Destroy>
+uint64_t churn_threads(unsigned threads, size_t steps, size_t live, Create create,
+                       Destroy destroy) {
+  Timer t("churn_threads");
+  std::vector<std::thread> workers;
+  for (unsigned i = 0; i < threads; ++i)
+    workers.emplace_back([&] { churn(steps, live, create, destroy); });
+  for (auto &w : workers)
+    w.join();
+  return t.eclipse();
+}
+
+} // namespace
+
+TEST(object_pool, throughput_benchmark) {
+  constexpr size_t steps = 2000000;
+  constexpr size_t live = 1024;
+  constexpr unsigned threads = 4;
+
+  auto heap_create = [](size_t i) { return new Point(i, i, i, "p"); };
+  auto heap_destroy = [](Point *p) { delete p; };
+
+  allocators::object_pool<Point> pool;
+  auto pool_create = [&](size_t i) { return pool.create(i, i, i, "p"); };
+  auto pool_destroy = [&](Point *p) { pool.destroy(p); };
+
+  allocators::concurrent_object_pool<Point> shared;
+  auto shared_create = [&](size_t i) { return shared.create(i, i, i, "p"); };
+  auto shared_destroy = [&](Point *p) { shared.destroy(p); };
+
+  auto heap_1 = churn(steps, live, heap_create, heap_destroy);
+  auto pool_1 = churn(steps, live, pool_create, pool_destroy);
+  auto shared_1 = churn(steps, live, shared_create, shared_destroy);
+  auto heap_n = churn_threads(threads, steps / threads, live, heap_create, heap_destroy);
+  auto shared_n = churn_threads(threads, steps / threads, live, shared_create, shared_destroy);
+
+#ifndef NDEBUG
+  auto mops = [&](uint64_t ns) { return static_cast<double>(steps) * 1000.0 / ns; };
+  std::cout << "create+destroy, M pairs/s: new/delete " << mops(heap_1) << ", object_pool "
+            << mops(pool_1) << ", concurrent_object_pool " << mops(shared_1) << "; " << threads
+            << " threads: new/delete " << mops(heap_n) << ", concurrent_object_pool "
+            << mops(shared_n) << '\n';
+#else
+  (void)heap_1, (void)pool_1, (void)shared_1, (void)heap_n, (void)shared_n;
+#endif
+}
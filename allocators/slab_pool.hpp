@@ -0,0 +1,225 @@
+#pragma once
+
+// DESCRIPTION:
+//  A size-class slab allocator for small objects, organized like tcmalloc:
+//
+//    thread cache  --(batch of kBatchSize blocks)-->  global depot  <--  slabs
+//
+//  * Requests up to kMaxSmallSize bytes are rounded up to a size class.
+//  * Each thread keeps a free list per class. allocate/deallocate normally
+//    touch only that list: no lock, no atomic.
+//  * When a thread's list runs dry it takes a whole batch from the depot; when
+//    it grows past two batches it hands one batch back. The depot lock is
+//    therefore taken once per kBatchSize operations at most.
+//  * The depot carves fresh slabs into batches when it runs out.
+//  * Larger or over-aligned requests go straight to ::operator new.
+//
+//  The pool is process-wide (one depot, one cache per thread), so SlabAllocator
+//  is stateless and adds nothing to node size. Slab memory is kept for reuse
+//  and never returned to the system.
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace allocators {
+
+class SlabPool {
+public:
+  static constexpr size_t kMaxSmallSize = 512;
+  static constexpr size_t kBatchSize = 32;
+  static constexpr size_t kSlabSize = 64 * 1024;
+  static constexpr size_t kMaxAlign = 16;
+
+  static constexpr std::array<size_t, 12> kClassSizes{8,   16,  32,  48,  64,  96,
+                                                      128, 160, 192, 256, 384, 512};
+
+  /// The process-wide pool. Never destroyed, so thread caches can flush
+  /// into it from thread_local destructors during exit.
+  static SlabPool &instance() {
+    static SlabPool *pool = new SlabPool;
+    return *pool;
+  }
+
+  void *allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+    if (bytes > kMaxSmallSize || alignment > kMaxAlign)
+      return ::operator new(bytes, std::align_val_t{alignment});
+    // Every class but the 8-byte one is 16-byte aligned within its slab.
+    return local_cache().pop(*this, size_class(std::max(bytes, alignment)));
+  }
+
+  void deallocate(void *p, size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+    if (bytes > kMaxSmallSize || alignment > kMaxAlign) {
+      ::operator delete(p, bytes, std::align_val_t{alignment});
+      return;
+    }
+    local_cache().push(*this, size_class(std::max(bytes, alignment)), p);
+  }
+
+  /// Index of the smallest class that fits `bytes`.
+  static constexpr unsigned size_class(size_t bytes) {
+    return kSizeToClass[(std::max<size_t>(bytes, 1) + 7) / 8];
+  }
+
+  /// Number of slabs carved so far, all classes together.
+  [[nodiscard]] size_t slab_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slabs_.size();
+  }
+
+private:
+  static constexpr size_t kNumClasses = kClassSizes.size();
+
+  static constexpr auto kSizeToClass = [] {
+    std::array<uint8_t, kMaxSmallSize / 8 + 1> table{};
+    unsigned cls = 0;
+    for (size_t i = 0; i < table.size(); ++i) {
+      while (kClassSizes[cls] < i * 8)
+        ++cls;
+      table[i] = static_cast<uint8_t>(cls);
+    }
+    return table;
+  }();
+
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  struct Batch {
+    FreeBlock *head = nullptr;
+    size_t count = 0;
+  };
+
+  class ThreadCache {
+  public:
+    ~ThreadCache() {
+      SlabPool &pool = SlabPool::instance();
+      for (unsigned c = 0; c < kNumClasses; ++c)
+        if (lists_[c].count)
+          pool.return_batch(c, lists_[c]);
+    }
+
+    void *pop(SlabPool &pool, unsigned cls) {
+      Batch &list = lists_[cls];
+      if (!list.head)
+        list = pool.take_batch(cls);
+      FreeBlock *b = list.head;
+      list.head = b->next;
+      --list.count;
+      return b;
+    }
+
+    void push(SlabPool &pool, unsigned cls, void *p) {
+      Batch &list = lists_[cls];
+      auto *b = static_cast<FreeBlock *>(p);
+      b->next = list.head;
+      list.head = b;
+      if (++list.count >= 2 * kBatchSize) {
+        // Detach the first kBatchSize blocks and return them in one go.
+        Batch out{list.head, kBatchSize};
+        FreeBlock *last = list.head;
+        for (size_t i = 1; i < kBatchSize; ++i)
+          last = last->next;
+        list.head = last->next;
+        list.count -= kBatchSize;
+        last->next = nullptr;
+        pool.return_batch(cls, out);
+      }
+    }
+
+  private:
+    std::array<Batch, kNumClasses> lists_{};
+  };
+
+  SlabPool() = default;
+
+  static ThreadCache &local_cache() {
+    thread_local ThreadCache cache;
+    return cache;
+  }
+
+  Batch take_batch(unsigned cls) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &depot = depot_[cls];
+    if (depot.empty())
+      carve_slab(cls);
+    Batch b = depot.back();
+    depot.pop_back();
+    return b;
+  }
+
+  void return_batch(unsigned cls, Batch b) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    depot_[cls].push_back(b);
+  }
+
+  // Caller holds mutex_.
+  void carve_slab(unsigned cls) {
+    const size_t size = kClassSizes[cls];
+    auto *slab = static_cast<std::byte *>(::operator new(kSlabSize, std::align_val_t{kMaxAlign}));
+    slabs_.push_back(slab);
+
+    const size_t blocks = kSlabSize / size;
+    Batch batch;
+    for (size_t i = 0; i < blocks; ++i) {
+      auto *b = reinterpret_cast<FreeBlock *>(slab + i * size);
+      b->next = batch.head;
+      batch.head = b;
+      if (++batch.count == kBatchSize) {
+        depot_[cls].push_back(batch);
+        batch = {};
+      }
+    }
+    if (batch.count)
+      depot_[cls].push_back(batch);
+  }
+
+  mutable std::mutex mutex_;
+  std::array<std::vector<Batch>, kNumClasses> depot_;
+  std::vector<std::byte *> slabs_;
+};
+
+/// std::pmr view of the process-wide SlabPool.
+class SlabResource : public std::pmr::memory_resource {
+protected:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    return SlabPool::instance().allocate(bytes, alignment);
+  }
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+    SlabPool::instance().deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return dynamic_cast<const SlabResource *>(&other) != nullptr;
+  }
+};
+
+inline SlabResource *slab_resource() {
+  static SlabResource resource;
+  return &resource;
+}
+
+/// Stateless standard allocator over the process-wide SlabPool.
+template <typename T> class SlabAllocator {
+public:
+  using value_type = T;
+  using is_always_equal = std::true_type;
+
+  SlabAllocator() noexcept = default;
+  template <typename U> SlabAllocator(const SlabAllocator<U> &) noexcept {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(SlabPool::instance().allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *p, size_t n) noexcept {
+    SlabPool::instance().deallocate(p, n * sizeof(T), alignof(T));
+  }
+
+  template <typename U> bool operator==(const SlabAllocator<U> &) const noexcept { return true; }
+};
+
+} // end of namespace allocators
@@ -0,0 +1,130 @@
+#include "my_timer.h"
+#include "slab_pool.hpp"
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <list>
+#include <memory_resource>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+template <typename Alloc> using node_set = std::set<int, std::less<>, Alloc>;
+
+// Build and tear down a std::set of `n` random ints, like make_sorted_random
+// in future_test.cc.
+template <typename Alloc> size_t churn_set(size_t n, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<int> dis(0, static_cast<int>(n) - 1);
+  size_t total = 0;
+  for (int round = 0; round < 3; ++round) {
+    node_set<Alloc> s;
+    for (size_t i = 0; i < n; ++i)
+      s.insert(dis(gen));
+    total += s.size();
+  }
+  return total;
+}
+
+template <typename Alloc> uint64_t run_threads(unsigned threads, size_t n_per_thread) {
+  Timer T("set churn");
+  std::vector<std::thread> workers;
+  for (unsigned t = 0; t < threads; ++t)
+    workers.emplace_back([=] { churn_set<Alloc>(n_per_thread, t); });
+  for (auto &w : workers)
+    w.join();
+  return T.eclipse();
+}
+
+} // namespace
+
+TEST(slab_pool, size_classes) {
+  using allocators::SlabPool;
+  EXPECT_EQ(SlabPool::kClassSizes[SlabPool::size_class(1)], 8);
+  EXPECT_EQ(SlabPool::kClassSizes[SlabPool::size_class(8)], 8);
+  EXPECT_EQ(SlabPool::kClassSizes[SlabPool::size_class(9)], 16);
+  EXPECT_EQ(SlabPool::kClassSizes[SlabPool::size_class(40)], 48);
+  EXPECT_EQ(SlabPool::kClassSizes[SlabPool::size_class(200)], 256);
+  EXPECT_EQ(SlabPool::kClassSizes[SlabPool::size_class(512)], 512);
+  for (size_t bytes = 1; bytes <= SlabPool::kMaxSmallSize; ++bytes)
+    EXPECT_GE(SlabPool::kClassSizes[SlabPool::size_class(bytes)], bytes);
+}
+
+TEST(slab_pool, reuses_blocks_and_aligns) {
+  auto &pool = allocators::SlabPool::instance();
+  void *a = pool.allocate(24, 8);
+  pool.deallocate(a, 24, 8);
+  void *b = pool.allocate(30, 8); // same class: LIFO reuse
+  EXPECT_EQ(a, b);
+  pool.deallocate(b, 30, 8);
+
+  for (size_t bytes : {1ul, 8ul, 24ul, 100ul, 500ul}) {
+    void *p = pool.allocate(bytes, 16);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 16, 0);
+    pool.deallocate(p, bytes, 16);
+  }
+
+  // Over-aligned and large requests bypass the slabs.
+  void *big = pool.allocate(4096, 64);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(big) % 64, 0);
+  pool.deallocate(big, 4096, 64);
+}
+
+TEST(slab_pool, cross_thread_free) {
+  // Blocks freed by another thread migrate through the depot.
+  std::vector<void *> blocks;
+  std::thread producer([&] {
+    for (int i = 0; i < 10000; ++i)
+      blocks.push_back(allocators::SlabPool::instance().allocate(64));
+  });
+  producer.join();
+
+  std::thread consumer([&] {
+    for (void *p : blocks)
+      allocators::SlabPool::instance().deallocate(p, 64);
+  });
+  consumer.join();
+
+  const size_t slabs = allocators::SlabPool::instance().slab_count();
+  for (void *&p : blocks)
+    p = allocators::SlabPool::instance().allocate(64);
+  for (void *p : blocks)
+    allocators::SlabPool::instance().deallocate(p, 64);
+  EXPECT_EQ(allocators::SlabPool::instance().slab_count(), slabs);
+}
+
+TEST(slab_pool, containers) {
+  std::list<std::string, allocators::SlabAllocator<std::string>> names;
+  for (int i = 0; i < 1000; ++i)
+    names.push_back("person #" + std::to_string(i));
+  EXPECT_EQ(names.back(), "person #999");
+
+  std::pmr::unordered_set<int> ids{allocators::slab_resource()};
+  for (int i = 0; i < 1000; ++i)
+    ids.insert(i);
+  EXPECT_EQ(ids.size(), 1000);
+}
+
+TEST(slab_pool, node_container_benchmark) {
+  using heap = std::allocator<int>;
+  using slab = allocators::SlabAllocator<int>;
+  constexpr size_t n_single = 200000;
+  constexpr size_t n_multi = 20000;
+
+  auto heap_1 = run_threads<heap>(1, n_single);
+  auto slab_1 = run_threads<slab>(1, n_single);
+  auto heap_32 = run_threads<heap>(32, n_multi);
+  auto slab_32 = run_threads<slab>(32, n_multi);
+
+#ifndef NDEBUG
+  std::cout << "std::set churn, 1 thread:   malloc " << heap_1 / 1000000 << "ms, slab "
+            << slab_1 / 1000000 << "ms\n"
+            << "std::set churn, 32 threads: malloc " << heap_32 / 1000000 << "ms, slab "
+            << slab_32 / 1000000 << "ms\n";
+#endif
+}
@@ -0,0 +1,270 @@
+#pragma once
+
+// DESCRIPTION:
+//  An asynchronous log sink. Every producer thread appends its messages to a
+//  private, bounded single-producer/single-consumer ring, so the hot path is a
+//  memcpy plus one release store and never touches a shared lock. A background
+//  thread drains all rings into one batch and hands it to the kernel with a
+//  single write(2) per flush.
+//
+//  Memory is bounded by (number of live threads that have logged) x
+//  slots_per_thread x kMaxMessageSize: when a thread exits its ring is
+//  retired, and the flusher frees it once it has been drained.
+//  When a ring is full the configured OverflowPolicy decides what happens:
+//    * OverflowPolicy::Drop  - the message is discarded and counted.
+//    * OverflowPolicy::Block - the caller wakes the flusher and yields until a
+//                              slot becomes free.
+//  Messages longer than kMaxMessageSize are truncated.
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace async_logger {
+
+enum class OverflowPolicy { Drop, Block };
+
+struct LoggerOptions {
+  size_t slots_per_thread = 1024; // rounded up to a power of two
+  OverflowPolicy policy = OverflowPolicy::Block;
+  std::chrono::milliseconds flush_interval{1};
+};
+
+class AsyncLogger {
+public:
+  static constexpr size_t kMaxMessageSize = 248;
+
+  explicit AsyncLogger(int fd = STDOUT_FILENO, LoggerOptions options = {})
+      : fd_(fd), options_(options), id_(next_id()) {
+    flusher_ = std::thread([this] { run(); });
+  }
+
+  AsyncLogger(const AsyncLogger &) = delete;
+  AsyncLogger &operator=(const AsyncLogger &) = delete;
+
+  ~AsyncLogger() {
+    {
+      std::lock_guard<std::mutex> lock(wake_mutex_);
+      stop_ = true;
+    }
+    wake_.notify_one();
+    flusher_.join();
+    flush();
+
+    // Threads still running keep their cache entries for this logger; free
+    // the slots now and let them prune the empty shells.
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    for (auto &buf : buffers_)
+      buf->detach();
+  }
+
+  /// Append a message to the calling thread's ring. Returns false if the
+  /// message was dropped because of OverflowPolicy::Drop.
+  bool log(std::string_view msg) {
+    ThreadBuffer &buf = local_buffer();
+    if (buf.try_push(msg))
+      return true;
+
+    if (options_.policy == OverflowPolicy::Drop) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    do {
+      wake_.notify_one();
+      std::this_thread::yield();
+    } while (!buf.try_push(msg));
+    return true;
+  }
+
+  /// Drain every ring and write the batch out synchronously.
+  void flush() {
+    std::lock_guard<std::mutex> drain_lock(drain_mutex_);
+    batch_.clear();
+    size_t messages = 0;
+    {
+      std::lock_guard<std::mutex> lock(buffers_mutex_);
+      std::erase_if(buffers_, [&](const std::shared_ptr<ThreadBuffer> &buf) {
+        // Read before draining: once set, nothing more is pushed.
+        const bool orphaned = buf->orphaned.load(std::memory_order_acquire);
+        messages += buf->drain(batch_);
+        return orphaned;
+      });
+    }
+    if (batch_.empty())
+      return;
+
+    write_all(batch_.data(), batch_.size());
+    written_.fetch_add(messages, std::memory_order_relaxed);
+    flushes_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] uint64_t written_messages() const { return written_.load(); }
+  [[nodiscard]] uint64_t dropped_messages() const { return dropped_.load(); }
+  [[nodiscard]] uint64_t flush_count() const { return flushes_.load(); }
+
+  /// Rings currently held: one per thread that has logged and not yet
+  /// been seen to exit by a flush.
+  [[nodiscard]] size_t ring_count() const {
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    return buffers_.size();
+  }
+
+private:
+  struct Slot {
+    uint32_t length;
+    char data[kMaxMessageSize];
+  };
+
+  class ThreadBuffer {
+  public:
+    explicit ThreadBuffer(size_t slots)
+        : mask_(std::bit_ceil(std::max<size_t>(slots, 2)) - 1),
+          slots_(std::make_unique<Slot[]>(mask_ + 1)) {}
+
+    // Producer side, only ever called by the owning thread.
+    bool try_push(std::string_view msg) {
+      const size_t tail = tail_.load(std::memory_order_relaxed);
+      if (tail - head_cache_ > mask_) {
+        head_cache_ = head_.load(std::memory_order_acquire);
+        if (tail - head_cache_ > mask_)
+          return false;
+      }
+      Slot &slot = slots_[tail & mask_];
+      slot.length = static_cast<uint32_t>(std::min(msg.size(), kMaxMessageSize));
+      std::memcpy(slot.data, msg.data(), slot.length);
+      tail_.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+    // Consumer side, serialized by AsyncLogger::drain_mutex_.
+    size_t drain(std::string &out) {
+      size_t head = head_.load(std::memory_order_relaxed);
+      const size_t tail = tail_.load(std::memory_order_acquire);
+      const size_t count = tail - head;
+      for (; head != tail; ++head) {
+        const Slot &slot = slots_[head & mask_];
+        out.append(slot.data, slot.length);
+      }
+      head_.store(head, std::memory_order_release);
+      return count;
+    }
+
+    /// The logger is going away: free the slots, keep the shell for the
+    /// owning thread's cache to find and drop.
+    void detach() {
+      slots_.reset();
+      logger_alive.store(false, std::memory_order_release);
+    }
+
+    std::atomic<bool> orphaned{false};    // the owning thread has exited
+    std::atomic<bool> logger_alive{true}; // the logger has not been destroyed
+
+  private:
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t head_cache_ = 0;
+  };
+
+  static uint64_t next_id() {
+    static std::atomic<uint64_t> counter{0};
+    return ++counter;
+  }
+
+  /// This thread's rings, one per logger it has used. On thread exit each
+  /// is marked orphaned, so the logger can drain and free it.
+  struct LocalBuffers {
+    std::vector<std::pair<uint64_t, std::shared_ptr<ThreadBuffer>>> entries;
+
+    ~LocalBuffers() {
+      for (auto &[id, buf] : entries)
+        buf->orphaned.store(true, std::memory_order_release);
+    }
+  };
+
+  ThreadBuffer &local_buffer() {
+    // A thread may log to several loggers, so cache one ring per logger id.
+    // Ids are never reused.
+    thread_local LocalBuffers cache;
+    for (auto &[id, buf] : cache.entries)
+      if (id == id_)
+        return *buf;
+
+    // Drop the entries of loggers destroyed since.
+    std::erase_if(cache.entries, [](const auto &entry) {
+      return !entry.second->logger_alive.load(std::memory_order_acquire);
+    });
+    auto buf = std::make_shared<ThreadBuffer>(options_.slots_per_thread);
+    {
+      std::lock_guard<std::mutex> lock(buffers_mutex_);
+      buffers_.push_back(buf);
+    }
+    cache.entries.emplace_back(id_, buf);
+    return *buf;
+  }
+
+  void write_all(const char *data, size_t size) const {
+    while (size > 0) {
+      ssize_t n = ::write(fd_, data, size);
+      if (n < 0) {
+        if (errno == EINTR)
+          continue;
+        return; // nowhere left to report the failure.
+      }
+      data += n;
+      size -= static_cast<size_t>(n);
+    }
+  }
+
+  void run() {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    while (!stop_) {
+      wake_.wait_for(lock, options_.flush_interval);
+      lock.unlock();
+      flush();
+      lock.lock();
+    }
+  }
+
+  const int fd_;
+  const LoggerOptions options_;
+  const uint64_t id_;
+
+  mutable std::mutex buffers_mutex_;
+  // Shared with the owning thread's cache; either may let go first.
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+
+  std::mutex drain_mutex_;
+  std::string batch_;
+
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+  std::thread flusher_;
+
+  std::atomic<uint64_t> written_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<uint64_t> flushes_{0};
+};
+
+/// Process-wide logger writing to standard output.
+inline AsyncLogger &stdout_logger() {
+  static AsyncLogger logger{STDOUT_FILENO};
+  return logger;
+}
+
+} // end of namespace async_logger
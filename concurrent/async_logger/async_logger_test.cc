@@ -0,0 +1,220 @@
+#include "async_logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::string read_all(FILE *file) {
+  std::fflush(file);
+  std::rewind(file);
+  std::string content;
+  char buf[4096];
+  size_t n;
+  while ((n = std::fread(buf, 1, sizeof(buf), file)) > 0)
+    content.append(buf, n);
+  return content;
+}
+
+// The original sink from latches.cc / barrier_test.cc: one global mutex and a
+// synchronous write per message.
+std::mutex out_mutex;
+
+void synchronized_out(int fd, const std::string &s) {
+  std::lock_guard<std::mutex> lo(out_mutex);
+  [[maybe_unused]] auto n = ::write(fd, s.data(), s.size());
+}
+
+template <typename LogFn>
+std::vector<uint64_t> measure_log_latency(unsigned num_threads, unsigned msgs_per_thread,
+                                          LogFn log_fn) {
+  std::vector<std::vector<uint64_t>> samples(num_threads);
+  std::vector<std::thread> workers;
+  workers.reserve(num_threads);
+
+  for (unsigned t = 0; t < num_threads; ++t) {
+    workers.emplace_back([t, msgs_per_thread, &samples, &log_fn] {
+      auto &out = samples[t];
+      out.reserve(msgs_per_thread);
+      std::string msg = "worker " + std::to_string(t) + ": Work done!\n";
+      for (unsigned i = 0; i < msgs_per_thread; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        log_fn(msg);
+        auto stop = std::chrono::steady_clock::now();
+        out.push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+      }
+    });
+  }
+  for (auto &w : workers)
+    w.join();
+
+  std::vector<uint64_t> all;
+  for (auto &s : samples)
+    all.insert(all.end(), s.begin(), s.end());
+  std::sort(all.begin(), all.end());
+  return all;
+}
+
+uint64_t percentile(const std::vector<uint64_t> &sorted, double p) {
+  return sorted[static_cast<size_t>(p * static_cast<double>(sorted.size() - 1))];
+}
+
+} // namespace
+
+TEST(async_logger, keeps_per_thread_order) {
+  using namespace async_logger;
+  FILE *file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+
+  constexpr unsigned num_threads = 4;
+  constexpr unsigned msgs_per_thread = 5000;
+  {
+    AsyncLogger logger{fileno(file), {.slots_per_thread = 64}};
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < num_threads; ++t)
+      workers.emplace_back([t, &logger] {
+        for (unsigned i = 0; i < msgs_per_thread; ++i)
+          logger.log(std::to_string(t) + " " + std::to_string(i) + "\n");
+      });
+    for (auto &w : workers)
+      w.join();
+    logger.flush();
+
+    EXPECT_EQ(logger.written_messages(), num_threads * msgs_per_thread);
+    EXPECT_EQ(logger.dropped_messages(), 0);
+  }
+
+  std::istringstream lines{read_all(file)};
+  std::map<unsigned, unsigned> next;
+  unsigned t, i, total = 0;
+  while (lines >> t >> i) {
+    EXPECT_EQ(next[t], i);
+    next[t] = i + 1;
+    ++total;
+  }
+  EXPECT_EQ(total, num_threads * msgs_per_thread);
+  std::fclose(file);
+}
+
+TEST(async_logger, drop_policy_is_bounded) {
+  using namespace async_logger;
+  FILE *file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+
+  // The flusher never wakes up on its own, so only 4 slots are available.
+  AsyncLogger logger{fileno(file),
+                     {.slots_per_thread = 4,
+                      .policy = OverflowPolicy::Drop,
+                      .flush_interval = std::chrono::hours{1}}};
+
+  unsigned accepted = 0;
+  for (unsigned i = 0; i < 100; ++i)
+    accepted += logger.log("x\n");
+  logger.flush();
+
+  EXPECT_EQ(accepted, 4);
+  EXPECT_EQ(logger.written_messages(), 4);
+  EXPECT_EQ(logger.dropped_messages(), 96);
+  EXPECT_EQ(read_all(file), "x\nx\nx\nx\n");
+  std::fclose(file);
+}
+
+TEST(async_logger, block_policy_loses_nothing) {
+  using namespace async_logger;
+  FILE *file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+
+  AsyncLogger logger{fileno(file),
+                     {.slots_per_thread = 4, .policy = OverflowPolicy::Block}};
+  for (unsigned i = 0; i < 1000; ++i)
+    EXPECT_TRUE(logger.log("y"));
+  logger.flush();
+
+  EXPECT_EQ(logger.written_messages(), 1000);
+  EXPECT_EQ(read_all(file), std::string(1000, 'y'));
+  EXPECT_LT(logger.flush_count(), 1000);
+  std::fclose(file);
+}
+
+TEST(async_logger, rings_of_exited_threads_are_freed) {
+  using namespace async_logger;
+  FILE *file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+
+  AsyncLogger logger{fileno(file), {.flush_interval = std::chrono::hours{1}}};
+  constexpr unsigned threads = 100;
+  for (unsigned t = 0; t < threads; ++t) {
+    std::thread([&] { logger.log("m\n"); }).join();
+    logger.flush(); // drains the exited thread's ring and frees it
+    EXPECT_EQ(logger.ring_count(), 0);
+  }
+  logger.log("main\n"); // a live thread keeps its ring
+  logger.flush();
+  EXPECT_EQ(logger.ring_count(), 1);
+  EXPECT_EQ(logger.written_messages(), threads + 1);
+
+  // A thread outliving a logger drops the stale entry and logs to a new one.
+  std::thread([&] {
+    {
+      AsyncLogger first{fileno(file)};
+      first.log("first\n");
+    }
+    AsyncLogger second{fileno(file)};
+    EXPECT_TRUE(second.log("second\n"));
+  }).join();
+  const std::string content = read_all(file);
+  EXPECT_EQ(std::count(content.begin(), content.end(), '\n'), threads + 3);
+  std::fclose(file);
+}
+
+TEST(async_logger, truncates_long_messages) {
+  using namespace async_logger;
+  FILE *file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+  {
+    AsyncLogger logger{fileno(file)};
+    logger.log(std::string(AsyncLogger::kMaxMessageSize + 10, 'z'));
+  }
+  EXPECT_EQ(read_all(file), std::string(AsyncLogger::kMaxMessageSize, 'z'));
+  std::fclose(file);
+}
+
+TEST(async_logger, p99_latency_vs_mutex) {
+  using namespace async_logger;
+  int devnull = ::open("/dev/null", O_WRONLY);
+  ASSERT_GE(devnull, 0);
+
+  constexpr unsigned num_threads = 4;
+  constexpr unsigned msgs_per_thread = 50000;
+
+  auto mutex_samples = measure_log_latency(
+      num_threads, msgs_per_thread, [devnull](const std::string &s) { synchronized_out(devnull, s); });
+
+  std::vector<uint64_t> async_samples;
+  {
+    AsyncLogger logger{devnull, {.slots_per_thread = 4096}};
+    async_samples = measure_log_latency(num_threads, msgs_per_thread,
+                                        [&logger](const std::string &s) { logger.log(s); });
+  }
+
+  EXPECT_EQ(mutex_samples.size(), async_samples.size());
+
+#ifndef NDEBUG
+  std::cout << "mutex + write(2): p50 = " << percentile(mutex_samples, 0.50)
+            << "ns, p99 = " << percentile(mutex_samples, 0.99) << "ns\n"
+            << "async logger:     p50 = " << percentile(async_samples, 0.50)
+            << "ns, p99 = " << percentile(async_samples, 0.99) << "ns\n";
+#endif
+
+  ::close(devnull);
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+// DESCRIPTION:
+//  Parallel histogram and scatter-add kernels over plain arrays.
+//
+//  Two strategies are provided:
+//    * Strategy::atomic     - every thread updates the shared output in place
+//                             through std::atomic_ref, so the output stays an
+//                             ordinary array and needs no extra memory. Fast
+//                             when updates are spread over many bins.
+//    * Strategy::privatized - every thread accumulates into its own copy of
+//                             the bins with plain adds, then the copies are
+//                             merged in parallel. Fast when there are few bins
+//                             and threads would fight over the same cache
+//                             lines.
+//  Strategy::automatic picks privatized when the private copies are small
+//  enough to stay in cache and there are enough updates per bin to pay for the
+//  merge, and atomic otherwise.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace histogram {
+
+enum class Strategy { automatic, atomic, privatized };
+
+/// Total size of all private bin copies that still counts as "small".
+inline constexpr size_t kPrivateBudgetBytes = size_t{1} << 20;
+
+/// Resolve Strategy::automatic for `n` updates into `bins` bins of `elem_size`
+/// bytes spread over `threads` threads.
+inline Strategy choose_strategy(size_t n, size_t bins, size_t elem_size, unsigned threads) {
+  if (threads <= 1)
+    return Strategy::privatized; // a single private copy is the output itself
+  const bool fits = bins * elem_size * threads <= kPrivateBudgetBytes;
+  const bool contended = n >= bins * threads;
+  return fits && contended ? Strategy::privatized : Strategy::atomic;
+}
+
+namespace detail {
+
+inline unsigned default_threads() { return std::max(1u, std::thread::hardware_concurrency()); }
+
+/// Run body(t, begin, end) on `threads` threads over [0, n).
+template <typename Body> void parallel_for(size_t n, unsigned threads, Body body) {
+  if (threads <= 1 || n == 0) {
+    body(0u, size_t{0}, n);
+    return;
+  }
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  const size_t chunk = (n + threads - 1) / threads;
+  for (unsigned t = 1; t < threads; ++t) {
+    const size_t begin = std::min(n, t * chunk);
+    const size_t end = std::min(n, begin + chunk);
+    workers.emplace_back([=, &body] { body(t, begin, end); });
+  }
+  body(0u, 0, std::min(n, chunk));
+  for (auto &w : workers)
+    w.join();
+}
+
+/// Accumulate `update(t, begin, end, bins)` into `out`, using either
+/// atomic_ref on `out` directly or per-thread copies plus a merge.
+template <typename T, typename Update>
+void accumulate(std::span<T> out, size_t n, unsigned threads, Strategy strategy, Update update) {
+  static_assert(std::is_arithmetic_v<T>, "bins must be an arithmetic type");
+  if (strategy == Strategy::automatic)
+    strategy = choose_strategy(n, out.size(), sizeof(T), threads);
+
+  if (threads <= 1) {
+    update(0u, size_t{0}, n, [&out](size_t bin, T v) { out[bin] += v; });
+    return;
+  }
+
+  if (strategy == Strategy::atomic) {
+    parallel_for(n, threads, [&](unsigned t, size_t begin, size_t end) {
+      update(t, begin, end, [&out](size_t bin, T v) {
+        std::atomic_ref<T>(out[bin]).fetch_add(v, std::memory_order_relaxed);
+      });
+    });
+    return;
+  }
+
+  // Pad every private copy to whole cache lines so neighbours don't share.
+  constexpr size_t line = 64 / sizeof(T) ? 64 / sizeof(T) : 1;
+  const size_t stride = (out.size() + line - 1) / line * line;
+  std::vector<T> priv(stride * threads, T{});
+
+  parallel_for(n, threads, [&](unsigned t, size_t begin, size_t end) {
+    T *mine = priv.data() + t * stride;
+    update(t, begin, end, [mine](size_t bin, T v) { mine[bin] += v; });
+  });
+
+  // Merge bin ranges in parallel; every output bin is written by one thread.
+  parallel_for(out.size(), threads, [&](unsigned, size_t begin, size_t end) {
+    for (unsigned t = 0; t < threads; ++t) {
+      const T *theirs = priv.data() + t * stride;
+      for (size_t b = begin; b < end; ++b)
+        out[b] += theirs[b];
+    }
+  });
+}
+
+} // namespace detail
+
+/// Count, for every element of `input`, one hit in `bins[bin_of(x)]`.
+/// `bins` is not cleared first, so repeated calls accumulate.
+template <typename In, typename Count, typename BinOf>
+void parallel_histogram(std::span<const In> input, std::span<Count> bins, BinOf bin_of,
+                        Strategy strategy = Strategy::automatic,
+                        unsigned threads = detail::default_threads()) {
+  detail::accumulate(bins, input.size(), threads, strategy,
+                     [&](unsigned, size_t begin, size_t end, auto add) {
+                       for (size_t i = begin; i < end; ++i)
+                         add(static_cast<size_t>(bin_of(input[i])), Count{1});
+                     });
+}
+
+/// out[index[i]] += values[i] for every i.
+template <typename Index, typename T>
+void scatter_add(std::span<const Index> index, std::span<const T> values, std::span<T> out,
+                 Strategy strategy = Strategy::automatic,
+                 unsigned threads = detail::default_threads()) {
+  const size_t n = std::min(index.size(), values.size());
+  detail::accumulate(out, n, threads, strategy,
+                     [&](unsigned, size_t begin, size_t end, auto add) {
+                       for (size_t i = begin; i < end; ++i)
+                         add(static_cast<size_t>(index[i]), values[i]);
+                     });
+}
+
+} // end of namespace histogram
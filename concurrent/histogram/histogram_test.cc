@@ -0,0 +1,109 @@
+#include "histogram.h"
+#include "my_timer.h"
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+
+std::vector<uint32_t> make_keys(size_t n, uint32_t max_key) {
+  std::mt19937 gen(1234);
+  std::uniform_int_distribution<uint32_t> dis(0, max_key - 1);
+  std::vector<uint32_t> keys(n);
+  for (auto &k : keys)
+    k = dis(gen);
+  return keys;
+}
+
+std::vector<uint64_t> reference_histogram(const std::vector<uint32_t> &keys, size_t bins) {
+  std::vector<uint64_t> out(bins);
+  for (auto k : keys)
+    ++out[k];
+  return out;
+}
+
+} // namespace
+
+TEST(histogram, strategies_agree) {
+  using namespace histogram;
+  for (size_t num_bins : {1ul, 3ul, 256ul, 100000ul}) {
+    auto keys = make_keys(200000, static_cast<uint32_t>(num_bins));
+    auto expected = reference_histogram(keys, num_bins);
+
+    for (auto strategy : {Strategy::atomic, Strategy::privatized, Strategy::automatic}) {
+      for (unsigned threads : {1u, 3u, 8u}) {
+        std::vector<uint64_t> bins(num_bins);
+        parallel_histogram(std::span<const uint32_t>(keys), std::span<uint64_t>(bins),
+                           [](uint32_t k) { return k; }, strategy, threads);
+        EXPECT_EQ(bins, expected) << "bins=" << num_bins << " threads=" << threads;
+      }
+    }
+  }
+}
+
+TEST(histogram, scatter_add_doubles) {
+  using namespace histogram;
+  constexpr size_t n = 100000;
+  constexpr size_t num_bins = 17;
+  auto index = make_keys(n, num_bins);
+  std::vector<double> values(n);
+  std::iota(values.begin(), values.end(), 0.0);
+
+  std::vector<double> expected(num_bins);
+  for (size_t i = 0; i < n; ++i)
+    expected[index[i]] += values[i];
+
+  for (auto strategy : {Strategy::atomic, Strategy::privatized}) {
+    std::vector<double> out(num_bins);
+    scatter_add(std::span<const uint32_t>(index), std::span<const double>(values),
+                std::span<double>(out), strategy, 4);
+    for (size_t b = 0; b < num_bins; ++b)
+      EXPECT_DOUBLE_EQ(out[b], expected[b]);
+  }
+}
+
+TEST(histogram, automatic_strategy_choice) {
+  using namespace histogram;
+  // Few bins, many updates: privatize.
+  EXPECT_EQ(choose_strategy(1 << 24, 256, sizeof(uint64_t), 8), Strategy::privatized);
+  // Private copies would blow the cache budget: update in place.
+  EXPECT_EQ(choose_strategy(1 << 24, 1 << 20, sizeof(uint64_t), 8), Strategy::atomic);
+  // Too few updates per bin to pay for the merge.
+  EXPECT_EQ(choose_strategy(1000, 4096, sizeof(uint32_t), 8), Strategy::atomic);
+}
+
+TEST(histogram, benchmark_bin_counts) {
+  using namespace histogram;
+  constexpr size_t n = 1 << 22;
+  constexpr unsigned threads = 4;
+
+  for (size_t num_bins : {4ul, 64ul, 1024ul, 16384ul, 262144ul, 4194304ul}) {
+    auto keys = make_keys(n, static_cast<uint32_t>(num_bins));
+    uint64_t atomic_time, privatized_time, auto_time;
+    std::vector<uint64_t> bins(num_bins);
+
+    auto run = [&](Strategy s) {
+      std::fill(bins.begin(), bins.end(), 0);
+      Timer T("histogram");
+      parallel_histogram(std::span<const uint32_t>(keys), std::span<uint64_t>(bins),
+                         [](uint32_t k) { return k; }, s, threads);
+      return T.eclipse();
+    };
+    atomic_time = run(Strategy::atomic);
+    privatized_time = run(Strategy::privatized);
+    auto_time = run(Strategy::automatic);
+    EXPECT_EQ(std::accumulate(bins.begin(), bins.end(), uint64_t{0}), n);
+
+#ifndef NDEBUG
+    std::cout << "bins=" << num_bins << " atomic_ref: " << atomic_time / 1000
+              << "us, privatized: " << privatized_time / 1000 << "us, automatic("
+              << (choose_strategy(n, num_bins, sizeof(uint64_t), threads) == Strategy::atomic
+                      ? "atomic"
+                      : "privatized")
+              << "): " << auto_time / 1000 << "us\n";
+#endif
+  }
+}
@@ -0,0 +1,398 @@
+#pragma once
+
+// DESCRIPTION:
+//  A multi-stage pipeline in the spirit of TBB's parallel_pipeline, generalizing
+//  the two-stage ProducerConsumer example. A source produces items, and every
+//  following stage runs in one of three modes:
+//    * StageMode::serial_in_order     - one worker, items in source order.
+//    * StageMode::serial_out_of_order - one worker, items in arrival order.
+//    * StageMode::parallel            - several workers at once.
+//  Stages are linked by bounded queues, so a slow stage applies backpressure to
+//  everything before it. On top of that, at most `max_tokens` items are in
+//  flight between the source and the end of the last stage.
+//
+//  run() returns per-stage statistics (busy time, utilization, queue depth) so
+//  the bottleneck stage can be found without a profiler. Items travel between
+//  stages in a std::any, so every item type must be copy constructible.
+//
+//  Usage:
+//    auto stats = pipeline::Pipeline{16}
+//                     .source<std::string>("read", read_line)
+//                     .stage("parse", StageMode::parallel, parse, 4)
+//                     .stage("write", StageMode::serial_in_order, write)
+//                     .run();
+
+#include <algorithm>
+#include <any>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pipeline {
+
+enum class StageMode { serial_in_order, serial_out_of_order, parallel };
+
+inline const char *to_string(StageMode mode) {
+  switch (mode) {
+  case StageMode::serial_in_order:
+    return "serial_in_order";
+  case StageMode::serial_out_of_order:
+    return "serial_out_of_order";
+  case StageMode::parallel:
+    return "parallel";
+  }
+  return "unknown";
+}
+
+struct StageStats {
+  std::string name;
+  StageMode mode;
+  unsigned workers = 0;
+  uint64_t items = 0;
+  std::chrono::nanoseconds busy{0};
+  double utilization = 0.0;     // busy / (wall time * workers)
+  double avg_queue_depth = 0.0; // input queue depth, sampled on every push
+  size_t max_queue_depth = 0;
+};
+
+struct PipelineStats {
+  std::chrono::nanoseconds wall{0};
+  uint64_t items = 0;
+  std::vector<StageStats> stages; // stages[0] is the source
+
+  /// Index of the stage with the highest utilization.
+  [[nodiscard]] size_t bottleneck() const {
+    size_t idx = 0;
+    for (size_t i = 1; i < stages.size(); ++i)
+      if (stages[i].utilization > stages[idx].utilization)
+        idx = i;
+    return idx;
+  }
+
+  friend std::ostream &operator<<(std::ostream &os, const PipelineStats &stats) {
+    // Put the caller's formatting back afterwards; std::left etc. are sticky.
+    const auto flags = os.flags();
+    const auto precision = os.precision();
+    os << "pipeline: " << stats.items << " items in "
+       << std::chrono::duration<double, std::milli>(stats.wall).count() << "ms\n";
+    for (size_t i = 0; i < stats.stages.size(); ++i) {
+      const auto &s = stats.stages[i];
+      os << (i == stats.bottleneck() ? " * " : "   ") << std::left << std::setw(12) << s.name
+         << std::setw(20) << to_string(s.mode) << "workers=" << s.workers
+         << " util=" << std::fixed << std::setprecision(2) << s.utilization
+         << " queue(avg/max)=" << s.avg_queue_depth << '/' << s.max_queue_depth << '\n';
+    }
+    os.flags(flags);
+    os.precision(precision);
+    return os;
+  }
+};
+
+/// Blocking bounded FIFO, the same mutex + condition_variable scheme as
+/// producer_consumer::ProducerConsumer, plus close() and depth sampling.
+template <typename T> class BoundedQueue {
+public:
+  explicit BoundedQueue(size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {}
+
+  void push(T value) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this] { return queue_.size() < capacity_; });
+    queue_.push_back(std::move(value));
+    depth_sum_ += queue_.size();
+    ++pushes_;
+    max_depth_ = std::max(max_depth_, queue_.size());
+    lock.unlock();
+    not_empty_.notify_one();
+  }
+
+  /// Blocks until an element is available; returns nullopt once the queue
+  /// is closed and drained.
+  std::optional<T> pop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this] { return !queue_.empty() || closed_; });
+    if (queue_.empty())
+      return std::nullopt;
+    T value = std::move(queue_.front());
+    queue_.pop_front();
+    lock.unlock();
+    not_full_.notify_one();
+    return value;
+  }
+
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+    not_empty_.notify_all();
+  }
+
+  [[nodiscard]] double avg_depth() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pushes_ ? static_cast<double>(depth_sum_) / static_cast<double>(pushes_) : 0.0;
+  }
+
+  [[nodiscard]] size_t max_depth() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return max_depth_;
+  }
+
+private:
+  const size_t capacity_;
+  mutable std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  std::deque<T> queue_;
+  bool closed_ = false;
+  uint64_t depth_sum_ = 0;
+  uint64_t pushes_ = 0;
+  size_t max_depth_ = 0;
+};
+
+template <typename T> class Builder;
+
+class Pipeline {
+public:
+  explicit Pipeline(size_t max_tokens = 2 * std::thread::hardware_concurrency(),
+                    size_t queue_capacity = 0)
+      : max_tokens_(std::max<size_t>(max_tokens, 1)),
+        queue_capacity_(queue_capacity ? queue_capacity : max_tokens_) {}
+
+  /// First stage: `gen` is called serially until it returns std::nullopt.
+  template <typename T, typename Gen> Builder<T> source(std::string name, Gen gen);
+
+  PipelineStats run();
+
+private:
+  template <typename T> friend class Builder;
+
+  struct Item {
+    uint64_t seq;
+    std::any value;
+  };
+
+  struct Stage {
+    std::string name;
+    StageMode mode;
+    unsigned workers;
+    std::function<std::any(std::any &&)> fn; // empty for the source
+    std::function<std::optional<std::any>()> gen;
+  };
+
+  // State shared by the threads of one run().
+  struct RunState {
+    explicit RunState(size_t max_tokens) : tokens(static_cast<std::ptrdiff_t>(max_tokens)) {}
+
+    void fail(std::exception_ptr e) {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error)
+        error = std::move(e);
+      aborted = true;
+    }
+
+    std::counting_semaphore<> tokens;
+    std::atomic<bool> aborted{false};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+  };
+
+  void worker_loop(size_t idx, RunState &state, BoundedQueue<Item> &in, BoundedQueue<Item> *out,
+                   std::atomic<int64_t> &busy_ns, std::atomic<uint64_t> &items) const;
+
+  size_t max_tokens_;
+  size_t queue_capacity_;
+  std::vector<Stage> stages_;
+};
+
+/// Typed builder: each stage's input type is the previous stage's output
+/// type, so mismatched stages fail to compile.
+template <typename T> class Builder {
+public:
+  /// Append a stage. If `fn` returns void the stage is the sink and the
+  /// finished Pipeline is returned, otherwise a Builder for the result type.
+  template <typename F>
+  auto stage(std::string name, StageMode mode, F fn,
+             unsigned workers = std::thread::hardware_concurrency()) {
+    using U = std::invoke_result_t<F &, T &&>;
+    if (mode != StageMode::parallel)
+      workers = 1;
+
+    Pipeline::Stage s{std::move(name), mode, std::max(workers, 1u), nullptr, nullptr};
+    if constexpr (std::is_void_v<U>) {
+      s.fn = [fn = std::move(fn)](std::any &&in) mutable -> std::any {
+        fn(std::any_cast<T &&>(std::move(in)));
+        return {};
+      };
+      pipeline_.stages_.push_back(std::move(s));
+      return std::move(pipeline_);
+    } else {
+      s.fn = [fn = std::move(fn)](std::any &&in) mutable -> std::any {
+        return fn(std::any_cast<T &&>(std::move(in)));
+      };
+      pipeline_.stages_.push_back(std::move(s));
+      return Builder<U>{std::move(pipeline_)};
+    }
+  }
+
+private:
+  friend class Pipeline;
+  template <typename> friend class Builder;
+
+  explicit Builder(Pipeline &&p) : pipeline_(std::move(p)) {}
+
+  Pipeline pipeline_;
+};
+
+template <typename T, typename Gen> Builder<T> Pipeline::source(std::string name, Gen gen) {
+  Stage s{std::move(name), StageMode::serial_in_order, 1, nullptr, nullptr};
+  s.gen = [gen = std::move(gen)]() mutable -> std::optional<std::any> {
+    std::optional<T> v = gen();
+    if (!v)
+      return std::nullopt;
+    return std::any{std::move(*v)};
+  };
+  stages_.clear();
+  stages_.push_back(std::move(s));
+  return Builder<T>{std::move(*this)};
+}
+
+inline void Pipeline::worker_loop(size_t idx, RunState &state, BoundedQueue<Item> &in,
+                                  BoundedQueue<Item> *out, std::atomic<int64_t> &busy_ns,
+                                  std::atomic<uint64_t> &items) const {
+  const Stage &stage = stages_[idx];
+  uint64_t next_seq = 0;
+  std::map<uint64_t, std::any> reorder; // serial_in_order only, bounded by max_tokens_
+
+  auto process = [&](uint64_t seq, std::any &&value) {
+    if (state.aborted) {
+      state.tokens.release();
+      return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::any result;
+    try {
+      result = stage.fn(std::move(value));
+    } catch (...) {
+      state.fail(std::current_exception());
+    }
+    busy_ns += (std::chrono::steady_clock::now() - start).count();
+    ++items;
+
+    if (out && !state.aborted)
+      out->push(Item{seq, std::move(result)});
+    else
+      state.tokens.release();
+  };
+
+  while (auto item = in.pop()) {
+    // After a failure upstream stages drop items, so sequence numbers may
+    // have gaps; stop reordering and let everything drain.
+    if (stage.mode != StageMode::serial_in_order || state.aborted) {
+      for (auto &[seq, value] : reorder)
+        process(seq, std::move(value));
+      reorder.clear();
+      process(item->seq, std::move(item->value));
+      continue;
+    }
+    reorder.emplace(item->seq, std::move(item->value));
+    for (auto it = reorder.begin(); it != reorder.end() && it->first == next_seq;
+         it = reorder.erase(it), ++next_seq)
+      process(it->first, std::move(it->second));
+  }
+}
+
+inline PipelineStats Pipeline::run() {
+  const size_t n = stages_.size();
+  RunState state{max_tokens_};
+
+  // queues[i] feeds stage i + 1.
+  std::vector<std::unique_ptr<BoundedQueue<Item>>> queues;
+  for (size_t i = 0; i + 1 < n; ++i)
+    queues.push_back(std::make_unique<BoundedQueue<Item>>(queue_capacity_));
+  std::vector<std::atomic<int64_t>> busy_ns(n);
+  std::vector<std::atomic<uint64_t>> items(n);
+  std::vector<std::atomic<unsigned>> running(n);
+
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < n; ++i) {
+    running[i] = stages_[i].workers;
+    for (unsigned w = 0; w < stages_[i].workers; ++w) {
+      threads.emplace_back([&, i] {
+        BoundedQueue<Item> *out = i + 1 < n ? queues[i].get() : nullptr;
+        worker_loop(i, state, *queues[i - 1], out, busy_ns[i], items[i]);
+        // The last worker of a stage to finish closes the next queue.
+        if (--running[i] == 0 && out)
+          out->close();
+      });
+    }
+  }
+
+  // The source runs on the calling thread.
+  for (uint64_t seq = 0; !state.aborted; ++seq) {
+    state.tokens.acquire();
+    auto t0 = std::chrono::steady_clock::now();
+    std::optional<std::any> value;
+    try {
+      value = stages_[0].gen();
+    } catch (...) {
+      state.fail(std::current_exception());
+    }
+    busy_ns[0] += (std::chrono::steady_clock::now() - t0).count();
+    if (!value) {
+      state.tokens.release();
+      break;
+    }
+    ++items[0];
+    if (queues.empty())
+      state.tokens.release();
+    else
+      queues[0]->push(Item{seq, std::move(*value)});
+  }
+  if (!queues.empty())
+    queues[0]->close();
+
+  for (auto &t : threads)
+    t.join();
+
+  PipelineStats stats;
+  stats.wall = std::chrono::steady_clock::now() - start;
+  stats.items = items[0];
+  const double wall_ns = static_cast<double>(stats.wall.count());
+  for (size_t i = 0; i < n; ++i) {
+    StageStats s;
+    s.name = stages_[i].name;
+    s.mode = stages_[i].mode;
+    s.workers = stages_[i].workers;
+    s.items = items[i];
+    s.busy = std::chrono::nanoseconds{busy_ns[i].load()};
+    s.utilization = wall_ns > 0 ? static_cast<double>(s.busy.count()) / (wall_ns * s.workers) : 0;
+    if (i > 0) {
+      s.avg_queue_depth = queues[i - 1]->avg_depth();
+      s.max_queue_depth = queues[i - 1]->max_depth();
+    }
+    stats.stages.push_back(std::move(s));
+  }
+
+  if (state.error)
+    std::rethrow_exception(state.error);
+  return stats;
+}
+
+} // end of namespace pipeline
@@ -0,0 +1,168 @@
+#include "pipeline.h"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Record {
+  std::string key;
+  long value;
+};
+
+// Lines of the form "key,value".
+std::vector<std::string> make_lines(size_t n) {
+  std::vector<std::string> lines;
+  lines.reserve(n);
+  for (size_t i = 0; i < n; ++i)
+    lines.push_back("key" + std::to_string(i % 7) + "," + std::to_string(i));
+  return lines;
+}
+
+} // namespace
+
+TEST(pipeline, parse_transform_aggregate_write) {
+  using namespace pipeline;
+  const auto lines = make_lines(10000);
+
+  size_t next = 0;
+  long sum = 0;
+  std::vector<long> written;
+
+  auto stats = Pipeline{8}
+                   .source<std::string>("read",
+                                        [&]() -> std::optional<std::string> {
+                                          if (next == lines.size())
+                                            return std::nullopt;
+                                          return lines[next++];
+                                        })
+                   .stage("parse", StageMode::parallel,
+                          [](std::string &&line) {
+                            auto comma = line.find(',');
+                            return Record{line.substr(0, comma), std::stol(line.substr(comma + 1))};
+                          })
+                   .stage("transform", StageMode::parallel,
+                          [](Record &&r) {
+                            r.value *= 2;
+                            return r;
+                          })
+                   .stage("aggregate", StageMode::serial_out_of_order,
+                          [&sum](Record &&r) {
+                            sum += r.value;
+                            return r.value;
+                          })
+                   .stage("write", StageMode::serial_in_order,
+                          [&written](long &&v) { written.push_back(v); })
+                   .run();
+
+  ASSERT_EQ(written.size(), lines.size());
+  for (size_t i = 0; i < written.size(); ++i)
+    EXPECT_EQ(written[i], 2 * static_cast<long>(i));
+  EXPECT_EQ(sum, static_cast<long>(lines.size() * (lines.size() - 1)));
+
+  ASSERT_EQ(stats.stages.size(), 5);
+  EXPECT_EQ(stats.items, lines.size());
+  for (const auto &s : stats.stages)
+    EXPECT_EQ(s.items, lines.size());
+  for (size_t i = 1; i < stats.stages.size(); ++i)
+    EXPECT_LE(stats.stages[i].max_queue_depth, 8);
+
+#ifndef NDEBUG
+  std::cout << stats;
+#endif
+}
+
+TEST(pipeline, token_limit_bounds_items_in_flight) {
+  using namespace pipeline;
+  constexpr size_t max_tokens = 4;
+  std::atomic<int> in_flight{0};
+  std::atomic<int> max_in_flight{0};
+  int produced = 0;
+
+  Pipeline{max_tokens}
+      .source<int>("source",
+                   [&]() -> std::optional<int> {
+                     if (produced == 200)
+                       return std::nullopt;
+                     int now = ++in_flight;
+                     int prev = max_in_flight.load();
+                     while (now > prev && !max_in_flight.compare_exchange_weak(prev, now))
+                       ;
+                     return produced++;
+                   })
+      .stage("work", StageMode::parallel,
+             [](int &&v) {
+               std::this_thread::yield();
+               return v;
+             },
+             8)
+      .stage("sink", StageMode::serial_out_of_order, [&](int &&) { --in_flight; })
+      .run();
+
+  EXPECT_LE(max_in_flight.load(), static_cast<int>(max_tokens));
+  EXPECT_EQ(in_flight.load(), 0);
+}
+
+TEST(pipeline, reports_bottleneck_stage) {
+  using namespace pipeline;
+  using namespace std::chrono_literals;
+  int produced = 0;
+
+  auto stats = Pipeline{4}
+                   .source<int>("source",
+                                [&]() -> std::optional<int> {
+                                  if (produced == 50)
+                                    return std::nullopt;
+                                  return produced++;
+                                })
+                   .stage("fast", StageMode::serial_in_order, [](int &&v) { return v; })
+                   .stage("slow", StageMode::serial_in_order,
+                          [](int &&v) {
+                            std::this_thread::sleep_for(1ms);
+                            return v;
+                          })
+                   .stage("sink", StageMode::serial_in_order, [](int &&) {})
+                   .run();
+
+  EXPECT_EQ(stats.stages[stats.bottleneck()].name, "slow");
+  // Items pile up in front of the slow stage.
+  EXPECT_GT(stats.stages[2].avg_queue_depth, stats.stages[3].avg_queue_depth);
+
+  // Printing leaves the stream's formatting as it was.
+  std::ostringstream os;
+  os << stats << 7.5 << ' ' << std::setw(3) << 1;
+  EXPECT_TRUE(os.str().ends_with("\n7.5   1")) << os.str();
+
+#ifndef NDEBUG
+  std::cout << stats;
+#endif
+}
+
+TEST(pipeline, stage_exception_is_rethrown) {
+  using namespace pipeline;
+  int produced = 0;
+
+  auto p = Pipeline{4}
+               .source<int>("source",
+                            [&]() -> std::optional<int> {
+                              if (produced == 1000)
+                                return std::nullopt;
+                              return produced++;
+                            })
+               .stage("check", StageMode::parallel,
+                      [](int &&v) {
+                        if (v == 100)
+                          throw std::runtime_error("bad record");
+                        return v;
+                      })
+               .stage("sink", StageMode::serial_in_order, [](int &&) {});
+
+  EXPECT_THROW(p.run(), std::runtime_error);
+  EXPECT_LT(produced, 1000);
+}
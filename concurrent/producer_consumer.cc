@@ -8,6 +8,7 @@
 //
 // 生产者与消费者不能直接交互,它们之间所共享的数据使用队列结构来实现;
 
+#include "object_pool.hpp"
 #include <condition_variable>
 #include <iostream>
 #include <mutex>
@@ -17,9 +18,18 @@
 namespace producer_consumer {
 
 uint64_t num = 0;
+
+// A unit of work handed from the producer to the consumer. Items are created
+// on one thread and destroyed on the other, so they come from a pool with
+// per-thread magazines rather than one new/delete each.
+struct WorkItem {
+  uint64_t data;
+};
+
 class ProducerConsumer {
 private:
-  std::queue<uint64_t> queue_{};
+  allocators::concurrent_object_pool<WorkItem> items_{};
+  std::queue<WorkItem *> queue_{};
   std::mutex mutex_lock_{};
   std::condition_variable condition_{};
   std::unique_ptr<std::thread> producer_;
@@ -56,7 +66,7 @@ public:
         condition_.wait(lock_guard);
 
       uint64_t data = num++;
-      queue_.push(data);
+      queue_.push(items_.create(WorkItem{data}));
       std::cout << "task data = " << data << " produced\n";
       produced_production_cnt++;
       if (produced_production_cnt > total_production_count)
@@ -73,8 +83,10 @@ public:
       while (queue_.empty())
         condition_.wait(lock_guard);
 
-      uint64_t data = queue_.front();
+      WorkItem *item = queue_.front();
       queue_.pop();
+      uint64_t data = item->data;
+      items_.destroy(item);
       std::cout << "task data = " << data << " has been consumed.\n";
       if (!produce_is_not_finished_flag && queue_.empty())
         consume_is_not_finished_flag = false;
@@ -0,0 +1,155 @@
+#pragma once
+
+// DESCRIPTION:
+//  Epoch-based memory reclamation (Fraser, "Practical lock-freedom").
+//
+//  A lock-free structure cannot free an unlinked node immediately, because a
+//  concurrent reader may still hold a pointer to it. Instead:
+//    * every operation runs inside an epoch::Guard, which publishes the global
+//      epoch the thread observed on entry;
+//    * unlinked nodes are retire()d, tagged with the current global epoch;
+//    * the global epoch only advances when every active thread has observed
+//      it, so once it is two ahead of a node's tag no thread can still see
+//      that node and it is freed.
+//
+//  There is one process-wide Domain. Per-thread records are recycled when a
+//  thread exits, and any garbage they still hold is freed by the next thread
+//  that picks the record up.
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace epoch {
+
+class Domain {
+public:
+  using Deleter = void (*)(void *);
+
+private:
+  struct Retired {
+    uint64_t epoch;
+    void *ptr;
+    Deleter deleter;
+  };
+
+  struct alignas(64) Record {
+    // (observed epoch << 1) | 1 while pinned, 0 otherwise.
+    std::atomic<uint64_t> state{0};
+    std::atomic<bool> in_use{true};
+    Record *next = nullptr;
+    unsigned depth = 0; // owner only
+    std::vector<Retired> limbo; // owner only
+  };
+
+public:
+  /// The process-wide domain. It is intentionally never destroyed, so guards
+  /// held by thread_local destructors at exit remain valid.
+  static Domain &global() {
+    static Domain *domain = new Domain;
+    return *domain;
+  }
+
+  class Guard {
+  public:
+    explicit Guard(Domain &domain = Domain::global()) : record_(domain.local_record()) {
+      if (record_->depth++ == 0)
+        domain.pin(*record_);
+    }
+    ~Guard() {
+      if (--record_->depth == 0)
+        record_->state.store(0, std::memory_order_release);
+    }
+    Guard(const Guard &) = delete;
+    Guard &operator=(const Guard &) = delete;
+
+  private:
+    Record *record_;
+  };
+
+  /// Schedule `ptr` to be passed to `deleter` once no guard can observe it.
+  /// Must be called after `ptr` has been unlinked, from inside a Guard.
+  void retire(void *ptr, Deleter deleter) {
+    Record &r = *local_record();
+    r.limbo.push_back({epoch_.load(std::memory_order_seq_cst), ptr, deleter});
+    if (r.limbo.size() >= kCollectThreshold)
+      collect(r);
+  }
+
+  [[nodiscard]] uint64_t current_epoch() const { return epoch_.load(); }
+
+private:
+  static constexpr size_t kCollectThreshold = 64;
+
+  Domain() = default;
+
+  void pin(Record &r) {
+    uint64_t e = epoch_.load(std::memory_order_seq_cst);
+    while (true) {
+      r.state.store((e << 1) | 1, std::memory_order_seq_cst);
+      uint64_t now = epoch_.load(std::memory_order_seq_cst);
+      if (now == e)
+        return;
+      e = now;
+    }
+  }
+
+  bool try_advance() {
+    uint64_t e = epoch_.load(std::memory_order_seq_cst);
+    for (Record *r = records_.load(std::memory_order_acquire); r; r = r->next) {
+      uint64_t s = r->state.load(std::memory_order_seq_cst);
+      if ((s & 1) && (s >> 1) != e)
+        return false;
+    }
+    return epoch_.compare_exchange_strong(e, e + 1, std::memory_order_seq_cst);
+  }
+
+  void collect(Record &r) {
+    try_advance();
+    const uint64_t e = epoch_.load(std::memory_order_seq_cst);
+    size_t kept = 0;
+    for (auto &item : r.limbo) {
+      if (item.epoch + 2 <= e)
+        item.deleter(item.ptr);
+      else
+        r.limbo[kept++] = item;
+    }
+    r.limbo.resize(kept);
+  }
+
+  Record *local_record() {
+    struct Holder {
+      Record *record = nullptr;
+      ~Holder() {
+        if (record)
+          record->in_use.store(false, std::memory_order_release);
+      }
+    };
+    thread_local Holder holder;
+    if (!holder.record)
+      holder.record = acquire_record();
+    return holder.record;
+  }
+
+  Record *acquire_record() {
+    for (Record *r = records_.load(std::memory_order_acquire); r; r = r->next) {
+      bool expected = false;
+      if (!r->in_use.load(std::memory_order_relaxed) &&
+          r->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+        return r;
+    }
+    auto *r = new Record;
+    r->next = records_.load(std::memory_order_relaxed);
+    while (!records_.compare_exchange_weak(r->next, r, std::memory_order_release,
+                                           std::memory_order_relaxed))
+      ;
+    return r;
+  }
+
+  std::atomic<uint64_t> epoch_{0};
+  std::atomic<Record *> records_{nullptr};
+};
+
+using Guard = Domain::Guard;
+
+} // end of namespace epoch
@@ -0,0 +1,301 @@
+#pragma once
+
+// DESCRIPTION:
+//  A lock-free ordered map built on a skip list (Herlihy & Shavit, "The Art of
+//  Multiprocessor Programming", ch. 14; Fraser's marking scheme).
+//
+//  * Level 0 is the authoritative list; higher levels are shortcuts.
+//  * A node is logically erased by setting the low "mark" bit of its next
+//    pointers, top level first and level 0 last. The thread whose CAS marks
+//    level 0 owns the erase.
+//  * Searches physically unlink (snip) marked nodes they walk past.
+//  * find/contains/range never write shared memory.
+//  * Unlinked nodes are handed to epoch::Domain, so readers inside an
+//    epoch::Guard never touch freed memory.
+//
+//  A node may still be getting linked into its upper levels by its inserter
+//  while another thread erases it. Both sides set a flag when they are done,
+//  and whichever finishes second does a last unlinking pass and retires the
+//  node.
+//
+//  Values are immutable once inserted. find() returns a copy.
+
+#include "epoch.h"
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <optional>
+#include <utility>
+
+namespace skip_list {
+
+template <typename K, typename V, typename Compare = std::less<K>> class SkipListMap {
+public:
+  static constexpr int kMaxHeight = 20;
+
+  SkipListMap() {
+    for (auto &h : head_)
+      h.store(0, std::memory_order_relaxed);
+  }
+
+  SkipListMap(const SkipListMap &) = delete;
+  SkipListMap &operator=(const SkipListMap &) = delete;
+
+  /// Not thread-safe: no other operation may run concurrently.
+  ~SkipListMap() {
+    Node *curr = ptr(head_[0].load(std::memory_order_relaxed));
+    while (curr) {
+      Node *next = ptr(curr->next()[0].load(std::memory_order_relaxed));
+      destroy(curr);
+      curr = next;
+    }
+  }
+
+  /// Insert (key, value). Returns false, leaving the map unchanged, if the key
+  /// is already present.
+  bool insert(const K &key, const V &value) {
+    epoch::Guard guard;
+    Node *preds[kMaxHeight];
+    Node *succs[kMaxHeight];
+    Node *node = nullptr;
+
+    while (true) {
+      if (search(key, nullptr, preds, succs)) {
+        if (node)
+          destroy(node);
+        return false;
+      }
+      if (!node) {
+        node = create(key, value, random_height());
+        int top = height_.load(std::memory_order_relaxed);
+        while (top < node->height && !height_.compare_exchange_weak(top, node->height))
+          ;
+      }
+      for (int l = 0; l < node->height; ++l)
+        node->next()[l].store(bits(succs[l]), std::memory_order_relaxed);
+
+      uintptr_t expected = bits(succs[0]);
+      if (link(preds[0], 0).compare_exchange_strong(expected, bits(node)))
+        break;
+    }
+    size_.fetch_add(1, std::memory_order_relaxed);
+
+    // The node is in the map now; link the shortcut levels on a best-effort
+    // basis and give up as soon as an eraser marks the node.
+    for (int l = 1; l < node->height; ++l) {
+      bool linked = false;
+      while (!linked) {
+        uintptr_t old = node->next()[l].load();
+        if (marked(old))
+          goto done;
+        if (old != bits(succs[l]) && !node->next()[l].compare_exchange_strong(old, bits(succs[l])))
+          goto done; // only an eraser changes next[] of an unlinked level
+        uintptr_t expected = bits(succs[l]);
+        linked = link(preds[l], l).compare_exchange_strong(expected, bits(node));
+        if (!linked) {
+          search(key, node, preds, succs);
+          if (marked(node->next()[0].load()))
+            goto done;
+        }
+      }
+    }
+  done:
+    if (node->flags.fetch_or(kInsertDone) & kErased)
+      reclaim(node);
+    return true;
+  }
+
+  /// Erase key. Returns false if it was not present.
+  bool erase(const K &key) {
+    epoch::Guard guard;
+    Node *preds[kMaxHeight];
+    Node *succs[kMaxHeight];
+
+    while (true) {
+      if (!search(key, nullptr, preds, succs))
+        return false;
+      Node *victim = succs[0];
+
+      for (int l = victim->height - 1; l > 0; --l) {
+        uintptr_t s = victim->next()[l].load();
+        while (!marked(s) && !victim->next()[l].compare_exchange_weak(s, s | 1))
+          ;
+      }
+
+      uintptr_t s = victim->next()[0].load();
+      while (!marked(s)) {
+        if (victim->next()[0].compare_exchange_weak(s, s | 1)) {
+          size_.fetch_sub(1, std::memory_order_relaxed);
+          if (victim->flags.fetch_or(kErased) & kInsertDone)
+            reclaim(victim);
+          return true;
+        }
+      }
+      // Someone else erased it first; a new node with the same key may
+      // already have been inserted, so look again.
+    }
+  }
+
+  [[nodiscard]] bool contains(const K &key) const {
+    epoch::Guard guard;
+    return find_node(key) != nullptr;
+  }
+
+  [[nodiscard]] std::optional<V> find(const K &key) const {
+    epoch::Guard guard;
+    if (const Node *n = find_node(key))
+      return n->value;
+    return std::nullopt;
+  }
+
+  /// Call f(key, value) for every entry with lo <= key < hi, in key order.
+  /// Entries inserted or erased concurrently may or may not be visited.
+  template <typename F> void range(const K &lo, const K &hi, F f) const {
+    epoch::Guard guard;
+    for (const Node *curr = lower_bound(lo); curr && less_(curr->key, hi);
+         curr = ptr(curr->next()[0].load(std::memory_order_acquire))) {
+      if (!marked(curr->next()[0].load(std::memory_order_acquire)))
+        f(curr->key, curr->value);
+    }
+  }
+
+  /// Call f(key, value) for every entry, in key order.
+  template <typename F> void for_each(F f) const {
+    epoch::Guard guard;
+    for (const Node *curr = ptr(head_[0].load(std::memory_order_acquire)); curr;
+         curr = ptr(curr->next()[0].load(std::memory_order_acquire))) {
+      if (!marked(curr->next()[0].load(std::memory_order_acquire)))
+        f(curr->key, curr->value);
+    }
+  }
+
+  /// Number of entries; exact only when no operation is in flight.
+  [[nodiscard]] size_t size() const { return size_.load(std::memory_order_relaxed); }
+  [[nodiscard]] bool empty() const { return size() == 0; }
+
+private:
+  static constexpr uint8_t kInsertDone = 1;
+  static constexpr uint8_t kErased = 2;
+
+  struct Node {
+    Node(const K &k, const V &v, int h) : key(k), value(v), height(h) {}
+
+    K key;
+    V value;
+    const int height;
+    std::atomic<uint8_t> flags{0};
+
+    // `height` links are laid out right after the node, in the same block.
+    std::atomic<uintptr_t> *next() { return reinterpret_cast<std::atomic<uintptr_t> *>(this + 1); }
+    const std::atomic<uintptr_t> *next() const {
+      return reinterpret_cast<const std::atomic<uintptr_t> *>(this + 1);
+    }
+  };
+  static_assert(sizeof(Node) % alignof(std::atomic<uintptr_t>) == 0);
+
+  static bool marked(uintptr_t p) { return p & 1; }
+  static Node *ptr(uintptr_t p) { return reinterpret_cast<Node *>(p & ~uintptr_t{1}); }
+  static uintptr_t bits(const Node *n) { return reinterpret_cast<uintptr_t>(n); }
+
+  static Node *create(const K &key, const V &value, int height) {
+    void *raw = ::operator new(sizeof(Node) + height * sizeof(std::atomic<uintptr_t>));
+    auto *node = new (raw) Node(key, value, height);
+    for (int l = 0; l < height; ++l)
+      new (node->next() + l) std::atomic<uintptr_t>(0);
+    return node;
+  }
+
+  static void destroy(Node *node) {
+    node->~Node();
+    ::operator delete(node);
+  }
+
+  static int random_height() {
+    thread_local uint64_t state = 0x9E3779B97F4A7C15ull ^ reinterpret_cast<uintptr_t>(&state);
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    // One extra level with probability 1/2 each.
+    int h = 1 + std::countr_one(state);
+    return h < kMaxHeight ? h : kMaxHeight;
+  }
+
+  std::atomic<uintptr_t> &link(Node *pred, int level) {
+    return pred ? pred->next()[level] : head_[level];
+  }
+
+  /// Fill preds/succs with the position of `key` at every level, snipping
+  /// marked nodes on the way. With a `target`, equal keys other than the
+  /// target are walked past, so the target's own position is found. Returns
+  /// true if an unmarked node with `key` sits at level 0.
+  bool search(const K &key, const Node *target, Node **preds, Node **succs) {
+  retry:
+    Node *pred = nullptr;
+    for (int l = kMaxHeight - 1; l >= height_.load(std::memory_order_relaxed); --l)
+      preds[l] = succs[l] = nullptr;
+    for (int l = height_.load(std::memory_order_relaxed) - 1; l >= 0; --l) {
+      Node *curr = ptr(link(pred, l).load());
+      while (curr) {
+        uintptr_t succ = curr->next()[l].load();
+        if (marked(succ)) {
+          uintptr_t expected = bits(curr);
+          if (!link(pred, l).compare_exchange_strong(expected, succ & ~uintptr_t{1}))
+            goto retry;
+          curr = ptr(succ);
+          continue;
+        }
+        const bool go_right = less_(curr->key, key) ||
+                              (target && curr != target && !less_(key, curr->key));
+        if (!go_right)
+          break;
+        pred = curr;
+        curr = ptr(succ);
+      }
+      preds[l] = pred;
+      succs[l] = curr;
+    }
+    return succs[0] && !less_(key, succs[0]->key);
+  }
+
+  /// Called by whichever of inserter/eraser finishes last: nobody will link
+  /// the node again, so one targeted search unlinks it at every level.
+  void reclaim(Node *node) {
+    Node *preds[kMaxHeight];
+    Node *succs[kMaxHeight];
+    search(node->key, node, preds, succs);
+    epoch::Domain::global().retire(node, [](void *p) { destroy(static_cast<Node *>(p)); });
+  }
+
+  /// First node (marked or not) whose key is not less than `key`.
+  const Node *lower_bound(const K &key) const {
+    const Node *pred = nullptr;
+    const Node *curr = nullptr;
+    for (int l = height_.load(std::memory_order_relaxed) - 1; l >= 0; --l) {
+      curr = ptr((pred ? pred->next()[l] : head_[l]).load(std::memory_order_acquire));
+      while (curr && less_(curr->key, key)) {
+        pred = curr;
+        curr = ptr(curr->next()[l].load(std::memory_order_acquire));
+      }
+    }
+    return curr;
+  }
+
+  const Node *find_node(const K &key) const {
+    // Skip over erased nodes that have not been unlinked yet.
+    for (const Node *curr = lower_bound(key); curr && !less_(key, curr->key);
+         curr = ptr(curr->next()[0].load(std::memory_order_acquire)))
+      if (!marked(curr->next()[0].load(std::memory_order_acquire)))
+        return curr;
+    return nullptr;
+  }
+
+  std::atomic<uintptr_t> head_[kMaxHeight];
+  std::atomic<int> height_{1}; // highest level any node has used; only grows
+  std::atomic<size_t> size_{0};
+  [[no_unique_address]] Compare less_{};
+};
+
+} // end of namespace skip_list
@@ -0,0 +1,169 @@
+#include "my_timer.h"
+#include "skip_list.h"
+#include <gtest/gtest.h>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// The baseline the skip list replaces: an ordered std::set behind one lock.
+class LockedSet {
+public:
+  bool insert(int key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return set_.insert(key).second;
+  }
+  bool erase(int key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return set_.erase(key) != 0;
+  }
+  bool contains(int key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return set_.count(key) != 0;
+  }
+
+private:
+  mutable std::mutex mutex_;
+  std::set<int> set_;
+};
+
+// 80% lookups, 10% inserts, 10% erases over a key space of `key_range`.
+template <typename Container, typename Insert>
+uint64_t run_mixed(Container &c, Insert insert, unsigned threads, unsigned ops_per_thread,
+                   int key_range) {
+  Timer T("mixed workload");
+  std::vector<std::thread> workers;
+  for (unsigned t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t] {
+      std::mt19937 gen(t);
+      std::uniform_int_distribution<int> key(0, key_range - 1);
+      std::uniform_int_distribution<int> op(0, 9);
+      for (unsigned i = 0; i < ops_per_thread; ++i) {
+        int k = key(gen);
+        switch (op(gen)) {
+        case 0:
+          insert(c, k);
+          break;
+        case 1:
+          c.erase(k);
+          break;
+        default:
+          [[maybe_unused]] bool found = c.contains(k);
+        }
+      }
+    });
+  }
+  for (auto &w : workers)
+    w.join();
+  return T.eclipse();
+}
+
+} // namespace
+
+TEST(skip_list, matches_std_map) {
+  skip_list::SkipListMap<int, int> list;
+  std::map<int, int> ref;
+  std::mt19937 gen(99);
+  std::uniform_int_distribution<int> key(0, 499);
+  std::uniform_int_distribution<int> op(0, 2);
+
+  for (int i = 0; i < 20000; ++i) {
+    int k = key(gen);
+    switch (op(gen)) {
+    case 0:
+      EXPECT_EQ(list.insert(k, k * 10), ref.emplace(k, k * 10).second);
+      break;
+    case 1:
+      EXPECT_EQ(list.erase(k), ref.erase(k) != 0);
+      break;
+    default:
+      EXPECT_EQ(list.find(k), ref.count(k) ? std::optional<int>(ref[k]) : std::nullopt);
+    }
+  }
+  EXPECT_EQ(list.size(), ref.size());
+
+  std::vector<std::pair<int, int>> all;
+  list.for_each([&](int k, int v) { all.emplace_back(k, v); });
+  EXPECT_EQ(all, (std::vector<std::pair<int, int>>(ref.begin(), ref.end())));
+
+  std::vector<int> in_range;
+  list.range(100, 200, [&](int k, int) { in_range.push_back(k); });
+  std::vector<int> expected;
+  for (auto it = ref.lower_bound(100); it != ref.lower_bound(200); ++it)
+    expected.push_back(it->first);
+  EXPECT_EQ(in_range, expected);
+}
+
+TEST(skip_list, concurrent_insert_erase) {
+  skip_list::SkipListMap<int, int> list;
+  constexpr unsigned threads = 4;
+  constexpr int per_thread = 5000;
+
+  // Every thread inserts its own keys, erases the odd ones, and races the
+  // others over a small shared range.
+  std::vector<std::thread> workers;
+  for (unsigned t = 0; t < threads; ++t) {
+    workers.emplace_back([&list, t] {
+      const int base = static_cast<int>(t) * per_thread;
+      for (int i = 0; i < per_thread; ++i)
+        EXPECT_TRUE(list.insert(base + i, i));
+      for (int i = 1; i < per_thread; i += 2)
+        EXPECT_TRUE(list.erase(base + i));
+
+      std::mt19937 gen(t);
+      std::uniform_int_distribution<int> key(-64, -1);
+      for (int i = 0; i < 20000; ++i) {
+        int k = key(gen);
+        if (i & 1)
+          list.insert(k, k);
+        else
+          list.erase(k);
+      }
+    });
+  }
+  for (auto &w : workers)
+    w.join();
+
+  for (int k = -64; k < 0; ++k)
+    list.erase(k);
+
+  EXPECT_EQ(list.size(), threads * per_thread / 2);
+  int prev = -1;
+  size_t visited = 0;
+  list.for_each([&](int k, int v) {
+    EXPECT_GT(k, prev);
+    EXPECT_EQ(k % per_thread, v);
+    EXPECT_EQ(v % 2, 0);
+    prev = k;
+    ++visited;
+  });
+  EXPECT_EQ(visited, list.size());
+}
+
+TEST(skip_list, mixed_workload_vs_locked_set) {
+  constexpr unsigned threads = 4;
+  constexpr unsigned ops = 200000;
+  constexpr int key_range = 100000;
+
+  skip_list::SkipListMap<int, int> list;
+  LockedSet locked;
+  for (int k = 0; k < key_range; k += 2) {
+    list.insert(k, k);
+    locked.insert(k);
+  }
+
+  auto list_time = run_mixed(
+      list, [](auto &c, int k) { c.insert(k, k); }, threads, ops, key_range);
+  auto locked_time = run_mixed(
+      locked, [](auto &c, int k) { c.insert(k); }, threads, ops, key_range);
+
+#ifndef NDEBUG
+  std::cout << "lock-free skip list: " << list_time / (threads * ops) << "ns/op, "
+            << "mutex + std::set: " << locked_time / (threads * ops) << "ns/op\n";
+#endif
+}
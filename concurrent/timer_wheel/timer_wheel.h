@@ -0,0 +1,334 @@
+#pragma once
+
+// DESCRIPTION:
+//  A hierarchical timing wheel (Varghese & Lauck, the same layout as the Linux
+//  kernel's timer list). Four levels of 256 slots cover 2^32 ticks; a timer is
+//  filed in the coarsest level whose range contains its deadline and is
+//  cascaded down one level each time the finer wheel wraps around.
+//
+//  schedule_after, schedule_every and cancel are O(1): timers live in a slab of
+//  nodes linked into intrusive doubly-linked slot lists, and a TimerId is just
+//  (slot index, generation), so a stale id can never cancel a recycled node.
+//
+//  TimerWheel itself is single-threaded and advanced explicitly, which keeps it
+//  deterministic. TimerService drives one wheel from one background thread and
+//  hands expired tasks to an executor, so thousands of delays cost one thread
+//  instead of one sleeping thread each.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace timer_wheel {
+
+struct TimerId {
+  uint32_t index = std::numeric_limits<uint32_t>::max();
+  uint32_t generation = 0;
+};
+
+class TimerWheel {
+public:
+  using Task = std::function<void()>;
+  using Tick = uint64_t;
+
+  static constexpr unsigned kLevels = 4;
+  static constexpr unsigned kSlotBits = 8;
+  static constexpr unsigned kSlots = 1u << kSlotBits;
+
+  TimerWheel() { heads_.fill(kNil); }
+
+  /// Run task once, `delay` ticks from now (at least one tick).
+  TimerId schedule_after(Tick delay, Task task) {
+    return insert_new(now_ + std::max<Tick>(delay, 1), 0, std::move(task));
+  }
+
+  /// Run task every `period` ticks (at least one tick) until cancelled.
+  TimerId schedule_every(Tick period, Task task) {
+    return schedule_every(period, period, std::move(task));
+  }
+
+  /// Run task `first_delay` ticks from now and then every `period` ticks.
+  TimerId schedule_every(Tick first_delay, Tick period, Task task) {
+    return insert_new(now_ + std::max<Tick>(first_delay, 1), std::max<Tick>(period, 1),
+                      std::move(task));
+  }
+
+  /// Cancel a pending timer. Returns false if it already fired or was
+  /// cancelled before.
+  bool cancel(TimerId id) {
+    if (id.index >= nodes_.size())
+      return false;
+    Node &node = nodes_[id.index];
+    if (node.generation != id.generation || node.slot == kNil)
+      return false;
+    unlink(id.index);
+    release(id.index);
+    return true;
+  }
+
+  /// Advance the wheel by `ticks`, running every timer that expires on the
+  /// way. Returns the number of tasks run. Once the wheel is empty there is
+  /// nothing to run or cascade, so the rest of the ticks are skipped in O(1).
+  size_t advance(Tick ticks) {
+    size_t fired = 0;
+    for (; ticks > 0 && active_ != 0; --ticks)
+      fired += tick();
+    now_ += ticks;
+    return fired;
+  }
+
+  [[nodiscard]] Tick now() const { return now_; }
+  [[nodiscard]] size_t size() const { return active_; }
+  [[nodiscard]] bool empty() const { return active_ == 0; }
+
+private:
+  static constexpr uint32_t kNil = std::numeric_limits<uint32_t>::max();
+
+  struct Node {
+    Tick expires = 0;
+    Tick period = 0; // 0 for one-shot timers
+    Task task;
+    uint32_t prev = kNil;
+    uint32_t next = kNil; // also links the free list
+    uint32_t slot = kNil; // kNil while the node is not scheduled
+    uint32_t generation = 0;
+  };
+
+  TimerId insert_new(Tick expires, Tick period, Task task) {
+    uint32_t idx;
+    if (free_ != kNil) {
+      idx = free_;
+      free_ = nodes_[idx].next;
+    } else {
+      idx = static_cast<uint32_t>(nodes_.size());
+      nodes_.emplace_back();
+    }
+    Node &node = nodes_[idx];
+    node.expires = expires;
+    node.period = period;
+    node.task = std::move(task);
+    link(idx);
+    ++active_;
+    return {idx, node.generation};
+  }
+
+  void release(uint32_t idx) {
+    Node &node = nodes_[idx];
+    node.task = nullptr;
+    ++node.generation;
+    node.next = free_;
+    free_ = idx;
+    --active_;
+  }
+
+  // File the node in the coarsest level whose span still contains its
+  // deadline. Deadlines beyond the top level are parked in the top level and
+  // re-filed when they get cascaded.
+  void link(uint32_t idx) {
+    Node &node = nodes_[idx];
+    const Tick delta = node.expires - now_;
+    unsigned level = 0;
+    while (level + 1 < kLevels && delta >= (Tick{1} << (kSlotBits * (level + 1))))
+      ++level;
+
+    Tick when = node.expires;
+    if (level == kLevels - 1 && delta >= (Tick{1} << (kSlotBits * kLevels)))
+      when = now_ + (Tick{1} << (kSlotBits * kLevels)) - 1;
+
+    const uint32_t slot = level * kSlots + ((when >> (kSlotBits * level)) & (kSlots - 1));
+    node.slot = slot;
+    node.prev = kNil;
+    node.next = heads_[slot];
+    if (node.next != kNil)
+      nodes_[node.next].prev = idx;
+    heads_[slot] = idx;
+  }
+
+  void unlink(uint32_t idx) {
+    Node &node = nodes_[idx];
+    if (node.prev != kNil)
+      nodes_[node.prev].next = node.next;
+    else
+      heads_[node.slot] = node.next;
+    if (node.next != kNil)
+      nodes_[node.next].prev = node.prev;
+    node.slot = kNil;
+    node.prev = node.next = kNil;
+  }
+
+  void cascade(unsigned level) {
+    const uint32_t slot = level * kSlots + ((now_ >> (kSlotBits * level)) & (kSlots - 1));
+    while (heads_[slot] != kNil) {
+      uint32_t idx = heads_[slot];
+      unlink(idx);
+      link(idx);
+    }
+  }
+
+  size_t tick() {
+    ++now_;
+    for (unsigned level = 1; level < kLevels; ++level) {
+      if ((now_ & ((Tick{1} << (kSlotBits * level)) - 1)) != 0)
+        break;
+      cascade(level);
+    }
+
+    size_t fired = 0;
+    const uint32_t slot = now_ & (kSlots - 1);
+    while (heads_[slot] != kNil) {
+      const uint32_t idx = heads_[slot];
+      unlink(idx);
+
+      // The task may schedule or cancel timers, which can grow nodes_, so
+      // don't hold a reference to the node across the call.
+      const uint32_t generation = nodes_[idx].generation;
+      const Tick period = nodes_[idx].period;
+      Task task = std::move(nodes_[idx].task);
+      if (period != 0) {
+        nodes_[idx].expires = now_ + period;
+        link(idx);
+      }
+
+      task();
+      ++fired;
+
+      if (period == 0)
+        release(idx);
+      else if (nodes_[idx].generation == generation)
+        nodes_[idx].task = std::move(task);
+    }
+    return fired;
+  }
+
+  std::vector<Node> nodes_;
+  std::array<uint32_t, kLevels * kSlots> heads_{};
+  uint32_t free_ = kNil;
+  size_t active_ = 0;
+  Tick now_ = 0;
+};
+
+/// Drives a TimerWheel from a single background thread.
+///
+/// Expired tasks are passed to `executor`. By default they run inline on the
+/// timer thread, which is fine for short callbacks; anything heavier should be
+/// posted to a worker pool by supplying an executor that enqueues the task.
+class TimerService {
+public:
+  using Clock = std::chrono::steady_clock;
+  using Task = TimerWheel::Task;
+  using Executor = std::function<void(Task)>;
+
+  explicit TimerService(Clock::duration resolution = std::chrono::milliseconds{1},
+                        Executor executor = nullptr)
+      : resolution_(resolution), executor_(std::move(executor)), start_(Clock::now()) {
+    thread_ = std::thread([this] { run(); });
+  }
+
+  TimerService(const TimerService &) = delete;
+  TimerService &operator=(const TimerService &) = delete;
+
+  ~TimerService() {
+    {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+  }
+
+  template <typename Rep, typename Period>
+  TimerId schedule_after(std::chrono::duration<Rep, Period> delay, Task task) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    skip_idle_ticks();
+    auto id = wheel_.schedule_after(deadline(delay) - wheel_.now(), wrap(std::move(task)));
+    wake_.notify_one();
+    return id;
+  }
+
+  template <typename Rep, typename Period>
+  TimerId schedule_every(std::chrono::duration<Rep, Period> period, Task task) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    skip_idle_ticks();
+    auto id = wheel_.schedule_every(deadline(period) - wheel_.now(), to_ticks(period),
+                                    wrap(std::move(task)));
+    wake_.notify_one();
+    return id;
+  }
+
+  bool cancel(TimerId id) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    return wheel_.cancel(id);
+  }
+
+  [[nodiscard]] size_t size() const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    return wheel_.size();
+  }
+
+private:
+  TimerWheel::Tick to_ticks(Clock::duration d) const {
+    auto ticks = (d + resolution_ - Clock::duration{1}) / resolution_;
+    return static_cast<TimerWheel::Tick>(std::max<decltype(ticks)>(ticks, 0));
+  }
+
+  // The wheel only advances while it has work, so deadlines are computed
+  // against the wall clock rather than against wheel_.now().
+  template <typename Rep, typename Period>
+  TimerWheel::Tick deadline(std::chrono::duration<Rep, Period> delay) const {
+    auto tick = to_ticks(Clock::now() - start_ + std::chrono::duration_cast<Clock::duration>(delay));
+    return std::max(tick, wheel_.now() + 1);
+  }
+
+  TimerWheel::Tick elapsed_ticks() const {
+    return static_cast<TimerWheel::Tick>((Clock::now() - start_) / resolution_);
+  }
+
+  // An idle wheel is not advanced, so its now() lags the clock. Bring it up
+  // to date before filing a timer, while that is still an O(1) jump;
+  // otherwise run() would step through every idle tick under mutex_.
+  void skip_idle_ticks() {
+    const auto elapsed = elapsed_ticks();
+    if (wheel_.empty() && elapsed > wheel_.now())
+      wheel_.advance(elapsed - wheel_.now());
+  }
+
+  Task wrap(Task task) {
+    if (!executor_)
+      return task;
+    return [this, task = std::move(task)] { executor_(task); };
+  }
+
+  void run() {
+    std::unique_lock<std::recursive_mutex> lock(mutex_);
+    while (!stop_) {
+      if (wheel_.empty())
+        wake_.wait(lock, [this] { return stop_ || !wheel_.empty(); });
+      else
+        wake_.wait_until(lock, start_ + resolution_ * (wheel_.now() + 1));
+
+      const auto elapsed = elapsed_ticks();
+      if (elapsed > wheel_.now())
+        wheel_.advance(elapsed - wheel_.now());
+    }
+  }
+
+  const Clock::duration resolution_;
+  const Executor executor_;
+  const Clock::time_point start_;
+
+  mutable std::recursive_mutex mutex_;
+  std::condition_variable_any wake_;
+  bool stop_ = false;
+  TimerWheel wheel_;
+  std::thread thread_;
+};
+
+} // end of namespace timer_wheel
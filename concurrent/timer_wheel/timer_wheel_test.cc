@@ -0,0 +1,199 @@
+#include "my_timer.h"
+#include "timer_wheel.h"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <latch>
+#include <random>
+#include <string>
+#include <vector>
+
+TEST(timer_wheel, fires_on_exact_tick) {
+  using namespace timer_wheel;
+  TimerWheel wheel;
+  std::vector<std::pair<uint64_t, uint64_t>> fired; // (deadline, tick it ran on)
+
+  std::mt19937_64 gen(42);
+  std::uniform_int_distribution<uint64_t> dis(1, 200000);
+  for (unsigned i = 0; i < 2000; ++i) {
+    uint64_t delay = dis(gen);
+    wheel.schedule_after(delay, [&wheel, &fired, delay] { fired.emplace_back(delay, wheel.now()); });
+  }
+  // A few deadlines right on level boundaries.
+  for (uint64_t delay : {255ull, 256ull, 257ull, 65535ull, 65536ull, 65537ull})
+    wheel.schedule_after(delay, [&wheel, &fired, delay] { fired.emplace_back(delay, wheel.now()); });
+
+  EXPECT_EQ(wheel.size(), 2006);
+  EXPECT_EQ(wheel.advance(200000), 2006);
+  EXPECT_TRUE(wheel.empty());
+  for (auto [deadline, ran_at] : fired)
+    EXPECT_EQ(deadline, ran_at);
+}
+
+TEST(timer_wheel, periodic_and_cancel) {
+  using namespace timer_wheel;
+  TimerWheel wheel;
+
+  std::vector<uint64_t> ticks;
+  auto periodic = wheel.schedule_every(100, [&] { ticks.push_back(wheel.now()); });
+
+  int one_shot_runs = 0;
+  auto one_shot = wheel.schedule_after(50, [&] { ++one_shot_runs; });
+  EXPECT_TRUE(wheel.cancel(one_shot));
+  EXPECT_FALSE(wheel.cancel(one_shot));
+
+  wheel.advance(350);
+  EXPECT_EQ(ticks, (std::vector<uint64_t>{100, 200, 300}));
+  EXPECT_EQ(one_shot_runs, 0);
+
+  EXPECT_TRUE(wheel.cancel(periodic));
+  wheel.advance(1000);
+  EXPECT_EQ(ticks.size(), 3);
+  EXPECT_TRUE(wheel.empty());
+
+  // A stale id must not cancel the timer that reuses its node.
+  auto reused = wheel.schedule_after(10, [&] { ++one_shot_runs; });
+  EXPECT_EQ(reused.index, periodic.index);
+  EXPECT_FALSE(wheel.cancel(periodic));
+  wheel.advance(10);
+  EXPECT_EQ(one_shot_runs, 1);
+}
+
+TEST(timer_wheel, callbacks_may_reschedule_and_cancel_themselves) {
+  using namespace timer_wheel;
+  TimerWheel wheel;
+
+  int runs = 0;
+  TimerId self;
+  self = wheel.schedule_every(3, [&] {
+    if (++runs == 4)
+      wheel.cancel(self);
+  });
+
+  int chained = 0;
+  std::function<void()> chain = [&] {
+    if (++chained < 5)
+      wheel.schedule_after(1, chain);
+  };
+  wheel.schedule_after(1, chain);
+
+  wheel.advance(100);
+  EXPECT_EQ(runs, 4);
+  EXPECT_EQ(chained, 5);
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST(timer_wheel, idle_ticks_are_skipped) {
+  using namespace timer_wheel;
+  TimerWheel wheel;
+
+  // Ticking through 2^40 empty ticks one by one would not finish.
+  constexpr uint64_t idle = uint64_t{1} << 40;
+  EXPECT_EQ(wheel.advance(idle), 0);
+  EXPECT_EQ(wheel.now(), idle);
+
+  std::vector<uint64_t> fired;
+  wheel.schedule_after(300, [&] { fired.push_back(wheel.now()); });
+  wheel.schedule_after(70000, [&] { fired.push_back(wheel.now()); });
+  EXPECT_EQ(wheel.advance(299), 0);
+  EXPECT_EQ(wheel.advance(idle), 2); // ticks until the wheel is empty, then jumps
+  EXPECT_EQ(fired, (std::vector<uint64_t>{idle + 300, idle + 70000}));
+  EXPECT_EQ(wheel.now(), 2 * idle + 299);
+}
+
+// Same output as future_test's do_something('.') / do_something('+'), but all
+// twenty delays are driven by one timer thread instead of two sleeping threads.
+TEST(timer_wheel, timer_service_do_something) {
+  using namespace timer_wheel;
+  using namespace std::chrono_literals;
+
+  std::latch done{2};
+  std::string out;
+  std::mutex out_mutex;
+  {
+    TimerService timers{1ms};
+    for (char c : {'.', '+'}) {
+      std::default_random_engine dre(c);
+      std::uniform_int_distribution<int> id(10, 100);
+      std::chrono::milliseconds at{0};
+      for (unsigned i = 0; i < 10; ++i) {
+        at += std::chrono::milliseconds{id(dre)};
+        timers.schedule_after(at, [&, c, last = i == 9] {
+          std::lock_guard<std::mutex> lock(out_mutex);
+          out.push_back(c);
+          if (last)
+            done.count_down();
+        });
+      }
+    }
+    done.wait();
+    EXPECT_EQ(timers.size(), 0);
+  }
+  EXPECT_EQ(std::count(out.begin(), out.end(), '.'), 10);
+  EXPECT_EQ(std::count(out.begin(), out.end(), '+'), 10);
+}
+
+TEST(timer_wheel, timer_service_executor_and_deadline) {
+  using namespace timer_wheel;
+  using namespace std::chrono_literals;
+
+  std::atomic<int> posted{0};
+  std::atomic<int> periodic_runs{0};
+  std::latch fired{1};
+  TimerService timers{1ms, [&](TimerService::Task task) {
+                        ++posted;
+                        task();
+                      }};
+
+  auto start = TimerService::Clock::now();
+  auto every = timers.schedule_every(5ms, [&] { ++periodic_runs; });
+  timers.schedule_after(30ms, [&] { fired.count_down(); });
+  fired.wait();
+  EXPECT_GE(TimerService::Clock::now() - start, 30ms);
+  EXPECT_TRUE(timers.cancel(every));
+  EXPECT_GE(periodic_runs.load(), 1);
+  EXPECT_EQ(posted.load(), periodic_runs.load() + 1);
+}
+
+TEST(timer_wheel, schedule_cancel_one_million) {
+  using namespace timer_wheel;
+  constexpr unsigned num_timers = 1000000;
+
+  TimerWheel wheel;
+  std::vector<TimerId> ids(num_timers);
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<uint64_t> dis(1, 1u << 20);
+  uint64_t fired_sum = 0;
+
+  uint64_t schedule_time, cancel_time, advance_time;
+  {
+    Timer T("timer_wheel schedule 1M");
+    for (unsigned i = 0; i < num_timers; ++i)
+      ids[i] = wheel.schedule_after(dis(gen), [&fired_sum] { ++fired_sum; });
+    schedule_time = T.eclipse();
+  }
+  EXPECT_EQ(wheel.size(), num_timers);
+
+  {
+    Timer T("timer_wheel cancel 500K");
+    for (unsigned i = 0; i < num_timers; i += 2)
+      EXPECT_TRUE(wheel.cancel(ids[i]));
+    cancel_time = T.eclipse();
+  }
+  EXPECT_EQ(wheel.size(), num_timers / 2);
+
+  {
+    Timer T("timer_wheel expire 500K");
+    wheel.advance(1u << 20);
+    advance_time = T.eclipse();
+  }
+  EXPECT_EQ(fired_sum, num_timers / 2);
+  EXPECT_TRUE(wheel.empty());
+
+#ifndef NDEBUG
+  std::cout << "schedule: " << schedule_time / num_timers << "ns/timer, "
+            << "cancel: " << cancel_time / (num_timers / 2) << "ns/timer, "
+            << "expire (incl. 1M empty ticks): " << advance_time / (num_timers / 2)
+            << "ns/timer\n";
+#endif
+}
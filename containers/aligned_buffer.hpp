@@ -0,0 +1,157 @@
+#pragma once
+
+// DESCRIPTION:
+//  An owning buffer of trivial elements (double, float, int, small PODs) for
+//  numeric kernels: aligned to `Align` bytes, one cache line by default, and
+//  left uninitialized unless asked otherwise.
+//
+//  `new T[n]` is only aligned to alignof(max_align_t), so a vector kernel has
+//  to peel a scalar head or use unaligned loads; and std::vector<T>(n) writes
+//  zeros that the kernel then overwrites. aligned_buffer fixes both:
+//  * data() is Align-aligned, and capacity() is rounded up to a whole
+//    multiple of Align bytes, so a SIMD loop may read (not rely on) the
+//    padding past size() in its last iteration.
+//  * aligned_buffer(n) and uninitialized_resize(n) leave new elements
+//    indeterminate; the caller writes them before reading. aligned_buffer(n,
+//    value) and resize(n, value) fill as usual.
+//
+//  T must be trivially copyable and trivially destructible, so growing is a
+//  memcpy and nothing ever needs destroying.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace containers {
+
+template <typename T, size_t Align = 64> class aligned_buffer {
+  static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>,
+                "aligned_buffer holds trivial elements only");
+  static_assert(Align >= alignof(T) && (Align & (Align - 1)) == 0,
+                "Align must be a power of two, at least alignof(T)");
+
+public:
+  using value_type = T;
+  using size_type = size_t;
+  using reference = T &;
+  using const_reference = const T &;
+  using pointer = T *;
+  using const_pointer = const T *;
+  using iterator = T *;
+  using const_iterator = const T *;
+
+  static constexpr size_t alignment = Align;
+
+  aligned_buffer() noexcept = default;
+
+  /// n uninitialized elements.
+  explicit aligned_buffer(size_t n) { uninitialized_resize(n); }
+
+  aligned_buffer(size_t n, const T &value) : aligned_buffer(n) { std::fill(begin(), end(), value); }
+
+  aligned_buffer(const aligned_buffer &other) : aligned_buffer(other.size_) {
+    copy_from(other.data_, other.size_);
+  }
+
+  aligned_buffer(aligned_buffer &&other) noexcept
+      : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)),
+        capacity_(std::exchange(other.capacity_, 0)) {}
+
+  aligned_buffer &operator=(const aligned_buffer &other) {
+    if (this != &other) {
+      size_ = 0;
+      uninitialized_resize(other.size_);
+      copy_from(other.data_, other.size_);
+    }
+    return *this;
+  }
+
+  aligned_buffer &operator=(aligned_buffer &&other) noexcept {
+    if (this != &other) {
+      release();
+      data_ = std::exchange(other.data_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+      capacity_ = std::exchange(other.capacity_, 0);
+    }
+    return *this;
+  }
+
+  ~aligned_buffer() { release(); }
+
+  [[nodiscard]] size_t size() const noexcept { return size_; }
+  [[nodiscard]] size_t capacity() const noexcept { return capacity_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+  T *data() noexcept { return data_; }
+  const T *data() const noexcept { return data_; }
+
+  T &operator[](size_t i) noexcept { return data_[i]; }
+  const T &operator[](size_t i) const noexcept { return data_[i]; }
+  T &at(size_t i) {
+    if (i >= size_)
+      throw std::out_of_range("aligned_buffer::at");
+    return data_[i];
+  }
+  const T &at(size_t i) const { return const_cast<aligned_buffer *>(this)->at(i); }
+
+  iterator begin() noexcept { return data_; }
+  iterator end() noexcept { return data_ + size_; }
+  const_iterator begin() const noexcept { return data_; }
+  const_iterator end() const noexcept { return data_ + size_; }
+
+  /// Make room for n elements; keeps the contents.
+  void reserve(size_t n) {
+    if (n <= capacity_)
+      return;
+    const size_t bytes = round_up(n * sizeof(T));
+    auto *fresh = static_cast<T *>(::operator new(bytes, std::align_val_t{Align}));
+    if (size_)
+      std::memcpy(static_cast<void *>(fresh), data_, size_ * sizeof(T));
+    release();
+    data_ = fresh;
+    capacity_ = bytes / sizeof(T);
+  }
+
+  /// Set the size to n. Elements up to min(size(), n) are kept; any new ones
+  /// are uninitialized. Growth is exact, not geometric: these buffers are
+  /// sized once per problem.
+  void uninitialized_resize(size_t n) {
+    reserve(n);
+    size_ = n;
+  }
+
+  void resize(size_t n, const T &value = T{}) {
+    const T copy = value; // `value` may be one of ours, freed by a reallocation
+    const size_t old = size_;
+    uninitialized_resize(n);
+    if (n > old)
+      std::fill(data_ + old, data_ + n, copy);
+  }
+
+  void clear() noexcept { size_ = 0; }
+
+private:
+  static constexpr size_t round_up(size_t bytes) { return (bytes + Align - 1) & ~(Align - 1); }
+
+  void copy_from(const T *src, size_t n) noexcept {
+    if (n)
+      std::memcpy(static_cast<void *>(data_), src, n * sizeof(T));
+  }
+
+  void release() noexcept {
+    if (data_)
+      ::operator delete(data_, std::align_val_t{Align});
+    data_ = nullptr;
+    capacity_ = 0;
+  }
+
+  T *data_ = nullptr;
+  size_t size_ = 0;
+  size_t capacity_ = 0;
+};
+
+} // end of namespace containers
@@ -0,0 +1,140 @@
+#include "memory_block_management.hpp"
+#include "my_timer.h"
+#include "reference_cnt.h"
+#include "small_vector.hpp"
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Tracked {
+  inline static int moves = 0;
+  int value;
+  explicit Tracked(int v) : value(v) {}
+  Tracked(Tracked &&other) noexcept : value(other.value) { ++moves; }
+  Tracked &operator=(Tracked &&other) noexcept {
+    value = other.value;
+    ++moves;
+    return *this;
+  }
+  ~Tracked() = default;
+};
+
+struct OptedIn : Tracked {
+  using trivially_relocatable = containers::relocatable_tag<OptedIn>;
+  using Tracked::Tracked;
+};
+
+// Derived classes inherit the opt-in member, but not the opt-in.
+struct FromOptedIn : OptedIn {
+  using OptedIn::OptedIn;
+};
+struct SelfPointingBlock : BasicMemoryBlock<std::allocator<int>, NoLog> {
+  using BasicMemoryBlock::BasicMemoryBlock;
+  SelfPointingBlock *self = this;
+};
+
+struct Handle : reference_count::Object {};
+
+using Block = BasicMemoryBlock<std::allocator<int>, NoLog>;
+
+} // namespace
+
+static_assert(containers::is_trivially_relocatable_v<int>);
+static_assert(containers::is_trivially_relocatable_v<std::unique_ptr<int>>);
+static_assert(containers::is_trivially_relocatable_v<reference_count::ref<Handle>>);
+static_assert(containers::is_trivially_relocatable_v<MemoryBlock>);
+static_assert(!containers::is_trivially_relocatable_v<Tracked>);
+static_assert(containers::is_trivially_relocatable_v<OptedIn>);
+static_assert(!containers::is_trivially_relocatable_v<FromOptedIn>);
+static_assert(!containers::is_trivially_relocatable_v<SelfPointingBlock>);
+static_assert(!containers::is_trivially_relocatable_v<std::string>);
+
+TEST(relocatable_vector, opt_in_skips_moves) {
+  Tracked::moves = 0;
+  containers::relocatable_vector<OptedIn> v;
+  for (int i = 0; i < 100; ++i)
+    v.emplace_back(i);
+  v.emplace(v.begin() + 50, -1);
+  v.erase(v.begin() + 10, v.begin() + 20);
+  EXPECT_EQ(Tracked::moves, 0);
+  EXPECT_EQ(v.size(), 91);
+  EXPECT_EQ(v[40].value, -1);
+  EXPECT_EQ(v[41].value, 50);
+
+  containers::relocatable_vector<Tracked> w;
+  for (int i = 0; i < 100; ++i)
+    w.emplace_back(i);
+  EXPECT_GT(Tracked::moves, 0);
+}
+
+TEST(relocatable_vector, resource_owners) {
+  containers::relocatable_vector<std::unique_ptr<int>> ptrs;
+  for (int i = 0; i < 10; ++i)
+    ptrs.insert(ptrs.begin(), std::make_unique<int>(i));
+  EXPECT_EQ(*ptrs.front(), 9);
+  EXPECT_EQ(*ptrs.back(), 0);
+  ptrs.erase(ptrs.begin());
+  EXPECT_EQ(*ptrs.front(), 8);
+
+  reference_count::ref<Handle> h{new Handle};
+  {
+    containers::relocatable_vector<reference_count::ref<Handle>> refs;
+    for (int i = 0; i < 100; ++i)
+      refs.push_back(h);
+    refs.insert(refs.begin() + 3, refs[7]); // aliasing an element
+    EXPECT_EQ(h->getRefCount(), 102);
+    refs.erase(refs.begin(), refs.begin() + 50);
+    EXPECT_EQ(h->getRefCount(), 52);
+  }
+  EXPECT_EQ(h->getRefCount(), 1);
+}
+
+namespace {
+
+template <typename Vec, typename Make> uint64_t growth(size_t n, Make make) {
+  Timer t("growth");
+  Vec v;
+  for (size_t i = 0; i < n; ++i)
+    v.push_back(make(i));
+  return t.eclipse();
+}
+
+template <typename Vec, typename Make> uint64_t insert_middle(size_t n, Make make) {
+  Timer t("insert_middle");
+  Vec v;
+  for (size_t i = 0; i < n; ++i)
+    v.insert(v.begin() + static_cast<std::ptrdiff_t>(v.size() / 2), make(i));
+  return t.eclipse();
+}
+
+template <typename T, typename Make>
+void compare(const char *name, size_t grow_n, size_t insert_n, Make make) {
+  auto std_grow = growth<std::vector<T>>(grow_n, make);
+  auto rel_grow = growth<containers::relocatable_vector<T>>(grow_n, make);
+  auto std_insert = insert_middle<std::vector<T>>(insert_n, make);
+  auto rel_insert = insert_middle<containers::relocatable_vector<T>>(insert_n, make);
+#ifndef NDEBUG
+  std::cout << name << ": growth to " << grow_n << " std::vector " << std_grow / 1000000
+            << "ms, relocatable_vector " << rel_grow / 1000000 << "ms; " << insert_n
+            << " mid inserts std::vector " << std_insert / 1000000 << "ms, relocatable_vector "
+            << rel_insert / 1000000 << "ms\n";
+#else
+  (void)name, (void)std_grow, (void)rel_grow, (void)std_insert, (void)rel_insert;
+#endif
+}
+
+} // namespace
+
+TEST(relocatable_vector, benchmark) {
+  constexpr size_t grow_n = 1000000;
+  constexpr size_t insert_n = 20000;
+
+  compare<Block>("MemoryBlock", grow_n, insert_n, [](size_t) { return Block{1}; });
+  compare<std::unique_ptr<int>>("unique_ptr<int>", grow_n, insert_n,
+                                [](size_t i) { return std::make_unique<int>(int(i)); });
+  reference_count::ref<Handle> h{new Handle};
+  compare<reference_count::ref<Handle>>("ref<T>", grow_n, insert_n, [&](size_t) { return h; });
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+// DESCRIPTION:
+//  Trivial relocation: moving an object to a new address and ending its
+//  lifetime at the old one, done as a plain memcpy.
+//
+//  For most resource owners (a pointer plus a length, a smart pointer, a
+//  reference-counted handle) "move-construct the new one, destroy the old
+//  one" is the same as copying the bytes and forgetting the old ones. A
+//  container that knows this can grow or shift its elements with one
+//  memcpy/memmove instead of a move and a destructor call per element.
+//
+//  is_trivially_relocatable<T> is true for trivially copyable types and for
+//  types that opt in, either with a member naming the class itself
+//      using trivially_relocatable = containers::relocatable_tag<T>;
+//  or by specializing the trait. Opting in is a promise: T must not store
+//  pointers into itself or register its address anywhere. A derived class
+//  inherits the member but not the promise: the tag names the base, so the
+//  derived class is not opted in unless it declares its own.
+
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace containers {
+
+/// The opt-in member's type. Relocatable = false opts out, for class
+/// templates where it depends on the parameters.
+template <typename T, bool Relocatable = true>
+struct relocatable_tag : std::bool_constant<Relocatable> {
+  using owner = T;
+};
+
+template <typename T, typename = void>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template <typename T>
+struct is_trivially_relocatable<
+    T, std::enable_if_t<std::is_same_v<typename T::trivially_relocatable::owner, T>>>
+    : std::bool_constant<T::trivially_relocatable::value> {};
+
+/// A unique_ptr is its pointer plus its deleter.
+template <typename T, typename D>
+struct is_trivially_relocatable<std::unique_ptr<T, D>> : is_trivially_relocatable<D> {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+/// Relocate n objects from src to uninitialized dst. The ranges may overlap.
+/// Afterwards the objects live at dst and src is raw memory.
+template <typename T> void relocate_bytes(T *src, size_t n, T *dst) noexcept {
+  static_assert(is_trivially_relocatable_v<T>);
+  if (n)
+    std::memmove(static_cast<void *>(dst), static_cast<const void *>(src), n * sizeof(T));
+}
+
+} // end of namespace containers
@@ -0,0 +1,408 @@
+#pragma once
+
+// DESCRIPTION:
+//  A vector that keeps its first N elements inline, in the object itself, and
+//  only goes to the heap (through its allocator) when it grows past them.
+//  Past N it grows geometrically like std::vector.
+//
+//  Small sizes never allocate, and the elements sit next to the size and
+//  capacity, so a short vector costs no extra cache miss to read.
+//  The price is sizeof(small_vector) >= N * sizeof(T), and moving an inline
+//  vector moves its elements one by one instead of stealing a pointer.
+//
+//  When elements have to change address (growth, moving an inline vector,
+//  shifting the tail for insert/erase) and T is trivially relocatable (see
+//  relocation.hpp), they are moved with one memcpy/memmove rather than a
+//  move-construct + destroy per element; that bypasses the allocator's
+//  construct/destroy for such types.
+//
+//  relocatable_vector<T> is small_vector<T, 0>: no inline buffer, just that
+//  relocation fast path, as a drop-in for std::vector.
+
+#include "relocation.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace containers {
+
+namespace detail {
+
+template <typename T, size_t N> struct InlineStorage {
+  alignas(T) std::byte bytes[N * sizeof(T)];
+  std::byte *get() noexcept { return bytes; }
+  const std::byte *get() const noexcept { return bytes; }
+};
+
+/// N == 0: no buffer at all; its address only marks "not on the heap".
+template <typename T> struct InlineStorage<T, 0> {
+  std::byte *get() noexcept { return reinterpret_cast<std::byte *>(this); }
+  const std::byte *get() const noexcept { return reinterpret_cast<const std::byte *>(this); }
+};
+
+} // namespace detail
+
+template <typename T, size_t N, typename Alloc = std::allocator<T>> class small_vector {
+  using traits = std::allocator_traits<Alloc>;
+
+public:
+  using value_type = T;
+  using allocator_type = Alloc;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T &;
+  using const_reference = const T &;
+  using pointer = T *;
+  using const_pointer = const T *;
+  using iterator = T *;
+  using const_iterator = const T *;
+
+  static constexpr size_t inline_capacity = N;
+
+  small_vector() noexcept(noexcept(Alloc())) = default;
+  explicit small_vector(const Alloc &alloc) noexcept : alloc_(alloc) {}
+
+  explicit small_vector(size_t count, const Alloc &alloc = Alloc()) : alloc_(alloc) {
+    resize(count);
+  }
+  small_vector(size_t count, const T &value, const Alloc &alloc = Alloc()) : alloc_(alloc) {
+    resize(count, value);
+  }
+  small_vector(std::initializer_list<T> init, const Alloc &alloc = Alloc())
+      : small_vector(init.begin(), init.end(), alloc) {}
+
+  template <typename It, typename = typename std::iterator_traits<It>::iterator_category>
+  small_vector(It first, It last, const Alloc &alloc = Alloc()) : alloc_(alloc) {
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag,
+                                    typename std::iterator_traits<It>::iterator_category>)
+      reserve(static_cast<size_t>(std::distance(first, last)));
+    for (; first != last; ++first)
+      emplace_back(*first);
+  }
+
+  small_vector(const small_vector &other)
+      : alloc_(traits::select_on_container_copy_construction(other.alloc_)) {
+    append_copy(other);
+  }
+  small_vector(const small_vector &other, const Alloc &alloc) : alloc_(alloc) { append_copy(other); }
+
+  small_vector(small_vector &&other) noexcept(std::is_nothrow_move_constructible_v<T>)
+      : alloc_(std::move(other.alloc_)) {
+    take(other);
+  }
+  small_vector(small_vector &&other, const Alloc &alloc) : alloc_(alloc) {
+    if (alloc_ == other.alloc_) {
+      take(other);
+    } else {
+      append_move(other);
+      other.clear();
+    }
+  }
+
+  ~small_vector() {
+    destroy_all();
+    release();
+  }
+
+  small_vector &operator=(const small_vector &other) {
+    if (this == &other)
+      return *this;
+    if constexpr (traits::propagate_on_container_copy_assignment::value) {
+      if (alloc_ != other.alloc_) {
+        clear();
+        release();
+        reset_to_inline();
+      }
+      alloc_ = other.alloc_;
+    }
+    clear();
+    append_copy(other);
+    return *this;
+  }
+
+  small_vector &operator=(small_vector &&other) noexcept(
+      (traits::propagate_on_container_move_assignment::value || traits::is_always_equal::value) &&
+      std::is_nothrow_move_constructible_v<T>) {
+    if (this == &other)
+      return *this;
+    destroy_all();
+    size_ = 0;
+    if (traits::propagate_on_container_move_assignment::value || alloc_ == other.alloc_) {
+      release();
+      reset_to_inline();
+      if constexpr (traits::propagate_on_container_move_assignment::value)
+        alloc_ = std::move(other.alloc_);
+      take(other);
+    } else {
+      append_move(other);
+      other.clear();
+    }
+    return *this;
+  }
+
+  small_vector &operator=(std::initializer_list<T> init) {
+    clear();
+    reserve(init.size());
+    for (const T &v : init)
+      emplace_back(v);
+    return *this;
+  }
+
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return alloc_; }
+
+  // Element access
+  reference operator[](size_t i) {
+    assert(i < size_ && "index is out of range");
+    return data_[i];
+  }
+  const_reference operator[](size_t i) const {
+    assert(i < size_ && "index is out of range");
+    return data_[i];
+  }
+  reference at(size_t i) {
+    if (i >= size_)
+      throw std::out_of_range("small_vector::at");
+    return data_[i];
+  }
+  const_reference at(size_t i) const {
+    if (i >= size_)
+      throw std::out_of_range("small_vector::at");
+    return data_[i];
+  }
+  reference front() { return data_[0]; }
+  const_reference front() const { return data_[0]; }
+  reference back() { return data_[size_ - 1]; }
+  const_reference back() const { return data_[size_ - 1]; }
+  T *data() noexcept { return data_; }
+  const T *data() const noexcept { return data_; }
+
+  // Iterators
+  iterator begin() noexcept { return data_; }
+  iterator end() noexcept { return data_ + size_; }
+  const_iterator begin() const noexcept { return data_; }
+  const_iterator end() const noexcept { return data_ + size_; }
+  const_iterator cbegin() const noexcept { return data_; }
+  const_iterator cend() const noexcept { return data_ + size_; }
+
+  // Capacity
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] size_t size() const noexcept { return size_; }
+  [[nodiscard]] size_t capacity() const noexcept { return capacity_; }
+  /// True while the elements live in the inline buffer.
+  [[nodiscard]] bool is_inline() const noexcept { return data_ == inline_data(); }
+
+  void reserve(size_t n) {
+    if (n > capacity_)
+      reallocate(n);
+  }
+
+  void shrink_to_fit() {
+    if (is_inline() || size_ == capacity_)
+      return;
+    if (size_ <= N) {
+      T *old = data_;
+      const size_t old_cap = capacity_;
+      relocate(old, size_, inline_data());
+      traits::deallocate(alloc_, old, old_cap);
+      data_ = inline_data();
+      capacity_ = N;
+    } else {
+      reallocate(size_);
+    }
+  }
+
+  // Modifiers
+  void clear() noexcept {
+    destroy_all();
+    size_ = 0;
+  }
+
+  template <typename... Args> reference emplace_back(Args &&...args) {
+    if (size_ == capacity_)
+      return *grow_and_emplace(size_, std::forward<Args>(args)...);
+    traits::construct(alloc_, data_ + size_, std::forward<Args>(args)...);
+    return data_[size_++];
+  }
+  void push_back(const T &value) { emplace_back(value); }
+  void push_back(T &&value) { emplace_back(std::move(value)); }
+
+  void pop_back() {
+    assert(size_ > 0 && "pop_back on empty small_vector");
+    traits::destroy(alloc_, data_ + --size_);
+  }
+
+  template <typename... Args> iterator emplace(const_iterator pos, Args &&...args) {
+    const size_t index = static_cast<size_t>(pos - data_);
+    if (size_ == capacity_)
+      return grow_and_emplace(index, std::forward<Args>(args)...);
+    if constexpr (kTriviallyRelocatable) {
+      // Build the element aside first: args may refer to the elements we shift.
+      alignas(T) std::byte tmp[sizeof(T)];
+      T *value = reinterpret_cast<T *>(tmp);
+      traits::construct(alloc_, value, std::forward<Args>(args)...);
+      relocate_bytes(data_ + index, size_ - index, data_ + index + 1);
+      relocate_bytes(value, 1, data_ + index);
+      ++size_;
+    } else {
+      emplace_back(std::forward<Args>(args)...);
+      std::rotate(data_ + index, data_ + size_ - 1, data_ + size_);
+    }
+    return data_ + index;
+  }
+  iterator insert(const_iterator pos, const T &value) { return emplace(pos, value); }
+  iterator insert(const_iterator pos, T &&value) { return emplace(pos, std::move(value)); }
+
+  iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+  iterator erase(const_iterator first, const_iterator last) {
+    T *f = data_ + (first - data_);
+    T *l = data_ + (last - data_);
+    if constexpr (kTriviallyRelocatable) {
+      for (T *p = f; p != l; ++p)
+        traits::destroy(alloc_, p);
+      relocate_bytes(l, static_cast<size_t>(end() - l), f);
+    } else {
+      T *new_end = std::move(l, end(), f);
+      for (T *p = new_end; p != end(); ++p)
+        traits::destroy(alloc_, p);
+    }
+    size_ -= static_cast<size_t>(l - f);
+    return f;
+  }
+
+  void resize(size_t n) {
+    reserve(n);
+    while (size_ < n)
+      emplace_back();
+    while (size_ > n)
+      pop_back();
+  }
+  void resize(size_t n, const T &value) {
+    if (n > capacity_ && size_ < n) {
+      const T copy = value; // `value` may be one of our elements
+      reserve(n);
+      while (size_ < n)
+        emplace_back(copy);
+      return;
+    }
+    while (size_ < n)
+      emplace_back(value);
+    while (size_ > n)
+      pop_back();
+  }
+
+  friend bool operator==(const small_vector &a, const small_vector &b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+  }
+
+private:
+  static constexpr bool kTriviallyRelocatable = is_trivially_relocatable_v<T>;
+
+  T *inline_data() noexcept { return reinterpret_cast<T *>(inline_.get()); }
+  const T *inline_data() const noexcept { return reinterpret_cast<const T *>(inline_.get()); }
+
+  /// Move n elements from src to uninitialized dst and end their lifetime at
+  /// src.
+  void relocate(T *src, size_t n, T *dst) {
+    if constexpr (kTriviallyRelocatable) {
+      relocate_bytes(src, n, dst);
+    } else {
+      for (size_t i = 0; i < n; ++i) {
+        traits::construct(alloc_, dst + i, std::move_if_noexcept(src[i]));
+        traits::destroy(alloc_, src + i);
+      }
+    }
+  }
+
+  size_t next_capacity(size_t needed) const {
+    return std::max({needed, capacity_ * 2, size_t{4}});
+  }
+
+  void reallocate(size_t new_cap) {
+    T *fresh = traits::allocate(alloc_, new_cap);
+    relocate(data_, size_, fresh);
+    release();
+    data_ = fresh;
+    capacity_ = new_cap;
+  }
+
+  /// Reallocate with a new element constructed at `index`.
+  template <typename... Args> T *grow_and_emplace(size_t index, Args &&...args) {
+    const size_t new_cap = next_capacity(size_ + 1);
+    T *fresh = traits::allocate(alloc_, new_cap);
+    // Construct the new element first: args may refer to our own elements.
+    try {
+      traits::construct(alloc_, fresh + index, std::forward<Args>(args)...);
+    } catch (...) {
+      traits::deallocate(alloc_, fresh, new_cap);
+      throw;
+    }
+    relocate(data_, index, fresh);
+    relocate(data_ + index, size_ - index, fresh + index + 1);
+    release();
+    data_ = fresh;
+    capacity_ = new_cap;
+    ++size_;
+    return data_ + index;
+  }
+
+  /// Steal other's heap buffer, or move its inline elements over.
+  void take(small_vector &other) {
+    if (other.is_inline()) {
+      relocate(other.data_, other.size_, data_);
+      size_ = other.size_;
+    } else {
+      data_ = other.data_;
+      size_ = other.size_;
+      capacity_ = other.capacity_;
+      other.reset_to_inline();
+    }
+    other.size_ = 0;
+  }
+
+  void append_copy(const small_vector &other) {
+    reserve(size_ + other.size_);
+    for (const T &v : other)
+      traits::construct(alloc_, data_ + size_++, v);
+  }
+
+  void append_move(small_vector &other) {
+    reserve(size_ + other.size_);
+    for (T &v : other)
+      traits::construct(alloc_, data_ + size_++, std::move(v));
+  }
+
+  void destroy_all() noexcept {
+    if constexpr (!std::is_trivially_destructible_v<T>)
+      for (size_t i = 0; i < size_; ++i)
+        traits::destroy(alloc_, data_ + i);
+  }
+
+  /// Free the heap buffer, if any. Elements must already be gone.
+  void release() noexcept {
+    if (!is_inline())
+      traits::deallocate(alloc_, data_, capacity_);
+  }
+
+  void reset_to_inline() noexcept {
+    data_ = inline_data();
+    capacity_ = N;
+  }
+
+  T *data_ = inline_data();
+  size_t size_ = 0;
+  size_t capacity_ = N;
+  [[no_unique_address]] Alloc alloc_{};
+  [[no_unique_address]] detail::InlineStorage<T, N> inline_;
+};
+
+template <typename T, typename Alloc = std::allocator<T>>
+using relocatable_vector = small_vector<T, 0, Alloc>;
+
+} // end of namespace containers
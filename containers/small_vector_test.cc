@@ -0,0 +1,148 @@
+#include "small_vector.hpp"
+#include "my_timer.h"
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// std::allocator that counts the allocations it makes.
+template <typename T> struct CountingAllocator {
+  using value_type = T;
+  inline static size_t allocations = 0;
+
+  CountingAllocator() = default;
+  template <typename U> CountingAllocator(const CountingAllocator<U> &) {}
+
+  T *allocate(size_t n) {
+    ++allocations;
+    return std::allocator<T>{}.allocate(n);
+  }
+  void deallocate(T *p, size_t n) { std::allocator<T>{}.deallocate(p, n); }
+  template <typename U> bool operator==(const CountingAllocator<U> &) const { return true; }
+};
+
+} // namespace
+
+TEST(small_vector, inline_then_heap) {
+  using Alloc = CountingAllocator<int>;
+  Alloc::allocations = 0;
+
+  containers::small_vector<int, 4, Alloc> v;
+  for (int i = 0; i < 4; ++i)
+    v.push_back(i);
+  EXPECT_TRUE(v.is_inline());
+  EXPECT_EQ(Alloc::allocations, 0);
+
+  v.push_back(v[0]); // aliasing an element while growing
+  EXPECT_FALSE(v.is_inline());
+  EXPECT_EQ(Alloc::allocations, 1);
+  EXPECT_EQ(v.size(), 5);
+  EXPECT_EQ(v.back(), 0);
+
+  for (int i = 0; i < 100; ++i)
+    v.push_back(i);
+  EXPECT_LE(Alloc::allocations, 7); // geometric growth
+
+  v.erase(v.begin() + 5, v.end());
+  v.shrink_to_fit();
+  EXPECT_FALSE(v.is_inline()); // 5 elements still don't fit inline
+  v.pop_back();
+  v.shrink_to_fit();
+  EXPECT_TRUE(v.is_inline());
+  EXPECT_EQ(v, (containers::small_vector<int, 4, Alloc>{0, 1, 2, 3}));
+}
+
+TEST(small_vector, non_trivial_elements) {
+  using Vec = containers::small_vector<std::string, 2>;
+  const std::string big(64, 'x'); // not SSO, so moves must not copy buffers
+
+  Vec a{"one", big};
+  const char *heap_chars = a[1].data();
+  a.push_back("three"); // spills: strings are moved, not copied
+  EXPECT_EQ(a[1].data(), heap_chars);
+
+  Vec b = a;
+  EXPECT_EQ(a, b);
+  b.insert(b.begin(), "zero");
+  EXPECT_EQ(b.front(), "zero");
+  EXPECT_EQ(b[2], big);
+  b.erase(b.begin() + 1);
+  EXPECT_EQ(b[1], big);
+
+  // A heap vector hands its buffer over; an inline one moves element-wise.
+  Vec c = std::move(b);
+  EXPECT_TRUE(b.empty());
+  EXPECT_EQ(c.size(), 3);
+  Vec d{"only"};
+  Vec e = std::move(d);
+  EXPECT_TRUE(e.is_inline());
+  EXPECT_EQ(e[0], "only");
+
+  e = c;
+  EXPECT_EQ(e, c);
+  e.resize(1);
+  EXPECT_EQ(e, Vec{"zero"});
+  EXPECT_THROW(e.at(1), std::out_of_range);
+}
+
+TEST(small_vector, allocator_aware) {
+  std::pmr::monotonic_buffer_resource pool;
+  using Vec = containers::small_vector<int, 2, std::pmr::polymorphic_allocator<int>>;
+
+  Vec a{&pool};
+  for (int i = 0; i < 10; ++i)
+    a.push_back(i);
+  EXPECT_EQ(a.get_allocator().resource(), &pool);
+
+  // polymorphic_allocator does not propagate: a default-resource copy
+  // gets its own storage and keeps its allocator.
+  Vec b;
+  b = a;
+  EXPECT_EQ(b, a);
+  EXPECT_EQ(b.get_allocator().resource(), std::pmr::get_default_resource());
+  b = std::move(a);
+  EXPECT_EQ(b.size(), 10);
+  EXPECT_EQ(b.get_allocator().resource(), std::pmr::get_default_resource());
+}
+
+namespace {
+
+/// Build, sum and drop `rounds` vectors of `n` ints.
+template <typename Vec> uint64_t build_and_drop(size_t n, size_t rounds, long &checksum) {
+  Timer t("build_and_drop");
+  for (size_t r = 0; r < rounds; ++r) {
+    Vec v;
+    for (size_t i = 0; i < n; ++i)
+      v.push_back(static_cast<int>(i + r));
+    checksum += std::accumulate(v.begin(), v.end(), 0L);
+  }
+  return t.eclipse();
+}
+
+} // namespace
+
+TEST(small_vector, small_sizes_benchmark) {
+  constexpr size_t rounds = 200000;
+
+#ifndef NDEBUG
+  std::cout << "n   std::vector  small_vector<int, 8>  small_vector<int, 16>  (ns per vector)\n";
+#endif
+  for (size_t n = 0; n <= 16; ++n) {
+    long a = 0, b = 0, c = 0;
+    auto vec = build_and_drop<std::vector<int>>(n, rounds, a);
+    auto sv8 = build_and_drop<containers::small_vector<int, 8>>(n, rounds, b);
+    auto sv16 = build_and_drop<containers::small_vector<int, 16>>(n, rounds, c);
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(a, c);
+#ifndef NDEBUG
+    std::cout << n << (n < 10 ? "   " : "  ") << static_cast<double>(vec) / rounds << "  "
+              << static_cast<double>(sv8) / rounds << "  " << static_cast<double>(sv16) / rounds
+              << '\n';
+#else
+    (void)vec, (void)sv8, (void)sv16;
+#endif
+  }
+}
@@ -1,11 +1,8 @@
 #if __cplusplus >= 202002L
 
-#ifdef __APPLE__
-
 #include <algorithm>
 #include <array>
 #include <atomic>
-#include <format>
 #include <gtest/gtest.h>
 #include <iostream>
 #include <random>
@@ -19,37 +16,41 @@ namespace {
 
 // std::atomic_ref
 //  * `std::atomic_ref` is a template class introduced in C++20, and it is part
-//  of
-//    the `<atomic>` header.
-//  * It is designed to provide atomic-like operations on non-atomic variables
-//    or non-atomic parts of atomic variables.
-//  * Unlike `std::atomic`, it does not introduce any overhead or memory
-//    synchronization, making it useful for fine-grained atomic-like operations
-//    within a single thread.
-// It's important to note that `std::atomic_ref` does not provide atomic
-// guarantees across threads. It is meant for cases where atomic-like operations
-// are needed within a single thread, without the need for full memory
-// synchronization.
-// `std::atomic` is used for creating variables with atomic operations and
-// synchronization across threads, while `std::atomic_ref` is used for
-// atomic-like operations on non-atomic variables within a single thread
-// without introducing the synchronization overhead. The introduction of
-// `std::atomic_ref` in C++20 provides a way to perform certain atomic-like
-// operations more efficiently when full atomicity and synchronization are not
-// necessary.
-//
-// `std::atomic_ref` is a C++20 feature that provides atomic-like operations on
-// non-atomic variables or non-atomic parts of atomic variables within a single
-// thread. Here's a simple example using `std::atomic_ref`:
+//    of the `<atomic>` header.
+//  * It applies atomic operations to an object that is not itself declared
+//    `std::atomic`, e.g. an element of a plain array.
+//  * While any `std::atomic_ref` referencing an object exists, the object must
+//    only be accessed through `std::atomic_ref` instances. Operations through
+//    them are atomic with respect to each other, across threads, with the
+//    usual memory orders.
+//  * The object must be aligned to `std::atomic_ref<T>::required_alignment`.
+// This lets a data structure stay a plain array for the single-threaded phases
+// of a program and be updated atomically only in the parallel phase.
+// Here's a simple example using `std::atomic_ref`:
 
 void basic_test() {
   int value = 42;
 
   // Create an atomic reference to a non-atomic variable
+  {
+    std::atomic_ref<int> ref{value};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+      threads.emplace_back([ref] {
+        for (int j = 0; j < 1000; ++j)
+          ref.fetch_add(1, std::memory_order_relaxed);
+      });
+    for (auto &t : threads)
+      t.join();
+  }
+
+  // Once no atomic_ref is alive, the object can be accessed normally again.
+  EXPECT_EQ(value, 4042);
 }
 
 } // namespace
 
-#endif // __APPLE__
+// See concurrent/histogram/histogram.h for atomic_ref applied to whole arrays.
+TEST(atomic_ref_test, basic_test) { basic_test(); }
 
 #endif // __cplusplus >= 202002L
@@ -2,6 +2,7 @@
 
 #ifdef __APPLE__
 
+#include "async_logger.h"
 #include <barrier>
 #include <cmath>
 #include <format>
@@ -74,12 +75,9 @@ void barrier_test() {
 // Full-time and part-time workers.
 
 std::barrier work_done{6};
-std::mutex cout_mutex;
-
-void synchronized_out(const std::string &s) noexcept {
-  std::lock_guard<std::mutex> lo(cout_mutex);
-  std::cout << s;
-}
+// Workers log through per-thread rings instead of serializing on a global
+// mutex around std::cout; see concurrent/async_logger/async_logger.h.
+void synchronized_out(const std::string &s) noexcept { async_logger::stdout_logger().log(s); }
 
 class FullTimeWorker {
 public:
@@ -2,6 +2,7 @@
 
 #ifdef __APPLE__
 
+#include "async_logger.h"
 #include <gtest/gtest.h>
 #include <array>
 #include <thread>
@@ -55,12 +56,9 @@ void latch_basic_test() {
 std::latch work_done{6};
 std::latch go_home{1};
 
-std::mutex cout_mutex;
-
-void synchronized_out(const std::string &s) {
-  std::lock_guard<std::mutex> lo(cout_mutex);
-  std::cout << s;
-}
+// Workers log through per-thread rings instead of serializing on a global
+// mutex around std::cout; see concurrent/async_logger/async_logger.h.
+void synchronized_out(const std::string &s) { async_logger::stdout_logger().log(s); }
 
 class Worker {
 public:
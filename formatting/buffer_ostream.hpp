@@ -0,0 +1,274 @@
+#pragma once
+
+// DESCRIPTION:
+//  An std::ostream that writes into a plain char buffer.
+//
+//    char buf[256];
+//    formatting::buffer_ostream os(buf);
+//    write_something(os);          // any code taking std::ostream &
+//    std::string_view text = os.view();
+//
+//  A std::stringstream heap-allocates its string and grows it as it
+//  goes. Each << also builds a sentry and formats numbers through the
+//  locale's num_put facet. Here:
+//
+//  * the buffer is the caller's: a fixed array (past its end the stream
+//    goes bad, like any failed write), or a first buffer that grows
+//    through a std::pmr::memory_resource, e.g. an allocators::Arena;
+//  * << of an integer, float, double, char or string, made on the
+//    buffer_ostream itself, writes straight into the buffer with
+//    write_int / std::to_chars. It skips the sentry and the facet;
+//  * the output is the same as std::ostream's. The shortcut applies only
+//    under the flags it reproduces (no width, decimal integers, no
+//    showpos or showpoint, "C" locale) and falls back to std::ostream
+//    for everything else. Code that takes std::ostream & goes through
+//    the ordinary std::ostream path and still works, just without the
+//    shortcut.
+
+#include "number_format.hpp"
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <locale>
+#include <memory_resource>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+namespace formatting {
+
+namespace detail {
+
+/// The put area is the buffer; overflow() grows it, if there is an
+/// upstream resource to grow into.
+class ostream_buffer : public std::streambuf {
+public:
+  ostream_buffer(char *data, size_t size, std::pmr::memory_resource *upstream)
+      : upstream_(upstream), classic_(getloc() == std::locale::classic()) {
+    setp(data, data + size);
+  }
+  ostream_buffer(const ostream_buffer &) = delete;
+  ostream_buffer &operator=(const ostream_buffer &) = delete;
+  ~ostream_buffer() override { release(); }
+
+  /// Room for n more chars at pptr(), or nullptr if the buffer is fixed
+  /// and full.
+  char *reserve(size_t n) {
+    if (static_cast<size_t>(epptr() - pptr()) >= n || grow(n))
+      return pptr();
+    return nullptr;
+  }
+
+  /// Move pptr() to `end`, after writing [pptr(), end).
+  void commit(char *end) noexcept { advance(static_cast<size_t>(end - pptr())); }
+
+  [[nodiscard]] std::string_view view() const noexcept {
+    return {pbase(), static_cast<size_t>(pptr() - pbase())};
+  }
+  [[nodiscard]] size_t capacity() const noexcept {
+    return static_cast<size_t>(epptr() - pbase());
+  }
+  [[nodiscard]] bool classic() const noexcept { return classic_; }
+
+  /// Start over at the beginning of the current buffer.
+  void clear() noexcept { setp(pbase(), epptr()); }
+
+protected:
+  int_type overflow(int_type c) override {
+    if (traits_type::eq_int_type(c, traits_type::eof()))
+      return traits_type::not_eof(c);
+    if (!reserve(1))
+      return traits_type::eof();
+    *pptr() = traits_type::to_char_type(c);
+    advance(1);
+    return c;
+  }
+
+  std::streamsize xsputn(const char *s, std::streamsize count) override {
+    auto n = static_cast<size_t>(count);
+    if (!reserve(n))
+      n = static_cast<size_t>(epptr() - pptr()); // fixed: write what fits
+    std::memcpy(pptr(), s, n);
+    advance(n);
+    return static_cast<std::streamsize>(n);
+  }
+
+  void imbue(const std::locale &loc) override { classic_ = loc == std::locale::classic(); }
+
+private:
+  void advance(size_t n) noexcept {
+    for (; n > INT_MAX; n -= INT_MAX)
+      pbump(INT_MAX);
+    pbump(static_cast<int>(n));
+  }
+
+  bool grow(size_t n) {
+    if (!upstream_)
+      return false;
+    const size_t used = view().size();
+    const size_t size = std::max({capacity() * 2, used + n, size_t{256}});
+    auto *data = static_cast<char *>(upstream_->allocate(size, 1));
+    if (used) // pbase() may be null
+      std::memcpy(data, pbase(), used);
+    release();
+    owned_ = size;
+    setp(data, data + size);
+    advance(used);
+    return true;
+  }
+
+  void release() noexcept {
+    if (owned_)
+      upstream_->deallocate(pbase(), owned_, 1);
+    owned_ = 0;
+  }
+
+  std::pmr::memory_resource *upstream_; // null: fixed buffer
+  size_t owned_ = 0;                    // size of the buffer, if upstream_ allocated it
+  bool classic_;
+};
+
+/// Built before the std::ostream base, which needs the buffer.
+struct ostream_buffer_holder {
+  ostream_buffer buffer_;
+};
+
+} // end of namespace detail
+
+class buffer_ostream : private detail::ostream_buffer_holder, public std::ostream {
+public:
+  /// Write into [data, data + size) and nowhere else. Output past the end
+  /// is cut off and sets badbit.
+  buffer_ostream(char *data, size_t size)
+      : ostream_buffer_holder{{data, size, nullptr}}, std::ostream(&buffer_) {}
+  template <size_t N> explicit buffer_ostream(char (&data)[N]) : buffer_ostream(data, N) {}
+
+  /// Start in [data, data + size), which may be empty, and grow through
+  /// `upstream` when it fills up.
+  buffer_ostream(char *data, size_t size, std::pmr::memory_resource *upstream)
+      : ostream_buffer_holder{{data, size, upstream}}, std::ostream(&buffer_) {}
+  explicit buffer_ostream(std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+      : buffer_ostream(nullptr, 0, upstream) {}
+
+  buffer_ostream(const buffer_ostream &) = delete;
+  buffer_ostream &operator=(const buffer_ostream &) = delete;
+
+  [[nodiscard]] std::string_view view() const noexcept { return buffer_.view(); }
+  [[nodiscard]] size_t size() const noexcept { return view().size(); }
+  [[nodiscard]] std::string str() const { return std::string(view()); }
+
+  /// Drop the text and any error state; the buffer is kept.
+  void reset() noexcept {
+    buffer_.clear();
+    std::ostream::clear();
+  }
+
+  // The fast paths. Anything else, and these under other flags, is
+  // std::ostream's.
+  using std::ostream::operator<<;
+
+  // Non-templates, so that they hide std::ostream's rather than lose to them.
+  buffer_ostream &operator<<(short value) { return put_integer(value); }
+  buffer_ostream &operator<<(unsigned short value) { return put_integer(value); }
+  buffer_ostream &operator<<(int value) { return put_integer(value); }
+  buffer_ostream &operator<<(unsigned value) { return put_integer(value); }
+  buffer_ostream &operator<<(long value) { return put_integer(value); }
+  buffer_ostream &operator<<(unsigned long value) { return put_integer(value); }
+  buffer_ostream &operator<<(long long value) { return put_integer(value); }
+  buffer_ostream &operator<<(unsigned long long value) { return put_integer(value); }
+
+  buffer_ostream &operator<<(double value) {
+    constexpr auto floatfield = std::ios_base::fixed | std::ios_base::scientific;
+    const auto style = flags() & floatfield;
+    if (style != floatfield &&
+        plain(std::ios_base::showpos | std::ios_base::showpoint | std::ios_base::uppercase)) {
+      // What %g, %f or %e with this precision writes, as std::ostream does.
+      const auto chars = style == std::ios_base::fixed        ? std::chars_format::fixed
+                         : style == std::ios_base::scientific ? std::chars_format::scientific
+                                                              : std::chars_format::general;
+      const auto precision = static_cast<int>(precision_or_default());
+      char buf[64]; // a value that needs more is left to std::ostream
+      if (const auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value, chars, precision);
+          ec == std::errc()) {
+        return write_bytes(buf, static_cast<size_t>(end - buf));
+      }
+    }
+    std::ostream::operator<<(value);
+    return *this;
+  }
+  buffer_ostream &operator<<(float value) { return *this << static_cast<double>(value); }
+
+  buffer_ostream &operator<<(std::string_view s) {
+    if (plain())
+      return write_bytes(s.data(), s.size());
+    static_cast<std::ostream &>(*this) << s;
+    return *this;
+  }
+  buffer_ostream &operator<<(const std::string &s) { return *this << std::string_view(s); }
+  buffer_ostream &operator<<(const char *s) {
+    if (s)
+      return *this << std::string_view(s);
+    static_cast<std::ostream &>(*this) << s; // sets badbit
+    return *this;
+  }
+
+  buffer_ostream &operator<<(char c) {
+    if (plain())
+      return write_bytes(&c, 1);
+    static_cast<std::ostream &>(*this) << c;
+    return *this;
+  }
+  // std::ostream writes these as characters too. Without them, int8_t and
+  // uint8_t would pick the int overload above (or be ambiguous).
+  buffer_ostream &operator<<(signed char c) { return *this << static_cast<char>(c); }
+  buffer_ostream &operator<<(unsigned char c) { return *this << static_cast<char>(c); }
+
+  /// Manipulators keep the chain on buffer_ostream.
+  buffer_ostream &operator<<(std::ostream &(*manipulator)(std::ostream &)) {
+    manipulator(*this);
+    return *this;
+  }
+  buffer_ostream &operator<<(std::ios_base &(*manipulator)(std::ios_base &)) {
+    manipulator(*this);
+    return *this;
+  }
+
+private:
+  template <typename T> buffer_ostream &put_integer(T value) {
+    if (plain(std::ios_base::oct | std::ios_base::hex | std::ios_base::showpos)) {
+      if (char *p = buffer_.reserve(max_chars<T>)) {
+        buffer_.commit(write_int(p, value));
+        return *this;
+      }
+    }
+    std::ostream::operator<<(value);
+    return *this;
+  }
+
+  /// Whether std::ostream would write the value as-is: stream good, no
+  /// width to pad to, "C" locale, and none of `unhandled` set.
+  [[nodiscard]] bool plain(std::ios_base::fmtflags unhandled = {}) const {
+    return rdstate() == std::ios_base::goodbit && width() == 0 && !(flags() & unhandled) &&
+           buffer_.classic();
+  }
+
+  /// A negative precision means printf's default.
+  [[nodiscard]] std::streamsize precision_or_default() const {
+    return precision() < 0 ? 6 : precision();
+  }
+
+  buffer_ostream &write_bytes(const char *s, size_t n) {
+    if (char *p = buffer_.reserve(n)) {
+      std::memcpy(p, s, n);
+      buffer_.commit(p + n);
+    } else {
+      write(s, static_cast<std::streamsize>(n)); // fixed and full: cut off, badbit
+    }
+    return *this;
+  }
+};
+
+} // end of namespace formatting
@@ -0,0 +1,249 @@
+#include "arena.hpp"
+#include "buffer_ostream.hpp"
+#include "my_timer.h"
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <memory_resource>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// The same function as io/io_test.cc's.
+void write_something(std::ostream &os) {
+  os << "Hi stream, did you know that 3 * 3 = " << 3 * 3 << std::endl;
+}
+
+/// Counts the calls that reach the upstream resource.
+class CountingResource : public std::pmr::memory_resource {
+public:
+  size_t allocations = 0;
+
+private:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    ++allocations;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+};
+
+/// Write v through both streams, with the same flags set by `setup`.
+template <typename T, typename Setup> void expect_same(T v, Setup &&setup) {
+  std::ostringstream expected;
+  formatting::buffer_ostream ours;
+  setup(expected);
+  setup(ours);
+  expected << v << '|';
+  ours << v << '|';
+  ASSERT_EQ(ours.view(), expected.view()) << std::hexfloat << v;
+}
+
+} // namespace
+
+TEST(buffer_ostream, works_as_std_ostream) {
+  char buf[128];
+  formatting::buffer_ostream os(buf);
+  write_something(os);
+  EXPECT_EQ(os.view(), "Hi stream, did you know that 3 * 3 = 9\n");
+  EXPECT_EQ(os.view().data(), buf);
+
+  os.reset();
+  os << 1 << ' ' << -2L << ' ' << 3u << ' ' << 1.5 << ' ' << 0.25f << ' ' << true << ' '
+     << std::string("str") << ' ' << std::string_view("sv") << ' ' << "lit" << ' ' << 'c'
+     << ' ' << static_cast<signed char>('s') << ' ' << std::hex << 255 << ' ' << std::dec
+     << std::setw(4) << 7 << ' ' << std::setfill('*') << std::left << std::setw(5) << "ab";
+  EXPECT_EQ(os.str(), "1 -2 3 1.5 0.25 1 str sv lit c s ff    7 ab***");
+
+  // Narrow integer types are characters, as on std::ostream.
+  os.reset();
+  os << std::setfill(' ') << std::right;
+  os << static_cast<signed char>('s') << static_cast<unsigned char>('u') << int8_t{'i'}
+     << uint8_t{'8'} << std::setw(3) << uint8_t{'w'};
+  EXPECT_EQ(os.view(), "sui8  w");
+}
+
+TEST(buffer_ostream, numbers_match_ostringstream) {
+  using Setup = void (*)(std::ostream &);
+  Setup none = [](std::ostream &) {};
+  Setup fixed3 = [](std::ostream &os) { os << std::fixed << std::setprecision(3); };
+  Setup sci = [](std::ostream &os) { os << std::scientific; };
+  Setup precise = [](std::ostream &os) { os << std::setprecision(17); };
+  Setup zero = [](std::ostream &os) { os << std::setprecision(0); };
+  Setup showpos = [](std::ostream &os) { os << std::showpos; };
+  Setup hex = [](std::ostream &os) { os << std::hex << std::showbase << std::uppercase; };
+  Setup wide = [](std::ostream &os) { os << std::setw(12) << std::internal; };
+
+  using L = std::numeric_limits<double>;
+  std::vector<double> doubles = {0.0,        -0.0,         1.0,           0.1,
+                                 1.0 / 3,    1e21,         1e-7,          123456789.0,
+                                 L::max(),   L::lowest(),  L::min(),      L::denorm_min(),
+                                 L::infinity(), -L::infinity(), L::quiet_NaN(), 1e300};
+  std::mt19937_64 rng(5);
+  for (int i = 0; i < 20000; ++i) {
+    const double bits = std::bit_cast<double>(rng());
+    doubles.push_back(std::isnan(bits) ? 0.5 : bits);
+    doubles.push_back(static_cast<double>(rng() % 1000000) / 100);
+  }
+  for (double v : doubles)
+    for (auto setup : {none, fixed3, sci, precise, zero, showpos, wide})
+      expect_same(v, setup);
+  for (float v : {0.1f, 3.14159f, -1e30f})
+    expect_same(v, none);
+
+  std::vector<int64_t> ints = {0, 1, -1, INT64_MIN, INT64_MAX};
+  for (int i = 0; i < 20000; ++i)
+    ints.push_back(static_cast<int64_t>(rng() >> (rng() % 64)) * (i % 2 ? 1 : -1));
+  for (int64_t v : ints) {
+    for (auto setup : {none, showpos, hex, wide}) {
+      expect_same(v, setup);
+      expect_same(static_cast<int>(v), setup);
+      expect_same(static_cast<unsigned short>(v), setup);
+      expect_same(static_cast<uint64_t>(v), setup);
+    }
+  }
+
+  // A non-"C" locale goes to std::ostream, which groups the digits.
+  struct grouping : std::numpunct<char> {
+    char do_thousands_sep() const override { return ','; }
+    std::string do_grouping() const override { return "\3"; }
+  };
+  const std::locale grouped(std::locale::classic(), new grouping);
+  expect_same(1234567, [&](std::ostream &os) { os.imbue(grouped); });
+}
+
+TEST(buffer_ostream, fixed_and_growing_buffers) {
+  // Fixed: output past the end is cut off and the stream goes bad.
+  char small[8];
+  formatting::buffer_ostream fixed(small);
+  fixed << 12345 << "678";
+  EXPECT_TRUE(fixed.good());
+  EXPECT_EQ(fixed.view(), "12345678");
+  fixed << 9;
+  EXPECT_TRUE(fixed.bad());
+  EXPECT_EQ(fixed.view(), "12345678");
+  fixed.reset();
+  fixed << "abcdefghij";
+  EXPECT_TRUE(fixed.bad());
+  EXPECT_EQ(fixed.view(), "abcdefgh");
+
+  // Growing: starts on the stack, moves to the resource once it is full.
+  CountingResource counting;
+  char first[64];
+  formatting::buffer_ostream growing(first, sizeof(first), &counting);
+  std::ostringstream expected;
+  for (int i = 0; i < 10; ++i) {
+    growing << i << ',';
+    expected << i << ',';
+  }
+  EXPECT_EQ(counting.allocations, 0);
+  EXPECT_EQ(growing.view().data(), first);
+  for (int i = 0; i < 100000; ++i) {
+    growing << i << ',' << i * 0.5 << ';';
+    expected << i << ',' << i * 0.5 << ';';
+  }
+  EXPECT_EQ(growing.view(), expected.view());
+  EXPECT_LE(counting.allocations, 20); // doubling
+
+  // Reused after reset(), the buffer has room and nothing is allocated.
+  const size_t before = counting.allocations;
+  for (int round = 0; round < 3; ++round) {
+    growing.reset();
+    growing << expected.view();
+  }
+  EXPECT_EQ(counting.allocations, before);
+
+  // Into an arena.
+  allocators::Arena arena(4096);
+  formatting::buffer_ostream in_arena(&arena);
+  write_something(in_arena);
+  EXPECT_EQ(in_arena.view(), "Hi stream, did you know that 3 * 3 = 9\n");
+  EXPECT_EQ(arena.chunk_count(), 1);
+}
+
+TEST(buffer_ostream, field_benchmark) {
+  constexpr size_t records = 200000;
+  constexpr size_t fields = 5; // id, price, name, qty, separator char
+  struct Record {
+    uint64_t id;
+    double price;
+    std::string_view name;
+    int qty;
+  };
+  const std::string_view names[] = {"apple", "banana", "cherry", "dragon fruit"};
+  std::vector<Record> data;
+  std::mt19937_64 rng(11);
+  for (size_t i = 0; i < records; ++i)
+    data.push_back({rng(), static_cast<double>(rng() % 100000) / 100, names[i % 4],
+                    static_cast<int>(rng() % 1000) - 500});
+
+  auto write = [&](auto &os, const Record &r) {
+    os << r.id << ' ' << r.price << ' ' << r.name << ' ' << r.qty << '\n';
+  };
+  auto per_field = [&](Timer &t) { return static_cast<double>(t.eclipse()) / (records * fields); };
+
+  // A fresh stringstream per record, as in io_test's streamTest.
+  size_t length = 0;
+  Timer t1("stringstream per record");
+  for (const auto &r : data) {
+    std::stringstream ss;
+    write(ss, r);
+    length += ss.str().size();
+  }
+  const double fresh_ns = per_field(t1);
+
+  std::stringstream reused;
+  Timer t2("stringstream, one");
+  for (const auto &r : data)
+    write(reused, r);
+  const double reused_ns = per_field(t2);
+
+  char stack[256];
+  size_t fixed_length = 0;
+  formatting::buffer_ostream fixed(stack);
+  Timer t3("buffer_ostream per record");
+  for (const auto &r : data) {
+    fixed.reset();
+    write(fixed, r);
+    fixed_length += fixed.size();
+  }
+  const double fixed_ns = per_field(t3);
+  EXPECT_EQ(fixed_length, length);
+
+  allocators::Arena arena;
+  formatting::buffer_ostream growing(&arena);
+  Timer t4("buffer_ostream, one");
+  for (const auto &r : data)
+    write(growing, r);
+  const double growing_ns = per_field(t4);
+  EXPECT_EQ(growing.view(), reused.view());
+
+  // Through std::ostream &: correct, but no shortcut.
+  formatting::buffer_ostream base(&arena);
+  Timer t5("buffer_ostream as std::ostream");
+  for (const auto &r : data)
+    write(static_cast<std::ostream &>(base), r);
+  const double base_ns = per_field(t5);
+  EXPECT_EQ(base.view(), reused.view());
+
+#ifndef NDEBUG
+  std::cout << "ns per field: stringstream per record " << fresh_ns << ", stringstream reused "
+            << reused_ns << ", buffer_ostream per record " << fixed_ns
+            << ", buffer_ostream growing " << growing_ns << ", as std::ostream & " << base_ns
+            << '\n';
+#else
+  (void)fresh_ns, (void)reused_ns, (void)fixed_ns, (void)growing_ns, (void)base_ns;
+#endif
+}
@@ -0,0 +1,447 @@
+#pragma once
+
+// DESCRIPTION:
+//  Number <-> text conversion into caller-provided buffers.
+//
+//  * write_int(out, v) counts the digits once, then fills them in back to
+//    front two at a time from a table of the 100 digit pairs: one division
+//    by 100 per two digits, no locale, no stream state.
+//  * write_double(out, v) writes the shortest text that reads back as
+//    exactly v, using Ryu (Ulf Adams, PLDI 2018): the mantissa and the two
+//    ends of its rounding interval are scaled by one 128-bit power of 5,
+//    and digits are dropped while the interval still pins v down. Fixed or
+//    scientific notation, whichever is shorter, so the text is the same as
+//    std::to_chars(first, last, v) gives.
+//  * parse<T>(text) reads either back with std::from_chars, but requires
+//    the whole text to be the number and also takes a leading '+'.
+//
+//  The writers return one past the last char written, write no NUL, and
+//  never write more than max_chars<T>.
+//
+//  Ryu's tables of 5^i and 2^k / 5^i are computed at compile time with a
+//  small bignum rather than pasted in as 668 hex literals.
+
+#include <array>
+#include <bit>
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+namespace formatting {
+
+/// Buffer size that always fits write_int / write_double output.
+template <typename T>
+inline constexpr size_t max_chars = std::numeric_limits<T>::digits10 + 1 + std::is_signed_v<T>;
+template <> inline constexpr size_t max_chars<double> = 24; // -2.2250738585072014e-308
+
+namespace detail {
+
+inline constexpr auto kDigitPairs = [] {
+  std::array<char, 200> pairs{};
+  for (int i = 0; i < 100; ++i) {
+    pairs[2 * i] = static_cast<char>('0' + i / 10);
+    pairs[2 * i + 1] = static_cast<char>('0' + i % 10);
+  }
+  return pairs;
+}();
+
+inline constexpr int count_digits(uint64_t v) noexcept {
+  constexpr auto kPow10 = [] {
+    std::array<uint64_t, 20> p{};
+    p[0] = 1;
+    for (size_t i = 1; i < p.size(); ++i)
+      p[i] = p[i - 1] * 10;
+    return p;
+  }();
+  // 1233 / 4096 is just above log10(2), so t is floor(log10(v)) or one less.
+  // v | 1 has as many digits as v, and one for zero.
+  v |= 1;
+  const int t = static_cast<int>((std::bit_width(v) * 1233) >> 12);
+  return t + (v >= kPow10[t]);
+}
+
+/// Write v as n decimal digits, zero-padded on the left, to [out, out + n).
+inline char *write_digits(char *out, uint64_t v, int n) noexcept {
+  char *p = out + n;
+  while (v >= 100) {
+    p -= 2;
+    std::memcpy(p, &kDigitPairs[(v % 100) * 2], 2);
+    v /= 100;
+  }
+  if (v >= 10) {
+    p -= 2;
+    std::memcpy(p, &kDigitPairs[v * 2], 2);
+  } else {
+    *--p = static_cast<char>('0' + v);
+  }
+  while (p > out)
+    *--p = '0';
+  return out + n;
+}
+
+/// Decimal digits of v < 10^38.
+inline char *write_u128(char *out, unsigned __int128 v) noexcept {
+  constexpr uint64_t k1e19 = 10000000000000000000u;
+  if (v < k1e19)
+    return write_digits(out, static_cast<uint64_t>(v), count_digits(static_cast<uint64_t>(v)));
+  const auto high = static_cast<uint64_t>(v / k1e19);
+  out = write_digits(out, high, count_digits(high));
+  return write_digits(out, static_cast<uint64_t>(v % k1e19), 19);
+}
+
+// ---- Ryu tables ----
+
+struct u128 {
+  uint64_t lo, hi;
+};
+
+inline constexpr int kPow5Bits = 125; // significant bits kept per table entry
+inline constexpr int kPow5Count = 326;
+inline constexpr int kPow5InvCount = 342;
+
+/// Unsigned integer of Words 32-bit words, little-endian; enough to build
+/// the tables.
+template <size_t Words> struct bignum {
+  std::array<uint32_t, Words> w{};
+
+  constexpr void mul_small(uint32_t m) {
+    uint64_t carry = 0;
+    for (auto &x : w) {
+      const uint64_t t = uint64_t{x} * m + carry;
+      x = static_cast<uint32_t>(t);
+      carry = t >> 32;
+    }
+  }
+  constexpr void div_small(uint32_t d) {
+    uint64_t rem = 0;
+    for (size_t i = Words; i-- > 0;) {
+      const uint64_t t = (rem << 32) | w[i];
+      w[i] = static_cast<uint32_t>(t / d);
+      rem = t % d;
+    }
+  }
+  [[nodiscard]] constexpr int bit_length() const {
+    for (size_t i = Words; i-- > 0;)
+      if (w[i])
+        return static_cast<int>(i * 32 + std::bit_width(w[i]));
+    return 0;
+  }
+  /// Bits [from, from + 128); a negative `from` shifts in zeros below.
+  [[nodiscard]] constexpr u128 bits(int from) const {
+    u128 r{};
+    for (int i = 0; i < 128; ++i) {
+      const int b = from + i;
+      if (b < 0 || b >= static_cast<int>(Words * 32) || !((w[b / 32] >> (b % 32)) & 1))
+        continue;
+      (i < 64 ? r.lo : r.hi) |= uint64_t{1} << (i % 64);
+    }
+    return r;
+  }
+};
+
+/// 5^i, scaled to exactly kPow5Bits bits.
+inline constexpr auto kPow5 = [] {
+  std::array<u128, kPow5Count> table{};
+  bignum<26> p;
+  p.w[0] = 1;
+  for (auto &entry : table) {
+    entry = p.bits(p.bit_length() - kPow5Bits);
+    p.mul_small(5);
+  }
+  return table;
+}();
+
+/// floor(2^(bits(5^q) - 1 + kPow5Bits) / 5^q) + 1.
+inline constexpr auto kPow5Inv = [] {
+  std::array<u128, kPow5InvCount> table{};
+  bignum<26> p;
+  p.w[0] = 1;
+  bignum<30> x; // floor(2^959 / 5^q)
+  x.w[29] = 1u << 31;
+  for (auto &entry : table) {
+    entry = x.bits(959 - (p.bit_length() - 1 + kPow5Bits));
+    entry.hi += ++entry.lo == 0;
+    p.mul_small(5);
+    x.div_small(5);
+  }
+  return table;
+}();
+
+// ---- Ryu ----
+
+inline constexpr int32_t pow5bits(int32_t e) noexcept {
+  return static_cast<int32_t>((static_cast<uint32_t>(e) * 1217359) >> 19) + 1;
+}
+inline constexpr uint32_t log10_pow2(int32_t e) noexcept {
+  return (static_cast<uint32_t>(e) * 78913) >> 18;
+}
+inline constexpr uint32_t log10_pow5(int32_t e) noexcept {
+  return (static_cast<uint32_t>(e) * 732923) >> 20;
+}
+inline constexpr bool multiple_of_pow5(uint64_t v, uint32_t p) noexcept {
+  uint32_t count = 0;
+  for (; v % 5 == 0; v /= 5)
+    ++count;
+  return count >= p;
+}
+inline constexpr bool multiple_of_pow2(uint64_t v, uint32_t p) noexcept {
+  return (v & ((uint64_t{1} << p) - 1)) == 0;
+}
+
+/// (m * mul) >> j, for 64 <= j; the product is up to 189 bits.
+inline uint64_t mul_shift(uint64_t m, u128 mul, int32_t j) noexcept {
+  using wide = unsigned __int128;
+  const wide low = wide{m} * mul.lo;
+  const wide high = wide{m} * mul.hi;
+  return static_cast<uint64_t>(((low >> 64) + high) >> (j - 64));
+}
+
+/// mantissa * 10^exponent.
+struct decimal {
+  uint64_t mantissa;
+  int32_t exponent;
+};
+
+/// Shortest decimal in the rounding interval of a finite, nonzero double
+/// with the given IEEE fields; ties go to the digits nearest the value.
+inline decimal shortest(uint64_t ieee_mantissa, uint32_t ieee_exponent) noexcept {
+  constexpr int kMantissaBits = 52, kBias = 1023;
+
+  // Integers below 2^53 are their own shortest form, minus trailing zeros.
+  if (ieee_exponent != 0) {
+    const int32_t e = static_cast<int32_t>(ieee_exponent) - kBias - kMantissaBits;
+    const uint64_t m = (uint64_t{1} << kMantissaBits) | ieee_mantissa;
+    if (e <= 0 && e >= -kMantissaBits && (m & ((uint64_t{1} << -e) - 1)) == 0) {
+      decimal d{m >> -e, 0};
+      for (; d.mantissa % 10 == 0; d.mantissa /= 10)
+        ++d.exponent;
+      return d;
+    }
+  }
+
+  int32_t e2;
+  uint64_t m2;
+  if (ieee_exponent == 0) {
+    e2 = 1 - kBias - kMantissaBits - 2;
+    m2 = ieee_mantissa;
+  } else {
+    e2 = static_cast<int32_t>(ieee_exponent) - kBias - kMantissaBits - 2;
+    m2 = (uint64_t{1} << kMantissaBits) | ieee_mantissa;
+  }
+  const bool accept_bounds = (m2 & 1) == 0; // round-half-even reads the ends back as v
+
+  // The value and the midpoints to its neighbours, times 4: mv, mv + 2 and
+  // mv - 2 (mv - 1 at a power of two, where the gap below is half).
+  const uint64_t mv = 4 * m2;
+  const uint32_t mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+
+  // Scale all three to about 17 decimal digits: vr, vp, vm.
+  uint64_t vr, vp, vm;
+  int32_t e10;
+  bool vm_trailing_zeros = false, vr_trailing_zeros = false;
+  if (e2 >= 0) {
+    const uint32_t q = log10_pow2(e2) - (e2 > 3);
+    e10 = static_cast<int32_t>(q);
+    const int32_t k = kPow5Bits + pow5bits(static_cast<int32_t>(q)) - 1;
+    const int32_t i = -e2 + static_cast<int32_t>(q) + k;
+    vr = mul_shift(4 * m2, kPow5Inv[q], i);
+    vp = mul_shift(4 * m2 + 2, kPow5Inv[q], i);
+    vm = mul_shift(4 * m2 - 1 - mm_shift, kPow5Inv[q], i);
+    if (q <= 21) {
+      // At most one of mv, mp and mm is a multiple of 5.
+      if (mv % 5 == 0)
+        vr_trailing_zeros = multiple_of_pow5(mv, q);
+      else if (accept_bounds)
+        vm_trailing_zeros = multiple_of_pow5(mv - 1 - mm_shift, q);
+      else
+        vp -= multiple_of_pow5(mv + 2, q);
+    }
+  } else {
+    const uint32_t q = log10_pow5(-e2) - (-e2 > 1);
+    e10 = static_cast<int32_t>(q) + e2;
+    const int32_t i = -e2 - static_cast<int32_t>(q);
+    const int32_t k = pow5bits(i) - kPow5Bits;
+    const int32_t j = static_cast<int32_t>(q) - k;
+    vr = mul_shift(4 * m2, kPow5[i], j);
+    vp = mul_shift(4 * m2 + 2, kPow5[i], j);
+    vm = mul_shift(4 * m2 - 1 - mm_shift, kPow5[i], j);
+    if (q <= 1) {
+      // mv has at least q trailing 0 bits, so vr is exact.
+      vr_trailing_zeros = true;
+      if (accept_bounds)
+        vm_trailing_zeros = mm_shift == 1;
+      else
+        --vp;
+    } else if (q < 63) {
+      vr_trailing_zeros = multiple_of_pow2(mv, q);
+    }
+  }
+
+  // Drop digits while vm and vp still differ above them.
+  int32_t removed = 0;
+  uint64_t output;
+  if (vm_trailing_zeros || vr_trailing_zeros) {
+    // Rare: exact ends or an exact tie need the digits dropped so far.
+    uint8_t last_removed = 0;
+    for (; vp / 10 > vm / 10; ++removed) {
+      vm_trailing_zeros &= vm % 10 == 0;
+      vr_trailing_zeros &= last_removed == 0;
+      last_removed = static_cast<uint8_t>(vr % 10);
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+    }
+    if (vm_trailing_zeros) {
+      for (; vm % 10 == 0; ++removed) {
+        vr_trailing_zeros &= last_removed == 0;
+        last_removed = static_cast<uint8_t>(vr % 10);
+        vr /= 10;
+        vp /= 10;
+        vm /= 10;
+      }
+    }
+    if (vr_trailing_zeros && last_removed == 5 && vr % 2 == 0)
+      last_removed = 4; // exactly halfway: round to even
+    output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed >= 5);
+  } else {
+    bool round_up = false;
+    if (vp / 100 > vm / 100) {
+      round_up = vr % 100 >= 50;
+      vr /= 100;
+      vp /= 100;
+      vm /= 100;
+      removed += 2;
+    }
+    for (; vp / 10 > vm / 10; ++removed) {
+      round_up = vr % 10 >= 5;
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+    }
+    output = vr + (vr == vm || round_up);
+  }
+  return {output, e10 + removed};
+}
+
+/// Whether %f style is no longer than %e style for d; std::to_chars picks
+/// the shorter, %f on a tie.
+inline bool prefer_fixed(decimal d) noexcept {
+  const int n = count_digits(d.mantissa);
+  const int e = d.exponent;
+  const int sci_exp = e + n - 1;
+  const int sci_len = n + (n > 1) + 2 + (sci_exp >= 100 || sci_exp <= -100 ? 3 : 2);
+  const int fixed_len = e >= 0 ? n + e : (n > -e ? n + 1 : 2 - e);
+  return fixed_len <= sci_len;
+}
+
+/// Write mantissa * 10^exponent in the style prefer_fixed() picks.
+inline char *write_decimal(char *out, decimal d) noexcept {
+  const int n = count_digits(d.mantissa);
+  const int e = d.exponent;
+  const int sci_exp = e + n - 1;
+
+  if (prefer_fixed(d)) {
+    if (e >= 0) {
+      out = write_digits(out, d.mantissa, n);
+      std::memset(out, '0', static_cast<size_t>(e));
+      return out + e;
+    }
+    if (n > -e) { // 123.45
+      write_digits(out + 1, d.mantissa, n);
+      std::memmove(out, out + 1, static_cast<size_t>(n + e));
+      out[n + e] = '.';
+      return out + n + 1;
+    }
+    out[0] = '0'; // 0.0012345
+    out[1] = '.';
+    std::memset(out + 2, '0', static_cast<size_t>(-e - n));
+    return write_digits(out + 2 - e - n, d.mantissa, n);
+  }
+
+  write_digits(out + 1, d.mantissa, n); // 1.2345e+67
+  out[0] = out[1];
+  if (n > 1) {
+    out[1] = '.';
+    out += n + 1;
+  } else {
+    out += 1;
+  }
+  *out++ = 'e';
+  *out++ = sci_exp < 0 ? '-' : '+';
+  int abs_exp = sci_exp < 0 ? -sci_exp : sci_exp;
+  if (abs_exp >= 100) {
+    *out++ = static_cast<char>('0' + abs_exp / 100);
+    abs_exp %= 100;
+  }
+  std::memcpy(out, &kDigitPairs[abs_exp * 2], 2); // at least two digits
+  return out + 2;
+}
+
+} // end of namespace detail
+
+template <typename T>
+concept integer = std::integral<T> && !std::same_as<T, bool>;
+
+/// Decimal digits of value, with a '-' if negative.
+template <integer T> char *write_int(char *out, T value) noexcept {
+  using U = std::make_unsigned_t<T>;
+  auto u = static_cast<U>(value);
+  if constexpr (std::is_signed_v<T>) {
+    if (value < 0) {
+      *out++ = '-';
+      u = static_cast<U>(U{0} - u);
+    }
+  }
+  const uint64_t v = u;
+  return detail::write_digits(out, v, detail::count_digits(v));
+}
+
+/// Shortest round-trip text of value; "inf", "-inf", "nan" and "-nan" as
+/// std::to_chars writes them.
+inline char *write_double(char *out, double value) noexcept {
+  const auto bits = std::bit_cast<uint64_t>(value);
+  const uint64_t mantissa = bits & ((uint64_t{1} << 52) - 1);
+  const auto exponent = static_cast<uint32_t>((bits >> 52) & 0x7ff);
+  if (bits >> 63)
+    *out++ = '-';
+  if (exponent == 0x7ff) {
+    std::memcpy(out, mantissa ? "nan" : "inf", 3);
+    return out + 3;
+  }
+  if (exponent == 0 && mantissa == 0) {
+    *out = '0';
+    return out + 1;
+  }
+  const detail::decimal d = detail::shortest(mantissa, exponent);
+  // Like %f, an integer at or above 2^53 is written exactly, not as its
+  // shortest digits padded with zeros. Fixed style only wins below 10^23.
+  if (exponent > 1075 && detail::prefer_fixed(d)) {
+    const unsigned __int128 m = (uint64_t{1} << 52) | mantissa;
+    return detail::write_u128(out, m << (exponent - 1075));
+  }
+  return detail::write_decimal(out, d);
+}
+
+/// The number spelled by all of text, or nullopt if text is anything else
+/// or the number does not fit T. Takes what the writers write, plus an
+/// optional leading '+'.
+template <typename T>
+  requires integer<T> || std::floating_point<T>
+[[nodiscard]] std::optional<T> parse(std::string_view text) noexcept {
+  if (text.size() > 1 && text.front() == '+' && text[1] != '-')
+    text.remove_prefix(1);
+  T value{};
+  const char *last = text.data() + text.size();
+  const auto [ptr, ec] = std::from_chars(text.data(), last, value);
+  if (ec != std::errc{} || ptr != last)
+    return std::nullopt;
+  return value;
+}
+
+} // end of namespace formatting
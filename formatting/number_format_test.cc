@@ -0,0 +1,202 @@
+#include "my_timer.h"
+#include "number_format.hpp"
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+template <typename T> std::string reference(T value) {
+  char buf[64];
+  return {buf, std::to_chars(buf, buf + sizeof(buf), value).ptr};
+}
+
+template <typename T> std::string ours(T value) {
+  char buf[formatting::max_chars<T>];
+  if constexpr (std::is_floating_point_v<T>)
+    return {buf, formatting::write_double(buf, value)};
+  else
+    return {buf, formatting::write_int(buf, value)};
+}
+
+template <typename T> void check_int_limits() {
+  using L = std::numeric_limits<T>;
+  for (T v : {T{0}, T{1}, T{9}, T{10}, T{99}, T{100}, L::max(), T(L::max() - 1), L::min(),
+              T(L::min() + 1), T(L::max() / 10), T(L::max() / 10 + 1)}) {
+    EXPECT_EQ(ours(v), reference(v));
+    EXPECT_EQ(formatting::parse<T>(ours(v)), v);
+  }
+}
+
+} // namespace
+
+TEST(number_format, integers) {
+  check_int_limits<int8_t>();
+  check_int_limits<uint8_t>();
+  check_int_limits<int16_t>();
+  check_int_limits<int32_t>();
+  check_int_limits<uint32_t>();
+  check_int_limits<int64_t>();
+  check_int_limits<uint64_t>();
+
+  // Every power of ten and its neighbours, where the digit count changes.
+  for (uint64_t p = 1; p <= 10000000000000000000u; p *= 10) {
+    for (uint64_t v : {p - 1, p, p + 1}) {
+      EXPECT_EQ(ours(v), reference(v));
+      EXPECT_EQ(ours(-static_cast<int64_t>(v / 2)), reference(-static_cast<int64_t>(v / 2)));
+    }
+    if (p == 10000000000000000000u)
+      break;
+  }
+
+  std::mt19937_64 rng(42);
+  for (int i = 0; i < 100000; ++i) {
+    const auto v = static_cast<int64_t>(rng() >> (rng() % 64));
+    ASSERT_EQ(ours(v), reference(v));
+    ASSERT_EQ(ours(static_cast<int32_t>(v)), reference(static_cast<int32_t>(v)));
+  }
+}
+
+TEST(number_format, doubles_match_to_chars) {
+  using L = std::numeric_limits<double>;
+  for (double v : {0.0, -0.0, 1.0, -1.0, 0.1, 0.3, 1.0 / 3, 2.0 / 3, 100.0, 1e21, 1e22, 1e23,
+                   123456.0, 1234567.0, 9007199254740991.0, 9007199254740992.0, 1e-5, 1.5e-5,
+                   123e-7, 5e-324, L::min(), L::max(), L::lowest(), L::epsilon(),
+                   L::infinity(), -L::infinity(), 1.7976931348623157e308, 2.2250738585072009e-308,
+                   4.35e-6, 9.5367431640625e-7, 1.9156918820264798e-56, 6.6564021122018745e+264})
+    EXPECT_EQ(ours(v), reference(v)) << std::hexfloat << v;
+  EXPECT_EQ(ours(L::quiet_NaN()), reference(L::quiet_NaN()));
+
+  // Every power of two, and random bit patterns and everyday values.
+  for (int e = -1074; e <= 1023; ++e)
+    ASSERT_EQ(ours(std::ldexp(1.0, e)), reference(std::ldexp(1.0, e))) << e;
+  std::mt19937_64 rng(7);
+  std::uniform_real_distribution<double> money(0, 1e6);
+  for (int i = 0; i < 300000; ++i) {
+    const double bits = std::bit_cast<double>(rng());
+    const double everyday = std::round(money(rng) * 100) / 100;
+    if (std::isfinite(bits)) {
+      ASSERT_EQ(ours(bits), reference(bits)) << std::hexfloat << bits;
+    }
+    ASSERT_EQ(ours(everyday), reference(everyday)) << std::hexfloat << everyday;
+    ASSERT_EQ(ours(i / 7.0), reference(i / 7.0));
+  }
+}
+
+TEST(number_format, parse) {
+  EXPECT_EQ(formatting::parse<int>("42"), 42);
+  EXPECT_EQ(formatting::parse<int>("+42"), 42);
+  EXPECT_EQ(formatting::parse<int>("-42"), -42);
+  EXPECT_EQ(formatting::parse<int>("+-42"), std::nullopt);
+  EXPECT_EQ(formatting::parse<int>("42 "), std::nullopt);
+  EXPECT_EQ(formatting::parse<int>(""), std::nullopt);
+  EXPECT_EQ(formatting::parse<int8_t>("128"), std::nullopt);
+  EXPECT_EQ(formatting::parse<unsigned>("-1"), std::nullopt);
+  EXPECT_EQ(formatting::parse<double>("1e-5"), 1e-5);
+  EXPECT_EQ(formatting::parse<double>("+0.25"), 0.25);
+  EXPECT_EQ(formatting::parse<double>("1e999"), std::nullopt);
+  EXPECT_TRUE(std::isinf(*formatting::parse<double>("-inf")));
+
+  // Whatever write_double writes reads back as the same double.
+  std::mt19937_64 rng(3);
+  for (int i = 0; i < 100000; ++i) {
+    const double v = std::bit_cast<double>(rng());
+    if (std::isfinite(v)) {
+      ASSERT_EQ(formatting::parse<double>(ours(v)), v) << ours(v);
+    }
+  }
+}
+
+TEST(number_format, benchmark) {
+  constexpr size_t count = 1000000;
+  std::mt19937_64 rng(1);
+  std::vector<int64_t> ints(count);
+  std::vector<double> doubles(count);
+  std::uniform_real_distribution<double> price(0, 1e5);
+  for (size_t i = 0; i < count; ++i) {
+    ints[i] = static_cast<int64_t>(rng() >> (rng() % 64)) - (i % 2 ? 0 : INT64_MAX / 2);
+    doubles[i] = i % 2 ? price(rng) : std::round(price(rng) * 100) / 100;
+  }
+
+  // Each writer appends into one buffer; the total length keeps the work.
+  std::vector<char> out(count * 32);
+  auto run = [&](const char *name, auto &&write) {
+    char *p = out.data();
+    Timer t(name);
+    for (size_t i = 0; i < count; ++i)
+      p = write(p, i);
+    const double ns = static_cast<double>(t.eclipse()) / count;
+    EXPECT_GT(p, out.data());
+    return ns;
+  };
+  const double int_ours = run("write_int", [&](char *p, size_t i) {
+    return formatting::write_int(p, ints[i]);
+  });
+  const double int_to_chars = run("to_chars int", [&](char *p, size_t i) {
+    return std::to_chars(p, p + 32, ints[i]).ptr;
+  });
+  const double int_snprintf = run("snprintf int", [&](char *p, size_t i) {
+    return p + std::snprintf(p, 32, "%lld", static_cast<long long>(ints[i]));
+  });
+  const double dbl_ours = run("write_double", [&](char *p, size_t i) {
+    return formatting::write_double(p, doubles[i]);
+  });
+  const double dbl_to_chars = run("to_chars double", [&](char *p, size_t i) {
+    return std::to_chars(p, p + 32, doubles[i]).ptr;
+  });
+  // %.17g round-trips too, but is not shortest.
+  const double dbl_snprintf = run("snprintf double", [&](char *p, size_t i) {
+    return p + std::snprintf(p, 32, "%.17g", doubles[i]);
+  });
+
+  auto stream = [&](const char *name, auto &values) {
+    std::ostringstream os;
+    os.precision(17);
+    Timer t(name);
+    for (const auto &v : values)
+      os << v << ' ';
+    const double ns = static_cast<double>(t.eclipse()) / count;
+    EXPECT_FALSE(os.view().empty());
+    return ns;
+  };
+  const double int_stream = stream("ostream int", ints);
+  const double dbl_stream = stream("ostream double", doubles);
+
+  // Reading the doubles back: parse (from_chars) against strtod.
+  std::vector<std::string> texts(count);
+  for (size_t i = 0; i < count; ++i)
+    texts[i] = ours(doubles[i]);
+  double sum_parse = 0, sum_strtod = 0;
+  Timer t1("parse");
+  for (const auto &s : texts)
+    sum_parse += *formatting::parse<double>(s);
+  const double parse_ns = static_cast<double>(t1.eclipse()) / count;
+  Timer t2("strtod");
+  for (const auto &s : texts)
+    sum_strtod += std::strtod(s.c_str(), nullptr);
+  const double strtod_ns = static_cast<double>(t2.eclipse()) / count;
+  EXPECT_EQ(sum_parse, sum_strtod);
+
+#ifndef NDEBUG
+  std::cout << "ns per value, int64: write_int " << int_ours << ", to_chars " << int_to_chars
+            << ", snprintf " << int_snprintf << ", ostream " << int_stream << '\n'
+            << "ns per value, double: write_double " << dbl_ours << ", to_chars "
+            << dbl_to_chars << ", snprintf %.17g " << dbl_snprintf << ", ostream "
+            << dbl_stream << '\n'
+            << "ns per value, parse double: parse " << parse_ns << ", strtod " << strtod_ns
+            << '\n';
+#else
+  (void)int_ours, (void)int_to_chars, (void)int_snprintf, (void)int_stream;
+  (void)dbl_ours, (void)dbl_to_chars, (void)dbl_snprintf, (void)dbl_stream;
+  (void)parse_ns, (void)strtod_ns;
+#endif
+}
@@ -0,0 +1,547 @@
+#pragma once
+
+// DESCRIPTION:
+//  A formatter whose format string is parsed at compile time.
+//
+//    auto line = formatting::format<"{:>5} {}:{} took {:.3f} ms">(level, file, line, ms);
+//    std::string_view text = line;  // the text lives in `line`, on the stack
+//
+//  std::format parses its format string again on every call, then
+//  dispatches on each argument's type and spec at run time. Here the
+//  string is a template argument: it is split into literal and argument
+//  segments once, by the compiler, and each segment's spec becomes a
+//  template argument of the code that writes it. A call is then a fixed
+//  sequence of memcpys of the literals and one writer per argument, with
+//  the spec's branches already resolved.
+//
+//  * format<Fmt>(args...) writes into a formatted<N> held by value, where
+//    N = max_size<Fmt, Args...> is worked out from the argument types and
+//    specs. That needs every string argument to have a precision ({:.20});
+//    otherwise the output has no bound and format() does not compile.
+//  * format_to<Fmt>(char *out, args...) writes to out, which must have room
+//    (max_size<> when it is bounded), and returns the end.
+//  * format_to<Fmt>(sink, args...) appends to anything with
+//    append(std::string_view): std::string, strings::rope, ... In one
+//    append when the output is bounded, else a few per argument.
+//
+//  No call allocates. The spec grammar is std::format's:
+//  {[index][:[[fill]align][sign][#][0][width][.precision][type]]}, with
+//  automatic or manual indexing and {{ / }} escapes. Differences: the
+//  fill is one char, width and precision cannot come from arguments,
+//  width counts bytes rather than display columns, and long double is not
+//  supported. A bad format string, an index past the arguments or a type
+//  that does not fit its argument (say {:f} for an int) is a compile error.
+
+#include "number_format.hpp"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace formatting {
+
+/// A string literal as a template argument.
+template <size_t N> struct fixed_string {
+  char data[N]{};
+
+  constexpr fixed_string(const char (&s)[N]) { std::copy_n(s, N, data); }
+  [[nodiscard]] constexpr std::string_view view() const { return {data, N - 1}; }
+};
+
+/// One replacement field's spec, as parsed.
+struct format_spec {
+  char fill = ' ';
+  char align = 0; // '<', '>', '^', or 0 for the type's default
+  char sign = '-';
+  bool alternate = false;
+  bool zero_pad = false;
+  size_t width = 0;
+  int precision = -1;
+  char type = 0;
+};
+
+/// A run of literal text, or a replacement field.
+struct format_segment {
+  bool is_arg = false;
+  size_t begin = 0, size = 0; // literal: [begin, begin + size) of the format string
+  size_t arg = 0;
+  format_spec spec{};
+};
+
+/// Output size with no upper bound.
+inline constexpr size_t unbounded = static_cast<size_t>(-1);
+
+namespace detail {
+
+// Not constexpr: reaching it in constant evaluation is the compile error,
+// and the compiler's note shows the message.
+inline void format_error(const char *) {}
+
+template <size_t N> struct parsed_format {
+  std::array<format_segment, N> segments{};
+  size_t count = 0;
+  size_t arg_count = 0;
+};
+
+constexpr bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+constexpr size_t parse_number(std::string_view s, size_t &i) {
+  size_t value = 0;
+  for (; i < s.size() && is_digit(s[i]); ++i)
+    value = value * 10 + static_cast<size_t>(s[i] - '0');
+  return value;
+}
+
+/// Parse a spec from s[i], up to but not including the closing '}'.
+constexpr size_t parse_spec(std::string_view s, size_t i, format_spec &spec) {
+  auto is_align = [](char c) { return c == '<' || c == '>' || c == '^'; };
+  if (i + 1 < s.size() && is_align(s[i + 1])) {
+    if (s[i] == '{' || s[i] == '}')
+      format_error("'{' and '}' cannot be fill characters");
+    spec.fill = s[i];
+    spec.align = s[i + 1];
+    i += 2;
+  } else if (i < s.size() && is_align(s[i])) {
+    spec.align = s[i++];
+  }
+  if (i < s.size() && (s[i] == '+' || s[i] == '-' || s[i] == ' '))
+    spec.sign = s[i++];
+  if (i < s.size() && s[i] == '#') {
+    spec.alternate = true;
+    ++i;
+  }
+  if (i < s.size() && s[i] == '0') {
+    spec.zero_pad = true;
+    ++i;
+  }
+  spec.width = parse_number(s, i);
+  if (i < s.size() && s[i] == '.') {
+    if (++i == s.size() || !is_digit(s[i]))
+      format_error("expected digits after '.'");
+    spec.precision = static_cast<int>(parse_number(s, i));
+  }
+  if (i < s.size() && s[i] != '}') {
+    if (std::string_view("bBcdoxXsfFeEgG").find(s[i]) == std::string_view::npos)
+      format_error("unknown presentation type");
+    spec.type = s[i++];
+  }
+  return i;
+}
+
+template <size_t N> constexpr parsed_format<N> parse(const fixed_string<N> &fmt) {
+  const std::string_view s = fmt.view();
+  parsed_format<N> out;
+  size_t literal = 0, next_arg = 0;
+  bool automatic = false, manual = false;
+  auto flush = [&](size_t end) {
+    if (end > literal)
+      out.segments[out.count++] = {false, literal, end - literal, 0, {}};
+  };
+
+  for (size_t i = 0; i < s.size();) {
+    if (s[i] == '}') {
+      if (i + 1 == s.size() || s[i + 1] != '}')
+        format_error("unmatched '}'");
+      flush(i + 1); // keep one '}', skip the other
+      literal = i += 2;
+      continue;
+    }
+    if (s[i] != '{') {
+      ++i;
+      continue;
+    }
+    if (i + 1 < s.size() && s[i + 1] == '{') {
+      flush(i + 1);
+      literal = i += 2;
+      continue;
+    }
+    flush(i);
+    ++i;
+    format_segment field{true, 0, 0, 0, {}};
+    if (i < s.size() && is_digit(s[i])) {
+      manual = true;
+      field.arg = parse_number(s, i);
+    } else {
+      automatic = true;
+      field.arg = next_arg++;
+    }
+    if (automatic && manual)
+      format_error("cannot mix automatic and manual argument indexing");
+    if (i < s.size() && s[i] == ':')
+      i = parse_spec(s, i + 1, field.spec);
+    if (i == s.size() || s[i] != '}')
+      format_error("expected '}'");
+    literal = ++i;
+    out.segments[out.count++] = field;
+    out.arg_count = std::max(out.arg_count, field.arg + 1);
+  }
+  flush(s.size());
+  return out;
+}
+
+template <fixed_string Fmt> struct compiled {
+  static constexpr auto parsed = parse(Fmt);
+};
+
+// ---- argument kinds ----
+
+template <typename T> using bare = std::remove_cvref_t<T>;
+
+template <typename T>
+inline constexpr bool is_string_arg =
+    std::is_convertible_v<const T &, std::string_view> && !std::is_same_v<bare<T>, std::nullptr_t>;
+template <typename T> inline constexpr bool is_char_arg = std::is_same_v<bare<T>, char>;
+template <typename T> inline constexpr bool is_bool_arg = std::is_same_v<bare<T>, bool>;
+template <typename T>
+inline constexpr bool is_integer_arg = integer<bare<T>> && !is_char_arg<T>;
+template <typename T>
+inline constexpr bool is_float_arg = std::is_same_v<bare<T>, float> || std::is_same_v<bare<T>, double>;
+
+/// How an argument of type T is written under spec S: as text (strings,
+/// and bool and char by default) or as a number.
+template <format_spec S, typename T> constexpr bool as_text() {
+  if constexpr (is_string_arg<T>) {
+    static_assert(S.type == 0 || S.type == 's', "strings take no type but 's'");
+    return true;
+  } else if constexpr (is_bool_arg<T>) {
+    return S.type == 0 || S.type == 's';
+  } else if constexpr (is_char_arg<T>) {
+    return S.type == 0 || S.type == 'c';
+  } else {
+    static_assert(!std::is_same_v<bare<T>, long double>, "long double is not supported");
+    static_assert(is_integer_arg<T> || is_float_arg<T>, "argument type is not formattable");
+    return false;
+  }
+}
+
+template <format_spec S> constexpr size_t float_body_max() {
+  constexpr size_t precision = S.precision < 0 ? 6 : static_cast<size_t>(S.precision);
+  if constexpr (S.type == 'f' || S.type == 'F')
+    return 1 + 309 + 1 + precision; // sign, 1e308's digits, '.', decimals
+  else if constexpr (S.type == 'e' || S.type == 'E')
+    return 1 + 2 + precision + 5; // sign, "d.", decimals, "e+308"
+  else if constexpr (S.type == 0 && S.precision < 0)
+    return 1 + max_chars<double>; // shortest round trip, plus a '+'
+  else
+    return 1 + precision + 10; // %g: at most "0.0000" or "e+308" on top
+}
+
+template <format_spec S, typename T> constexpr size_t integer_body_max() {
+  using U = std::make_unsigned_t<std::conditional_t<is_bool_arg<T>, unsigned char, bare<T>>>;
+  constexpr size_t bits = std::numeric_limits<U>::digits;
+  if constexpr (S.type == 'b' || S.type == 'B')
+    return 3 + bits; // sign, "0b", digits
+  else if constexpr (S.type == 'o')
+    return 2 + (bits + 2) / 3;
+  else if constexpr (S.type == 'x' || S.type == 'X')
+    return 3 + (bits + 3) / 4;
+  else
+    return 1 + std::numeric_limits<U>::digits10 + 1;
+}
+
+/// Most bytes one argument of type T can take under spec S.
+template <format_spec S, typename T> constexpr size_t arg_max_size() {
+  size_t body;
+  if constexpr (is_string_arg<T>) {
+    if constexpr (S.precision < 0)
+      return unbounded;
+    else
+      body = static_cast<size_t>(S.precision);
+  } else if constexpr (as_text<S, T>()) {
+    body = is_bool_arg<T> ? 5 : 1;
+  } else if constexpr (is_float_arg<T>) {
+    body = float_body_max<S>();
+  } else {
+    body = integer_body_max<S, T>();
+  }
+  return std::max(body, S.width);
+}
+
+// ---- writers ----
+
+/// Where the padding goes: {left, right}.
+template <format_spec S, char DefaultAlign> constexpr std::pair<size_t, size_t> padding(size_t n) {
+  const size_t pad = n < S.width ? S.width - n : 0;
+  constexpr char align = S.align ? S.align : DefaultAlign;
+  const size_t left = align == '>' ? pad : (align == '^' ? pad / 2 : 0);
+  return {left, pad - left};
+}
+
+template <format_spec S, char DefaultAlign>
+char *write_padded(char *out, const char *body, size_t n) noexcept {
+  if constexpr (S.width == 0) {
+    std::memcpy(out, body, n);
+    return out + n;
+  } else {
+    const auto [left, right] = padding<S, DefaultAlign>(n);
+    std::memset(out, S.fill, left);
+    std::memcpy(out + left, body, n);
+    std::memset(out + left + n, S.fill, right);
+    return out + left + n + right;
+  }
+}
+
+template <format_spec S> char *write_sign(char *out, bool negative) noexcept {
+  if (negative)
+    *out++ = '-';
+  else if constexpr (S.sign == '+' || S.sign == ' ')
+    *out++ = S.sign;
+  return out;
+}
+
+/// Sign, base prefix and digits of v. `digits` is set to where the digits
+/// start, which is where zero padding goes.
+template <format_spec S, typename T> char *integer_body(char *out, T v, char *&digits) noexcept {
+  static_assert(S.precision < 0, "integers take no precision");
+  static_assert(std::string_view("bBdoxX").find(S.type) != std::string_view::npos || S.type == 0,
+                "integers take only b, B, d, o, x or X");
+  using U = std::make_unsigned_t<T>;
+  auto magnitude = static_cast<U>(v);
+  bool negative = false;
+  if constexpr (std::is_signed_v<T>) {
+    negative = v < 0;
+    if (negative)
+      magnitude = static_cast<U>(U{0} - magnitude);
+  }
+  out = write_sign<S>(out, negative);
+  if constexpr (S.alternate && S.type != 0 && S.type != 'd') {
+    if (S.type != 'o' || magnitude != 0) {
+      *out++ = '0';
+      if constexpr (S.type != 'o')
+        *out++ = S.type; // 0b, 0B, 0x, 0X
+    }
+  }
+  digits = out;
+  if constexpr (S.type == 0 || S.type == 'd') {
+    return write_int(out, magnitude);
+  } else {
+    constexpr int base = S.type == 'o' ? 8 : (S.type == 'x' || S.type == 'X' ? 16 : 2);
+    constexpr int bits = std::numeric_limits<U>::digits;
+    constexpr int room = base == 2 ? bits : (base == 8 ? (bits + 2) / 3 : (bits + 3) / 4);
+    char *end = std::to_chars(out, out + room, magnitude, base).ptr;
+    if constexpr (S.type == 'X')
+      std::transform(out, end, out, [](char c) { return c >= 'a' ? c - 'a' + 'A' : c; });
+    return end;
+  }
+}
+
+/// A float is written as a float: its shortest round trip is "0.1" where
+/// the double it widens to would need "0.10000000149011612".
+template <format_spec S, typename F> char *float_body(char *out, F v) noexcept {
+  static_assert(!S.alternate, "'#' is not supported for floating point");
+  static_assert(std::string_view("fFeEgG").find(S.type) != std::string_view::npos || S.type == 0,
+                "floating point takes only f, F, e, E, g or G");
+  if (!std::signbit(v))
+    out = write_sign<S>(out, false); // the writers below write the '-'
+  if constexpr (S.type == 0 && S.precision < 0 && std::is_same_v<F, double>) {
+    return write_double(out, v);
+  } else if constexpr (S.type == 0 && S.precision < 0) {
+    return std::to_chars(out, out + max_chars<double>, v).ptr;
+  } else {
+    constexpr auto style = S.type == 'f' || S.type == 'F'   ? std::chars_format::fixed
+                           : S.type == 'e' || S.type == 'E' ? std::chars_format::scientific
+                                                            : std::chars_format::general;
+    constexpr int precision = S.precision < 0 ? 6 : S.precision;
+    char *end = std::to_chars(out, out + float_body_max<S>(), v, style, precision).ptr;
+    if constexpr (S.type == 'F' || S.type == 'E' || S.type == 'G')
+      std::transform(out, end, out, [](char c) { return c >= 'a' ? c - 'a' + 'A' : c; });
+    return end;
+  }
+}
+
+/// A number: sign, prefix and digits, then padding with the fill or, for
+/// '0' without an alignment, zeros after the sign and prefix (except for
+/// inf and nan).
+template <format_spec S, typename T> char *write_number(char *out, const T &v) noexcept {
+  if constexpr (S.width == 0) {
+    char *digits;
+    if constexpr (is_float_arg<T>)
+      return float_body<S>(out, v);
+    else
+      return integer_body<S>(out, v, digits);
+  } else {
+    char body[std::max(float_body_max<S>(), size_t{80})];
+    char *digits = body;
+    char *end;
+    if constexpr (is_float_arg<T>) {
+      end = float_body<S>(body, v);
+      digits = body + (body[0] == '-' || body[0] == '+' || body[0] == ' ');
+    } else {
+      end = integer_body<S>(body, v, digits);
+    }
+    const auto n = static_cast<size_t>(end - body);
+    if constexpr (S.zero_pad && S.align == 0) {
+      if constexpr (is_float_arg<T>) {
+        if (!std::isfinite(v)) // inf and nan get the fill, as in std::format
+          return write_padded<S, '>'>(out, body, n);
+      }
+      const size_t pad = n < S.width ? S.width - n : 0;
+      const auto head = static_cast<size_t>(digits - body);
+      std::memcpy(out, body, head);
+      std::memset(out + head, '0', pad);
+      std::memcpy(out + head + pad, digits, n - head);
+      return out + n + pad;
+    } else {
+      return write_padded<S, '>'>(out, body, n);
+    }
+  }
+}
+
+template <format_spec S> std::string_view truncated(std::string_view s) noexcept {
+  if constexpr (S.precision >= 0)
+    return s.substr(0, static_cast<size_t>(S.precision));
+  else
+    return s;
+}
+
+template <format_spec S, typename T> char *write_arg(char *out, const T &v) noexcept {
+  if constexpr (is_string_arg<T>) {
+    const std::string_view s = truncated<S>(v);
+    return write_padded<S, '<'>(out, s.data(), s.size());
+  } else if constexpr (as_text<S, T>()) {
+    if constexpr (is_bool_arg<T>)
+      return v ? write_padded<S, '<'>(out, "true", 4) : write_padded<S, '<'>(out, "false", 5);
+    else
+      return write_padded<S, '<'>(out, &v, 1);
+  } else if constexpr (is_bool_arg<T> || is_char_arg<T>) {
+    return write_number<S>(out, static_cast<unsigned char>(v));
+  } else {
+    return write_number<S>(out, v);
+  }
+}
+
+template <fixed_string Fmt, format_segment Seg, typename Tuple>
+char *write_segment(char *out, const Tuple &args) noexcept {
+  if constexpr (Seg.is_arg) {
+    return write_arg<Seg.spec>(out, std::get<Seg.arg>(args));
+  } else {
+    std::memcpy(out, Fmt.data + Seg.begin, Seg.size);
+    return out + Seg.size;
+  }
+}
+
+template <typename Sink, size_t N> void append_fill(Sink &sink, char fill, size_t n) {
+  char fills[N];
+  std::memset(fills, fill, N);
+  for (; n > N; n -= N)
+    sink.append(std::string_view(fills, N));
+  sink.append(std::string_view(fills, n));
+}
+
+template <format_spec S, typename Sink, typename T> void append_arg(Sink &sink, const T &v) {
+  if constexpr (is_string_arg<T> && S.precision < 0) {
+    // Unbounded: append the string itself, between the padding.
+    const std::string_view s = v;
+    if constexpr (S.width == 0) {
+      sink.append(s);
+    } else {
+      const auto [left, right] = padding<S, '<'>(s.size());
+      if (left)
+        append_fill<Sink, 32>(sink, S.fill, left);
+      sink.append(s);
+      if (right)
+        append_fill<Sink, 32>(sink, S.fill, right);
+    }
+  } else {
+    char buf[arg_max_size<S, T>()];
+    sink.append(std::string_view(buf, write_arg<S>(buf, v) - buf));
+  }
+}
+
+template <fixed_string Fmt, format_segment Seg, typename Sink, typename Tuple>
+void append_segment(Sink &sink, const Tuple &args) {
+  if constexpr (Seg.is_arg)
+    append_arg<Seg.spec>(sink, std::get<Seg.arg>(args));
+  else
+    sink.append(std::string_view(Fmt.data + Seg.begin, Seg.size));
+}
+
+template <fixed_string Fmt, typename... Args> constexpr size_t max_size() {
+  constexpr auto &parsed = compiled<Fmt>::parsed;
+  static_assert(parsed.arg_count <= sizeof...(Args), "format string refers to a missing argument");
+  using Tuple = std::tuple<const Args &...>;
+  size_t total = 0;
+  bool bounded = true;
+  [&]<size_t... I>(std::index_sequence<I...>) {
+    (
+        [&] {
+          constexpr format_segment seg = parsed.segments[I];
+          if constexpr (seg.is_arg) {
+            constexpr size_t n =
+                arg_max_size<seg.spec, std::tuple_element_t<seg.arg, Tuple>>();
+            bounded = bounded && n != unbounded;
+            total += n;
+          } else {
+            total += seg.size;
+          }
+        }(),
+        ...);
+  }(std::make_index_sequence<parsed.count>{});
+  return bounded ? total : unbounded;
+}
+
+} // end of namespace detail
+
+/// Most bytes format_to<Fmt> writes for these argument types, or
+/// `unbounded` if a string argument has no precision.
+template <fixed_string Fmt, typename... Args>
+inline constexpr size_t max_size = detail::max_size<Fmt, detail::bare<Args>...>();
+
+/// Text written by format(); it lives in the object, on the stack.
+template <size_t N> struct formatted {
+  char buffer[N];
+  size_t size = 0;
+
+  [[nodiscard]] std::string_view view() const noexcept { return {buffer, size}; }
+  operator std::string_view() const noexcept { return view(); }
+};
+
+/// Write to out, which has room for max_size<Fmt, Args...> bytes (or for
+/// the actual output, when that is unbounded). Returns the end.
+template <fixed_string Fmt, typename... Args>
+char *format_to(char *out, const Args &...args) noexcept {
+  constexpr auto &parsed = detail::compiled<Fmt>::parsed;
+  static_assert(parsed.arg_count <= sizeof...(Args), "format string refers to a missing argument");
+  const std::tuple<const Args &...> refs(args...);
+  [&]<size_t... I>(std::index_sequence<I...>) {
+    ((out = detail::write_segment<Fmt, parsed.segments[I]>(out, refs)), ...);
+  }(std::make_index_sequence<parsed.count>{});
+  return out;
+}
+
+/// Append to a sink with append(std::string_view).
+template <fixed_string Fmt, typename Sink, typename... Args>
+  requires requires(Sink &sink, std::string_view s) { sink.append(s); }
+void format_to(Sink &sink, const Args &...args) {
+  constexpr size_t bound = max_size<Fmt, Args...>;
+  if constexpr (bound != unbounded) {
+    char buf[bound];
+    sink.append(std::string_view(buf, format_to<Fmt>(buf, args...) - buf));
+  } else {
+    constexpr auto &parsed = detail::compiled<Fmt>::parsed;
+    const std::tuple<const Args &...> refs(args...);
+    [&]<size_t... I>(std::index_sequence<I...>) {
+      (detail::append_segment<Fmt, parsed.segments[I]>(sink, refs), ...);
+    }(std::make_index_sequence<parsed.count>{});
+  }
+}
+
+/// Format into a buffer held by value. Every string argument needs a
+/// precision, so that the size is bounded.
+template <fixed_string Fmt, typename... Args>
+formatted<max_size<Fmt, Args...>> format(const Args &...args) noexcept {
+  static_assert(max_size<Fmt, Args...> != unbounded,
+                "string arguments need a precision ({:.N}) here; or use format_to");
+  formatted<max_size<Fmt, Args...>> out;
+  out.size = static_cast<size_t>(format_to<Fmt>(out.buffer, args...) - out.buffer);
+  return out;
+}
+
+} // end of namespace formatting
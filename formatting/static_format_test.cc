@@ -0,0 +1,209 @@
+#include "my_timer.h"
+#include "static_format.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#if defined(__cpp_lib_format)
+#include <format>
+#endif
+
+namespace {
+
+// Expected strings are what std::format writes for the same call.
+template <formatting::fixed_string Fmt, typename... Args> std::string fmt(const Args &...args) {
+  std::string out;
+  formatting::format_to<Fmt>(out, args...);
+  return out;
+}
+
+} // namespace
+
+TEST(static_format, parses_at_compile_time) {
+  constexpr auto &parsed = formatting::detail::compiled<"x={} {{y}}={:>4}!">::parsed;
+  static_assert(parsed.count == 7); // "x=", {}, " {", "y}", "=", {:>4}, "!"
+  static_assert(parsed.arg_count == 2);
+  static_assert(parsed.segments[1].is_arg && parsed.segments[1].arg == 0);
+  static_assert(parsed.segments[5].spec.align == '>' && parsed.segments[5].spec.width == 4);
+
+  static_assert(formatting::max_size<"id={}", int> == 3 + 11);
+  static_assert(formatting::max_size<"{:08x}", uint32_t> == 11);
+  static_assert(formatting::max_size<"{:.3} {}", std::string, char> == 5);
+  static_assert(formatting::max_size<"{}", std::string_view> == formatting::unbounded);
+  static_assert(formatting::max_size<"{:20}", bool> == 20);
+}
+
+TEST(static_format, matches_std_format) {
+  // The cases from cpp20_features/format_test.cc.
+  EXPECT_EQ(fmt<"{:7}|">(42), "     42|");
+  EXPECT_EQ(fmt<"{:7}|">(std::string_view("hi")), "hi     |");
+  EXPECT_EQ(fmt<"{:*<7}|{:*^7}|{:*>7}">(42, 42, 42), "42*****|**42***|*****42");
+  EXPECT_EQ(fmt<"{:7.2f} Euro">(42.0), "  42.00 Euro");
+  EXPECT_EQ(fmt<"{:7.4}|">("corner"), "corn   |");
+  EXPECT_EQ(fmt<"'{0}' has value 0x{0:02x} {0:+4d} {0:03o}">('?'), "'?' has value 0x3f  +63 077");
+
+  // Escapes and manual indexing.
+  EXPECT_EQ(fmt<"{{{}}}">(1), "{1}");
+  EXPECT_EQ(fmt<"}}{1}{0}{{">(2, 1), "}12{");
+  EXPECT_EQ(fmt<"plain">(), "plain");
+
+  // Integers.
+  EXPECT_EQ(fmt<"{}">(std::numeric_limits<int64_t>::min()), "-9223372036854775808");
+  EXPECT_EQ(fmt<"{}">(std::numeric_limits<uint64_t>::max()), "18446744073709551615");
+  EXPECT_EQ(fmt<"{:#x} {:#X} {:#b} {:#o} {:#o}">(255, 255, 5, 8, 0), "0xff 0XFF 0b101 010 0");
+  EXPECT_EQ(fmt<"{:016x}">(0xdeadbeefu), "00000000deadbeef");
+  EXPECT_EQ(fmt<"{:#010x}">(255), "0x000000ff");
+  EXPECT_EQ(fmt<"{:+06}|{:06}|{: }|{:+}">(-42, -42, 7, 0), "-00042|-00042| 7|+0");
+  EXPECT_EQ(fmt<"{:<06}|">(42), "42    |"); // an alignment turns '0' off
+  EXPECT_EQ(fmt<"{:x}">(std::numeric_limits<int32_t>::min()), "-80000000");
+  EXPECT_EQ(fmt<"{:b}">(uint8_t{200}), "11001000");
+
+  // Floating point.
+  EXPECT_EQ(fmt<"{}">(0.1), "0.1");
+  EXPECT_EQ(fmt<"{}">(1e21), "1e+21");
+  EXPECT_EQ(fmt<"{}">(-0.0), "-0");
+  EXPECT_EQ(fmt<"{:+}">(1.5), "+1.5");
+  EXPECT_EQ(fmt<"{:.3}">(3.14159), "3.14");
+  EXPECT_EQ(fmt<"{:f}">(1.5), "1.500000");
+  EXPECT_EQ(fmt<"{:.2e}|{:.2E}">(12345.678, 12345.678), "1.23e+04|1.23E+04");
+  EXPECT_EQ(fmt<"{:g}|{:G}">(1e-10, 1e-10), "1e-10|1E-10");
+  EXPECT_EQ(fmt<"{:08.3f}">(-3.14159), "-003.142");
+  EXPECT_EQ(fmt<"{:^9.1f}|">(2.25), "   2.2   |");
+  EXPECT_EQ(fmt<"{:F}">(std::numeric_limits<double>::infinity()), "INF");
+  EXPECT_EQ(fmt<"{:.0f}">(1e308).size(), 309u);
+  EXPECT_EQ(fmt<"{:.1f}">(2.5f), "2.5");
+  EXPECT_EQ(fmt<"{}|{}">(0.1f, 3.4028235e38f), "0.1|3.4028235e+38"); // not via double
+  EXPECT_EQ(fmt<"{:08}|{:+08}|{:08}|{:08.1f}">(-std::numeric_limits<double>::infinity(),
+                                               std::numeric_limits<float>::infinity(),
+                                               std::numeric_limits<double>::quiet_NaN(), -1.5),
+            "    -inf|    +inf|     nan|-00001.5");
+
+  // Text.
+  EXPECT_EQ(fmt<"{} {:>6} {:d} {:#x}">(true, false, true, 'A'), "true  false 1 0x41");
+  EXPECT_EQ(fmt<"{:-^5}">('c'), "--c--");
+  EXPECT_EQ(fmt<"[{:>8.3}]">(std::string("abcdef")), "[     abc]");
+  EXPECT_EQ(fmt<"[{:s}]">(std::string()), "[]");
+  const char *c_string = "text";
+  EXPECT_EQ(fmt<"{}-{}">(c_string, "literal"), "text-literal");
+}
+
+TEST(static_format, outputs) {
+  // Bounded: a value on the stack.
+  auto line = formatting::format<"{:>5.5} {:.8}:{} took {:.3f} ms">("WARN", "server.cc", 120, 1.5);
+  static_assert(sizeof(line.buffer) == formatting::max_size<"{:>5.5} {:.8}:{} took {:.3f} ms",
+                                                             const char *, const char *, int,
+                                                             double>);
+  EXPECT_EQ(line.view(), " WARN server.c:120 took 1.500 ms");
+  EXPECT_EQ(std::string_view(formatting::format<"{}">(-1)), "-1");
+
+  // A raw buffer.
+  char buf[64];
+  char *end = formatting::format_to<"[{:^10}]">(buf, std::string_view("mid"));
+  EXPECT_EQ(std::string_view(buf, end), "[   mid    ]");
+
+  // Unbounded strings go to a sink piece by piece, padding included.
+  const std::string long_text(100, 'x');
+  std::string out = "> ";
+  formatting::format_to<"{:.<120}|{}">(out, long_text, 7);
+  EXPECT_EQ(out, "> " + long_text + std::string(20, '.') + "|7");
+}
+
+TEST(static_format, log_line_benchmark) {
+  constexpr size_t count = 200000;
+  struct Event {
+    int64_t time_us;
+    const char *level;
+    std::string_view file;
+    int line;
+    uint64_t request;
+    int status;
+    double ms;
+  };
+  std::vector<Event> events;
+  const char *levels[] = {"INFO", "WARN", "ERROR", "DEBUG"};
+  const std::string_view files[] = {"server.cc", "connection_pool.cc", "router.hpp"};
+  for (size_t i = 0; i < count; ++i)
+    events.push_back({1700000000000000 + static_cast<int64_t>(i * 1237), levels[i % 4],
+                      files[i % 3], static_cast<int>(i % 900), i * 0x9e3779b97f4a7c15u,
+                      i % 7 ? 200 : 503, static_cast<double>(i % 10007) / 7});
+
+  // Each formatter appends every line to one buffer.
+  std::vector<char> out(count * 160);
+  auto run = [&](const char *name, auto &&write) {
+    char *p = out.data();
+    Timer t(name);
+    for (const auto &e : events)
+      p = write(p, e);
+    const double ns = static_cast<double>(t.eclipse()) / count;
+    EXPECT_GT(p, out.data());
+    return std::make_pair(ns, std::string(out.data(), 200));
+  };
+
+  const auto ours = run("static_format", [](char *p, const Event &e) {
+    return formatting::format_to<"{} {:<5} {}:{} req={:016x} status={} {:.3f}ms\n">(
+        p, e.time_us, e.level, e.file, e.line, e.request, e.status, e.ms);
+  });
+  const auto printf = run("snprintf", [](char *p, const Event &e) {
+    return p + std::snprintf(p, 160, "%lld %-5s %.*s:%d req=%016llx status=%d %.3fms\n",
+                             static_cast<long long>(e.time_us), e.level,
+                             static_cast<int>(e.file.size()), e.file.data(), e.line,
+                             static_cast<unsigned long long>(e.request), e.status, e.ms);
+  });
+  EXPECT_EQ(ours.second, printf.second);
+
+  std::string sink;
+  Timer t("static_format to std::string");
+  for (const auto &e : events) {
+    sink.clear();
+    formatting::format_to<"{} {:<5} {}:{} req={:016x} status={} {:.3f}ms\n">(
+        sink, e.time_us, e.level, e.file, e.line, e.request, e.status, e.ms);
+  }
+  const double to_string_ns = static_cast<double>(t.eclipse()) / count;
+  EXPECT_FALSE(sink.empty());
+
+  std::ostringstream os;
+  Timer t2("ostringstream");
+  for (const auto &e : events)
+    os << e.time_us << ' ' << std::left << std::setw(5) << e.level << ' ' << e.file << ':'
+       << e.line << " req=" << std::hex << std::setw(16) << std::setfill('0') << std::right
+       << e.request << std::dec << std::setfill(' ') << " status=" << e.status << ' '
+       << std::fixed << std::setprecision(3) << e.ms << "ms\n";
+  const double stream_ns = static_cast<double>(t2.eclipse()) / count;
+  EXPECT_EQ(os.view().substr(0, 200), ours.second);
+
+#if defined(__cpp_lib_format)
+  const auto std_format = run("std::format_to_n", [](char *p, const Event &e) {
+    return std::format_to_n(p, 160, "{} {:<5} {}:{} req={:016x} status={} {:.3f}ms\n",
+                            e.time_us, e.level, e.file, e.line, e.request, e.status, e.ms)
+        .out;
+  });
+  EXPECT_EQ(std_format.second, ours.second);
+  std::string std_sink;
+  Timer t3("std::format");
+  for (const auto &e : events)
+    std_sink = std::format("{} {:<5} {}:{} req={:016x} status={} {:.3f}ms\n", e.time_us,
+                           e.level, e.file, e.line, e.request, e.status, e.ms);
+  const double std_format_ns = static_cast<double>(t3.eclipse()) / count;
+#else
+  const auto std_format = std::make_pair(0.0, std::string());
+  const double std_format_ns = 0;
+#endif
+
+#ifndef NDEBUG
+  std::cout << "ns per log line: static_format " << ours.first << ", to std::string "
+            << to_string_ns << ", snprintf " << printf.first << ", ostringstream "
+            << stream_ns;
+  if (std_format_ns > 0)
+    std::cout << ", std::format_to_n " << std_format.first << ", std::format " << std_format_ns;
+  std::cout << '\n';
+#else
+  (void)to_string_ns, (void)stream_ns, (void)std_format, (void)std_format_ns;
+#endif
+}
@@ -1,7 +1,13 @@
+#include "intern_pool.hpp"
+#include "my_timer.h"
 #include <cmath>
 #include <gtest/gtest.h>
 #include <iostream>
 #include <list>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
 
 template <typename T>
 struct Identity {
@@ -177,8 +183,8 @@ class Person {
 public:
   explicit Person(std::string lastname, std::string firstname)
       : firstname_(std::move(firstname)), lastname_(std::move(lastname)) {}
-  [[nodiscard]] std::string firstname() const { return firstname_; };
-  [[nodiscard]] std::string lastname() const { return lastname_; };
+  [[nodiscard]] const std::string &firstname() const { return firstname_; };
+  [[nodiscard]] const std::string &lastname() const { return lastname_; };
 
 private:
   std::string firstname_;
@@ -219,6 +225,110 @@ TEST(functor, basic_test_2) {
   EXPECT_TRUE(oss.str() == act_output);
 }
 
+// The same person with interned names: 8 bytes instead of two strings, and
+// a comparator that compares cached ranks instead of characters.
+class InternedPerson {
+public:
+  InternedPerson(strings::intern_pool &names, std::string_view lastname,
+                 std::string_view firstname)
+      : lastname_(names.intern(lastname)), firstname_(names.intern(firstname)) {}
+  [[nodiscard]] strings::symbol lastname() const { return lastname_; }
+  [[nodiscard]] strings::symbol firstname() const { return firstname_; }
+
+private:
+  strings::symbol lastname_;
+  strings::symbol firstname_;
+};
+
+class InternedPersonSortTraits {
+public:
+  explicit InternedPersonSortTraits(const strings::symbol_order &order) : order_(&order) {}
+  bool operator()(const InternedPerson &p1, const InternedPerson &p2) const {
+    if (p1.lastname() != p2.lastname())
+      return (*order_)(p1.lastname(), p2.lastname());
+    return p1.firstname() != p2.firstname() && (*order_)(p1.firstname(), p2.firstname());
+  }
+
+private:
+  const strings::symbol_order *order_;
+};
+
+TEST(functor, interned_person_benchmark) {
+  // 1M records drawn from 20k last names and 5k first names.
+  constexpr size_t records = 1000000;
+  std::mt19937 gen(44);
+  auto make_names = [&](size_t count) {
+    std::uniform_int_distribution<int> len(4, 12), letter('a', 'z');
+    std::vector<std::string> names(count);
+    for (auto &n : names) {
+      n.resize(len(gen));
+      for (char &c : n)
+        c = static_cast<char>(letter(gen));
+      n[0] = static_cast<char>(n[0] - 'a' + 'A');
+    }
+    return names;
+  };
+  const auto lastnames = make_names(20000);
+  const auto firstnames = make_names(5000);
+  std::uniform_int_distribution<size_t> pick_last(0, lastnames.size() - 1),
+      pick_first(0, firstnames.size() - 1);
+  std::vector<std::pair<size_t, size_t>> picks(records);
+  for (auto &[l, f] : picks)
+    l = pick_last(gen), f = pick_first(gen);
+
+  // Before: getters returning std::string by value, four copies per compare.
+  auto by_value = [](const Person &p1, const Person &p2) {
+    return std::string(p1.lastname()) < std::string(p2.lastname()) ||
+           (std::string(p1.lastname()) == std::string(p2.lastname()) &&
+            std::string(p1.firstname()) < std::string(p2.firstname()));
+  };
+  std::set<Person, decltype(by_value)> copied(by_value);
+  Timer t1("by value");
+  for (auto [l, f] : picks)
+    copied.emplace(lastnames[l], firstnames[f]);
+  auto copied_ns = t1.eclipse();
+
+  std::set<Person, PersonSortTraits> referenced;
+  Timer t2("by reference");
+  for (auto [l, f] : picks)
+    referenced.emplace(lastnames[l], firstnames[f]);
+  auto referenced_ns = t2.eclipse();
+
+  strings::intern_pool names;
+  Timer t3("interned");
+  std::vector<InternedPerson> people;
+  people.reserve(records);
+  for (auto [l, f] : picks)
+    people.emplace_back(names, lastnames[l], firstnames[f]);
+  const auto order = names.order();
+  auto interning_ns = t3.eclipse();
+  Timer t4("interned set");
+  std::set<InternedPerson, InternedPersonSortTraits> interned(InternedPersonSortTraits{order});
+  for (const auto &p : people)
+    interned.insert(p);
+  auto interned_ns = t4.eclipse();
+
+  ASSERT_EQ(interned.size(), referenced.size());
+  EXPECT_EQ(copied.size(), referenced.size());
+  EXPECT_EQ(names.view(interned.begin()->lastname()), referenced.begin()->lastname());
+  EXPECT_EQ(names.view(interned.rbegin()->firstname()), referenced.rbegin()->firstname());
+
+#ifndef NDEBUG
+  size_t string_bytes = 0;
+  for (const auto &p : referenced)
+    string_bytes += sizeof(std::string) * 2 +
+                    (p.lastname().size() > 15 ? p.lastname().capacity() + 1 : 0) +
+                    (p.firstname().size() > 15 ? p.firstname().capacity() + 1 : 0);
+  std::cout << referenced.size() << " people into a std::set, ms: strings by value "
+            << copied_ns / 1e6 << ", by const& " << referenced_ns / 1e6
+            << ", interned " << interned_ns / 1e6 << " (+ " << interning_ns / 1e6
+            << " interning); name bytes: strings " << string_bytes << ", interned "
+            << names.bytes() + sizeof(InternedPerson) * referenced.size() << '\n';
+#else
+  (void)copied_ns, (void)referenced_ns, (void)interning_ns, (void)interned_ns;
+#endif
+}
+
 class IntSequence {
 private:
   int value_;
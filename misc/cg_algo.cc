@@ -1,3 +1,4 @@
+#include "aligned_buffer.hpp"
 #include <iostream>
 #include <cmath>
 
@@ -28,10 +29,9 @@ int cg(int size, double *x, double *b, void (*prec)(int, double *, double *), do
 
   int i, j, iter = 0;
   double rho, rho_1, alpha;
-  double *p = new double[size];
-  double *q = new double[size];
-  double *r = new double[size];
-  double *z = new double[size];
+  // Work vectors: aligned, and not zeroed since each is written first.
+  containers::aligned_buffer<double> p_buf(size), q_buf(size), r_buf(size), z_buf(size);
+  double *p = p_buf.data(), *q = q_buf.data(), *r = r_buf.data(), *z = z_buf.data();
 
   // r = A * x;
   r[0] = 2.0 * x[0] - x[1];
@@ -70,11 +70,6 @@ int cg(int size, double *x, double *b, void (*prec)(int, double *, double *), do
     iter++;
   }
 
-  delete[] q;
-  delete[] p;
-  delete[] r;
-  delete[] z;
-
   return iter;
 }
 
@@ -102,14 +97,9 @@ int conjugate_gradient(const Matrix &A, Vector &x, const Vector &b,
 int main() {
   int size = 100;
 
-  double *x = new double[size];
-  double *b = new double[size];
-
-  // init.
-  std::fill(b, b + size, 1.0);
-  std::fill(x, x + size, 0.0);
+  containers::aligned_buffer<double> x(size, 0.0), b(size, 1.0);
 
-  cg(size, x, b, diag_prec, 1e-9);
+  cg(size, x.data(), b.data(), diag_prec, 1e-9);
 
   return 0;
 }
@@ -0,0 +1,219 @@
+#pragma once
+
+// DESCRIPTION:
+//  Release policies for reference_count::BasicObject: what happens when an
+//  object's count reaches zero.
+//
+//    * ImmediateRelease - delete it on the spot. Dropping the root of a large
+//                         graph destroys the whole graph inside that one
+//                         ~ref, recursively.
+//    * DeferredRelease  - push it onto the calling thread's zombie list. The
+//                         destructor runs later, from drain_deferred() at a
+//                         point the thread chooses, at most `max_objects` at a
+//                         time. Children released by that destructor are
+//                         pushed onto the same list, so a cascade becomes a
+//                         loop with bounded pauses and no recursion.
+//
+//  A DeferredReclaimer moves the work off the application threads: while one
+//  is running, a thread whose list reaches kHandOffSize, or that calls
+//  hand_off_deferred(), hands the whole list to it. The reclaimer destroys
+//  objects on its own thread, so it is only safe with a thread-safe counting
+//  policy (AtomicCount, SeqCstCount).
+//
+//  Zombies still on a thread's list when it exits are handed to a running
+//  reclaimer, or destroyed there and then.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace reference_count {
+
+struct ImmediateRelease {
+  using Destroy = void (*)(const void *);
+  static void release(const void *obj, Destroy destroy) { destroy(obj); }
+};
+
+struct DeferredReleaseStats {
+  size_t pending = 0;    // released but not yet destroyed, all threads
+  size_t destroyed = 0;  // destroyed so far, all threads
+  size_t handed_off = 0; // of those released, passed to a reclaimer
+};
+
+class DeferredRelease {
+public:
+  using Destroy = void (*)(const void *);
+
+  static constexpr size_t kDefaultBatch = 256;
+  static constexpr size_t kHandOffSize = 1024;
+
+  static void release(const void *obj, Destroy destroy) {
+    auto &list = local().zombies;
+    list.push_back({obj, destroy});
+    state().pending.fetch_add(1, std::memory_order_relaxed);
+    if (list.size() >= kHandOffSize && state().reclaimers.load(std::memory_order_relaxed))
+      hand_off(list);
+  }
+
+  /// Destroy up to `max_objects` zombies of the calling thread, including
+  /// any that those destructors release. Returns how many were destroyed.
+  static size_t drain(size_t max_objects = kDefaultBatch) {
+    auto &list = local().zombies;
+    size_t n = 0;
+    for (; n < max_objects && !list.empty(); ++n) {
+      Zombie z = list.back();
+      list.pop_back();
+      z.destroy(z.obj);
+    }
+    if (n)
+      note_destroyed(n);
+    return n;
+  }
+
+  /// Pass the calling thread's whole list to a running reclaimer now.
+  /// Returns false if there is none.
+  static bool flush() { return hand_off(local().zombies); }
+
+  /// Zombies waiting on the calling thread's list.
+  static size_t local_pending() { return local().zombies.size(); }
+
+  static DeferredReleaseStats stats() {
+    const State &s = state();
+    return {s.pending.load(std::memory_order_relaxed), s.destroyed.load(std::memory_order_relaxed),
+            s.handed_off.load(std::memory_order_relaxed)};
+  }
+
+private:
+  friend class DeferredReclaimer;
+
+  struct Zombie {
+    const void *obj;
+    Destroy destroy;
+  };
+
+  struct LocalList {
+    std::vector<Zombie> zombies;
+    ~LocalList() {
+      if (!hand_off(zombies))
+        while (drain(SIZE_MAX))
+          ;
+    }
+  };
+
+  /// Never destroyed, so threads can still release objects during exit.
+  struct State {
+    std::atomic<size_t> pending{0};
+    std::atomic<size_t> destroyed{0};
+    std::atomic<size_t> handed_off{0};
+    std::atomic<int> reclaimers{0}; // written under mutex
+
+    std::mutex mutex;
+    std::condition_variable work;
+    std::vector<Zombie> shared; // under mutex
+  };
+
+  static State &state() {
+    static State *s = new State;
+    return *s;
+  }
+
+  static LocalList &local() {
+    thread_local LocalList list;
+    return list;
+  }
+
+  static void note_destroyed(size_t n) {
+    state().pending.fetch_sub(n, std::memory_order_relaxed);
+    state().destroyed.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  /// Returns false, leaving `list` alone, if no reclaimer is running.
+  static bool hand_off(std::vector<Zombie> &list) {
+    State &s = state();
+    {
+      std::lock_guard<std::mutex> lock(s.mutex);
+      if (!s.reclaimers.load(std::memory_order_relaxed))
+        return false;
+      s.handed_off.fetch_add(list.size(), std::memory_order_relaxed);
+      if (s.shared.empty())
+        s.shared.swap(list);
+      else
+        s.shared.insert(s.shared.end(), list.begin(), list.end());
+    }
+    list.clear();
+    s.work.notify_one();
+    return true;
+  }
+};
+
+/// Background thread that destroys zombies handed off by other threads, in
+/// batches of `batch`. It waits `idle_interval` between checks when there is
+/// nothing to do. On destruction it finishes all work handed to it.
+class DeferredReclaimer {
+public:
+  explicit DeferredReclaimer(size_t batch = DeferredRelease::kDefaultBatch,
+                             std::chrono::microseconds idle_interval = std::chrono::milliseconds(1))
+      : batch_(batch), idle_interval_(idle_interval) {
+    {
+      std::lock_guard<std::mutex> lock(DeferredRelease::state().mutex);
+      DeferredRelease::state().reclaimers.fetch_add(1, std::memory_order_relaxed);
+    }
+    thread_ = std::thread([this] { run(); });
+  }
+
+  DeferredReclaimer(const DeferredReclaimer &) = delete;
+  DeferredReclaimer &operator=(const DeferredReclaimer &) = delete;
+
+  ~DeferredReclaimer() {
+    {
+      std::lock_guard<std::mutex> lock(DeferredRelease::state().mutex);
+      DeferredRelease::state().reclaimers.fetch_sub(1, std::memory_order_relaxed);
+      stop_ = true;
+    }
+    DeferredRelease::state().work.notify_all();
+    thread_.join();
+  }
+
+private:
+  void run() {
+    auto &s = DeferredRelease::state();
+    auto &mine = DeferredRelease::local().zombies;
+    while (true) {
+      // Our own list first: destructors we ran may have released more.
+      if (DeferredRelease::drain(batch_))
+        continue;
+
+      std::unique_lock<std::mutex> lock(s.mutex);
+      s.work.wait_for(lock, idle_interval_, [&] { return stop_ || !s.shared.empty(); });
+      if (s.shared.empty()) {
+        if (stop_)
+          return;
+        continue;
+      }
+      // Take at most one batch so other reclaimers can share the work.
+      const size_t take = std::min(batch_, s.shared.size());
+      mine.insert(mine.end(), s.shared.end() - take, s.shared.end());
+      s.shared.resize(s.shared.size() - take);
+    }
+  }
+
+  const size_t batch_;
+  const std::chrono::microseconds idle_interval_;
+  bool stop_ = false; // under DeferredRelease::state().mutex
+  std::thread thread_;
+};
+
+/// Destroy up to `max_objects` objects released on the calling thread.
+inline size_t drain_deferred(size_t max_objects = DeferredRelease::kDefaultBatch) {
+  return DeferredRelease::drain(max_objects);
+}
+
+/// Give everything released on the calling thread to a DeferredReclaimer.
+inline bool hand_off_deferred() { return DeferredRelease::flush(); }
+
+} // end of namespace reference_count
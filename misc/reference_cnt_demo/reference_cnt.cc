@@ -1,5 +1,9 @@
 #include "reference_cnt.h"
+#include "my_timer.h"
 #include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include <vector>
 
 class MyClass : public reference_count::Object {
 private:
@@ -25,4 +29,236 @@ TEST(reference_count, basic_test) {
 
   obj->incRef();
   EXPECT_EQ(obj->getRefCount(), 2);
-}
\ No newline at end of file
+}
+
+namespace {
+
+template <typename Policy> class Counted : public reference_count::BasicObject<Policy> {
+public:
+  explicit Counted(int *destroyed = nullptr) : destroyed_(destroyed) {}
+  ~Counted() override {
+    if (destroyed_)
+      ++*destroyed_;
+  }
+
+private:
+  int *destroyed_;
+};
+
+/// Copy a reference into a ring of slots, so every step is one incRef on the
+/// new copy and one decRef on the copy it replaces.
+template <typename Policy> uint64_t copy_heavy(size_t copies) {
+  using namespace reference_count;
+  ref<Counted<Policy>> origin{new Counted<Policy>};
+  std::vector<ref<Counted<Policy>>> ring(256);
+
+  Timer t("copy_heavy");
+  for (size_t i = 0; i < copies; ++i) {
+    ring[i % ring.size()] = ref<Counted<Policy>>{};
+    ring[i % ring.size()] = origin;
+  }
+  return t.eclipse();
+}
+
+} // namespace
+
+TEST(reference_count, policies) {
+  using namespace reference_count;
+
+  int destroyed = 0;
+  {
+    ref<Counted<NonAtomicCount>> a{new Counted<NonAtomicCount>{&destroyed}};
+    ref<Counted<AtomicCount>> b{new Counted<AtomicCount>{&destroyed}};
+    ref<Counted<SeqCstCount>> c{new Counted<SeqCstCount>{&destroyed}};
+    ref<Counted<BiasedCount>> d{new Counted<BiasedCount>{&destroyed}};
+    auto a2 = a;
+    auto b2 = b;
+    auto c2 = c;
+    auto d2 = d;
+    EXPECT_EQ(a->getRefCount(), 2);
+    EXPECT_EQ(b->getRefCount(), 2);
+    EXPECT_EQ(c->getRefCount(), 2);
+    EXPECT_EQ(d->getRefCount(), 2);
+  }
+  EXPECT_EQ(destroyed, 4);
+}
+
+TEST(reference_count, biased_cross_thread) {
+  using namespace reference_count;
+  using Obj = Counted<BiasedCount>;
+
+  // Released on the owner after all foreign references are gone.
+  int destroyed = 0;
+  {
+    ref<Obj> owner{new Obj{&destroyed}};
+    std::thread([copy = owner]() mutable {
+      std::vector<ref<Obj>> more(100, copy);
+    }).join();
+    EXPECT_EQ(destroyed, 0);
+  }
+  EXPECT_EQ(destroyed, 1);
+
+  // A reference made on the owner but dropped elsewhere is handed back.
+  destroyed = 0;
+  {
+    ref<Obj> owner{new Obj{&destroyed}};
+    ref<Obj> moved = owner;
+    std::thread([r = std::move(moved)]() mutable { r = ref<Obj>{}; }).join();
+    EXPECT_EQ(owner->getRefCount(), 2); // the handed-back reference is pending
+    drain_biased_releases();
+    EXPECT_EQ(owner->getRefCount(), 1);
+  }
+  EXPECT_EQ(destroyed, 1);
+
+  // The last reference outlives its owner thread.
+  std::atomic<int> destroyed_late = 0;
+  struct Late : BasicObject<BiasedCount> {
+    std::atomic<int> *out;
+    explicit Late(std::atomic<int> *o) : out(o) {}
+    ~Late() override { ++*out; }
+  };
+  ref<Late> survivor;
+  std::thread([&] {
+    ref<Late> r{new Late{&destroyed_late}};
+    survivor = r;
+  }).join();
+  EXPECT_EQ(destroyed_late, 0);
+  survivor = ref<Late>{};
+  EXPECT_EQ(destroyed_late, 1);
+
+  // Many threads sharing one object.
+  destroyed = 0;
+  {
+    ref<Obj> owner{new Obj{&destroyed}};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+      threads.emplace_back([copy = owner] {
+        for (int i = 0; i < 10000; ++i) {
+          ref<Obj> local = copy;
+          (void)local;
+        }
+      });
+    for (auto &t : threads)
+      t.join();
+  }
+  EXPECT_EQ(destroyed, 1);
+}
+
+TEST(reference_count, copy_heavy_benchmark) {
+  using namespace reference_count;
+  constexpr size_t copies = 10'000'000;
+
+  auto non_atomic = copy_heavy<NonAtomicCount>(copies);
+  auto atomic = copy_heavy<AtomicCount>(copies);
+  auto seq_cst = copy_heavy<SeqCstCount>(copies);
+  auto biased = copy_heavy<BiasedCount>(copies);
+
+#ifndef NDEBUG
+  auto per_copy = [&](uint64_t ns) { return static_cast<double>(ns) / copies; };
+  std::cout << "ref<T> copy, ns/copy: non-atomic " << per_copy(non_atomic) << ", atomic "
+            << per_copy(atomic) << ", seq_cst " << per_copy(seq_cst) << ", biased "
+            << per_copy(biased) << '\n';
+#else
+  (void)non_atomic, (void)atomic, (void)seq_cst, (void)biased;
+#endif
+}
+
+namespace {
+
+template <typename Base> struct TreeNode : Base {
+  reference_count::ref<TreeNode> left, right;
+};
+
+template <typename Base> reference_count::ref<TreeNode<Base>> build_tree(int depth) {
+  reference_count::ref<TreeNode<Base>> node{new TreeNode<Base>};
+  if (depth > 1) {
+    node->left = build_tree<Base>(depth - 1);
+    node->right = build_tree<Base>(depth - 1);
+  }
+  return node;
+}
+
+using DeferredNode = TreeNode<reference_count::DeferredObject>;
+
+} // namespace
+
+TEST(reference_count, deferred_release) {
+  using namespace reference_count;
+  constexpr size_t length = 200000; // far deeper than ImmediateRelease could recurse
+
+  const auto before = DeferredRelease::stats();
+  ref<DeferredNode> head{new DeferredNode};
+  for (size_t i = 1; i < length; ++i) {
+    ref<DeferredNode> n{new DeferredNode};
+    n->left = std::move(head);
+    head = std::move(n);
+  }
+
+  head = ref<DeferredNode>{};
+  EXPECT_EQ(DeferredRelease::local_pending(), 1);
+  EXPECT_EQ(DeferredRelease::stats().pending, before.pending + 1);
+
+  // Every destructor releases the next node onto the list, so each bounded
+  // drain makes progress without recursing.
+  EXPECT_EQ(drain_deferred(1000), 1000);
+  EXPECT_EQ(DeferredRelease::local_pending(), 1);
+  while (drain_deferred())
+    ;
+  EXPECT_EQ(DeferredRelease::local_pending(), 0);
+  EXPECT_EQ(DeferredRelease::stats().pending, before.pending);
+  EXPECT_EQ(DeferredRelease::stats().destroyed, before.destroyed + length);
+}
+
+TEST(reference_count, deferred_reclaimer) {
+  using namespace reference_count;
+  EXPECT_FALSE(hand_off_deferred());
+
+  const auto before = DeferredRelease::stats();
+  {
+    DeferredReclaimer reclaimer;
+    std::thread([] {
+      auto root = build_tree<DeferredObject>(14);
+      root = ref<DeferredNode>{};
+      EXPECT_TRUE(hand_off_deferred());
+      EXPECT_EQ(DeferredRelease::local_pending(), 0);
+    }).join();
+  }
+  // The reclaimer finishes everything handed to it before it stops.
+  const auto after = DeferredRelease::stats();
+  EXPECT_EQ(after.pending, before.pending);
+  EXPECT_EQ(after.destroyed, before.destroyed + (1u << 14) - 1);
+  EXPECT_GE(after.handed_off, before.handed_off + 1);
+}
+
+TEST(reference_count, deferred_release_benchmark) {
+  using namespace reference_count;
+  constexpr int depth = 20; // ~1M nodes
+
+  auto immediate_tree = build_tree<Object>(depth);
+  Timer t1("immediate release");
+  immediate_tree = ref<TreeNode<Object>>{};
+  auto immediate_pause = t1.eclipse();
+
+  auto deferred_tree = build_tree<DeferredObject>(depth);
+  Timer t2("deferred release");
+  deferred_tree = ref<DeferredNode>{};
+  uint64_t worst_drain = 0;
+  size_t drains = 0;
+  while (true) {
+    auto start = std::chrono::steady_clock::now();
+    if (!drain_deferred())
+      break;
+    auto pause = std::chrono::steady_clock::now() - start;
+    worst_drain = std::max<uint64_t>(worst_drain, std::chrono::nanoseconds(pause).count());
+    ++drains;
+  }
+  auto deferred_total = t2.eclipse();
+
+#ifndef NDEBUG
+  std::cout << "release of " << (1u << depth) - 1 << " nodes: immediate pause "
+            << immediate_pause / 1000 << "us; deferred " << drains << " drains, worst "
+            << worst_drain / 1000 << "us, total " << deferred_total / 1000 << "us\n";
+#else
+  (void)immediate_pause, (void)deferred_total;
+#endif
+}
@@ -1,54 +1,329 @@
 #pragma once
+
+// DESCRIPTION:
+//  Intrusive reference counting. Objects derive from BasicObject<CountPolicy>
+//  and are held through ref<T>. The policy decides how the count is updated:
+//
+//    * NonAtomicCount - plain int. For objects that never leave one thread.
+//    * AtomicCount    - relaxed increment, acq_rel decrement. A new reference
+//                       can only be made from an existing one, so increments
+//                       need no ordering; the final decrement must see every
+//                       other thread's writes before the object is destroyed.
+//                       This is the default (Object).
+//    * SeqCstCount    - seq_cst ++/--; what Object used to do, kept as a
+//                       baseline.
+//    * BiasedCount    - biased reference counting (Choi et al., PACT'18). The
+//                       thread that created the object counts in a plain int;
+//                       other threads use an atomic counter. See below.
+//
+//  A second policy decides when an object whose count reached zero is
+//  destroyed; see deferred_release.h.
+
+#include "deferred_release.h"
+#include "relocation.hpp"
 #include <atomic>
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace reference_count {
 
-class Object {
+struct NonAtomicCount {
+  NonAtomicCount() = default;
+  NonAtomicCount(const NonAtomicCount &) {}
+
+  void inc() { ++count_; }
+  template <typename Obj> int dec(const Obj *) { return --count_; }
+  [[nodiscard]] int get() const { return count_; }
+
+private:
+  int count_ = 0;
+};
+
+struct AtomicCount {
+  AtomicCount() = default;
+  AtomicCount(const AtomicCount &) {}
+
+  void inc() { count_.fetch_add(1, std::memory_order_relaxed); }
+  template <typename Obj> int dec(const Obj *) {
+    return count_.fetch_sub(1, std::memory_order_acq_rel) - 1;
+  }
+  /// Acquire, so a caller that sees 1 also sees everything the other owners
+  /// did before they let go (copy-on-write relies on this).
+  [[nodiscard]] int get() const { return count_.load(std::memory_order_acquire); }
+
+private:
+  std::atomic<int> count_{0};
+};
+
+struct SeqCstCount {
+  SeqCstCount() = default;
+  SeqCstCount(const SeqCstCount &) {}
+
+  void inc() { ++count_; }
+  template <typename Obj> int dec(const Obj *) { return --count_; }
+  [[nodiscard]] int get() const { return count_; }
+
+private:
+  std::atomic<int> count_{0};
+};
+
+/// Biased reference counting.
+///
+/// The owner (creating) thread keeps its references in `biased_`, a plain int.
+/// Other threads add and drop references in `shared_`, an atomic that also
+/// carries a "merged" bit. A reference may be created on one thread and
+/// dropped on another, so:
+///
+///  * A non-owner that would take an unmerged shared count below zero hands
+///    its reference to the owner's queue instead. The owner drops it, with a
+///    plain decrement, on its next decRef of any biased object, in
+///    drain_biased_releases(), or when it exits.
+///  * When the owner's count reaches zero it sets the merged bit. From then on
+///    the shared count is the whole count and every thread uses it.
+///  * If the owner has exited, a non-owner folds the biased count into the
+///    shared one itself, under the registry lock the owner took last.
+class BiasedCount {
 public:
+  BiasedCount() : owner_(Registry::register_thread()) {}
+  BiasedCount(const BiasedCount &) : BiasedCount() {}
+
+  void inc() {
+    if (owner_ == Registry::local().token && !merged_) {
+      ++biased_;
+      return;
+    }
+    shared_.fetch_add(kOne, std::memory_order_relaxed);
+  }
+
+  /// Returns the count left, or a positive value when only the owner knows it.
+  template <typename Obj> int dec(const Obj *self) {
+    auto &local = Registry::local();
+    if (owner_ == local.token && !merged_) {
+      if (local.queue && local.queue->pending.load(std::memory_order_relaxed))
+        Registry::instance().drain(*local.queue);
+      if (--biased_ > 0)
+        return biased_;
+      merged_ = true;
+      return count(shared_.fetch_or(kMerged, std::memory_order_acq_rel));
+    }
+
+    int64_t s = shared_.load(std::memory_order_relaxed);
+    while (true) {
+      if (!(s & kMerged) && count(s) == 0) {
+        if (Registry::instance().hand_to_owner(owner_, self, [](const void *p) {
+              static_cast<const Obj *>(p)->decRef();
+            }))
+          return 1;
+        if (merge_for_dead_owner())
+          return 0;
+        s = shared_.load(std::memory_order_relaxed);
+        continue;
+      }
+      if (shared_.compare_exchange_weak(s, s - kOne, std::memory_order_acq_rel))
+        return s & kMerged ? count(s) - 1 : 1;
+    }
+  }
+
+  /// Exact only when no other thread touches the object.
+  [[nodiscard]] int get() const {
+    return (merged_ ? 0 : biased_) + count(shared_.load(std::memory_order_relaxed));
+  }
+
+  /// Let the calling owner thread drop references other threads handed back.
+  static void drain_owner_queue() {
+    if (auto *queue = Registry::local().queue)
+      Registry::instance().drain(*queue);
+  }
+
+private:
+  static constexpr int64_t kMerged = 1;
+  static constexpr int64_t kOne = 2;
+
+  static int count(int64_t s) { return static_cast<int>(s >> 1); }
+
+  /// Tracks live owner threads and their hand-back queues. Never destroyed,
+  /// so owners can still drain from thread_local destructors at exit.
+  class Registry {
+  public:
+    using Release = void (*)(const void *);
+
+    struct Queue {
+      std::atomic<bool> pending{false};
+      std::vector<std::pair<const void *, Release>> items; // under mutex_
+    };
+
+    /// Token 0 means "never created a biased object", so it owns nothing.
+    /// Tokens are never reused, unlike std::thread::id, so a new thread
+    /// cannot inherit a dead owner's count.
+    struct Local {
+      uint64_t token = 0;
+      Queue *queue = nullptr;
+    };
+
+    static Registry &instance() {
+      static Registry *registry = new Registry;
+      return *registry;
+    }
+
+    static Local &local() {
+      thread_local constinit Local l;
+      return l;
+    }
+
+    static uint64_t register_thread() {
+      Local &l = local();
+      if (!l.token) {
+        Registry &r = instance();
+        std::lock_guard<std::mutex> lock(r.mutex_);
+        l.token = ++r.next_token_;
+        auto &slot = r.queues_[l.token];
+        slot = std::make_unique<Queue>();
+        l.queue = slot.get();
+        thread_local ExitHook hook;
+      }
+      return l.token;
+    }
+
+    bool hand_to_owner(uint64_t owner, const void *obj, Release release) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = queues_.find(owner);
+      if (it == queues_.end())
+        return false;
+      it->second->items.emplace_back(obj, release);
+      it->second->pending.store(true, std::memory_order_relaxed);
+      return true;
+    }
+
+    void drain(Queue &queue) {
+      std::vector<std::pair<const void *, Release>> items;
+      while (true) {
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          queue.pending.store(false, std::memory_order_relaxed);
+          if (queue.items.empty())
+            return;
+          items.swap(queue.items);
+        }
+        for (auto [obj, release] : items)
+          release(obj);
+        items.clear();
+      }
+    }
+
+    std::mutex &mutex() { return mutex_; }
+
+  private:
+    struct ExitHook {
+      ~ExitHook() {
+        // Drain until the queue stays empty, then unregister in the same
+        // critical section, so nothing can be queued after the last drain.
+        Registry &r = instance();
+        Local &l = local();
+        while (true) {
+          r.drain(*l.queue);
+          std::lock_guard<std::mutex> lock(r.mutex_);
+          if (l.queue->items.empty()) {
+            r.queues_.erase(l.token);
+            l.queue = nullptr;
+            return;
+          }
+        }
+      }
+    };
+
+    std::mutex mutex_;
+    uint64_t next_token_ = 0;
+    std::unordered_map<uint64_t, std::unique_ptr<Queue>> queues_;
+  };
+
+  /// The owner is gone, so its biased count is frozen. Fold it into the
+  /// shared count. Returns true if that leaves no references at all.
+  bool merge_for_dead_owner() {
+    std::lock_guard<std::mutex> lock(Registry::instance().mutex());
+    if (merged_)
+      return false; // another thread merged first; retry on the shared count
+    merged_ = true;
+    // Our own reference is one of the biased ones; drop it while folding.
+    const int64_t delta = int64_t{biased_ - 1} * kOne + kMerged;
+    return count(shared_.fetch_add(delta, std::memory_order_acq_rel) + delta) == 0;
+  }
+
+  const uint64_t owner_;
+  int biased_ = 0;
+  bool merged_ = false;
+  std::atomic<int64_t> shared_{0};
+};
+
+template <typename CountPolicy = AtomicCount, typename ReleasePolicy = ImmediateRelease>
+class BasicObject {
+public:
+  using count_policy = CountPolicy;
+  using release_policy = ReleasePolicy;
+
   /// Default constructor
-  Object() = default;
+  BasicObject() = default;
 
   /// Copy constructor
-  Object(const Object &) : ref_count_(0) {}
+  BasicObject(const BasicObject &) : ref_count_() {}
 
   /// Return the current reference count
-  [[nodiscard]] int getRefCount() const { return ref_count_; };
+  [[nodiscard]] int getRefCount() const { return ref_count_.get(); };
 
   /// Increase the object's reference count by one
-  void incRef() const { ++ref_count_; }
+  void incRef() const { ref_count_.inc(); }
 
   void decRef(bool dealloc = true) const noexcept {
-    --ref_count_;
-    if (ref_count_ == 0 && dealloc)
-      delete this;
-    else if (ref_count_ < 0) {
+    const int left = ref_count_.dec(this);
+    if (left == 0 && dealloc)
+      ReleasePolicy::release(this, &BasicObject::destroy);
+    else if (left < 0) {
       std::cerr << "Internal error: Object reference count < 0!\n";
     }
   }
 
 protected:
-  virtual ~Object() = default;
+  virtual ~BasicObject() = default;
 
 private:
-  mutable std::atomic<int> ref_count_{0};
+  static void destroy(const void *p) { delete static_cast<const BasicObject *>(p); }
+
+  mutable CountPolicy ref_count_;
 };
 
+using Object = BasicObject<>;
+
+/// Destroyed from drain_deferred() or a DeferredReclaimer, not in ~ref.
+using DeferredObject = BasicObject<AtomicCount, DeferredRelease>;
+
+/// Owner threads of BasicObject<BiasedCount> call this at convenient points
+/// to release references other threads dropped. It also runs at thread exit.
+inline void drain_biased_releases() { BiasedCount::drain_owner_queue(); }
+
 template <typename T> class ref {
 public:
+  /// Only a pointer: containers may move a ref by copying its bytes
+  /// (containers::is_trivially_relocatable).
+  using trivially_relocatable = containers::relocatable_tag<ref>;
+
   /// Create a ``nullptr``-valued reference
   ref() = default;
 
   /// Construct a reference from a pointer
   explicit ref(T *ptr) : ptr_(ptr) {
     if (ptr_)
-      ((Object *)ptr_)->incRef();
+      ptr_->incRef();
   }
 
   /// Copy constructor
   ref(const ref &r) : ptr_(r.ptr_) {
     if (ptr_)
-      ((Object *)ptr_)->incRef();
+      ptr_->incRef();
   }
 
   /// Move constructor
@@ -57,14 +332,14 @@ public:
   /// Destroy this reference
   ~ref() {
     if (ptr_)
-      ((Object *)ptr_)->decRef();
+      ptr_->decRef();
   }
 
   /// Move another reference into the current one
   ref &operator=(ref &&r) noexcept {
     if (&r != this) {
       if (ptr_)
-        ((Object *)ptr_)->decRef();
+        ptr_->decRef();
       ptr_ = r.ptr_;
       r.ptr_ = nullptr;
     }
@@ -75,9 +350,9 @@ public:
   ref &operator=(const ref &r) noexcept {
     if (ptr_ != r.ptr_) {
       if (r.ptr_)
-        ((Object *)r.ptr_)->incRef();
+        r.ptr_->incRef();
       if (ptr_)
-        ((Object *)ptr_)->decRef();
+        ptr_->decRef();
       ptr_ = r.ptr_;
     }
     return *this;
@@ -87,9 +362,9 @@ public:
   ref &operator=(T *ptr) noexcept {
     if (ptr_ != ptr) {
       if (ptr)
-        ((Object *)ptr)->incRef();
+        ptr->incRef();
       if (ptr_)
-        ((Object *)ptr_)->decRef();
+        ptr_->decRef();
       ptr_ = ptr;
     }
     return *this;
@@ -135,4 +410,4 @@ private:
   T *ptr_ = nullptr;
 };
 
-} // end of namespace reference_count
\ No newline at end of file
+} // end of namespace reference_count
@@ -1,4 +1,10 @@
+#include "my_timer.h"
+#include "sso_string.hpp"
+#include <cstring>
 #include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
 
 TEST(small_string_optimization, sso_cow_test) {
   std::string a = "hello world";
@@ -15,4 +21,146 @@ TEST(small_string_optimization, sso_cow_test) {
   EXPECT_FALSE(res1);
   EXPECT_FALSE(res2);
   EXPECT_FALSE(res3);
-}
\ No newline at end of file
+}
+
+TEST(small_string_optimization, sso_string_inline_and_heap) {
+  using Str = strings::basic_sso_string<23>;
+  static_assert(Str::heap_threshold == 23);
+
+  Str a = "twenty-three chars long";
+  EXPECT_EQ(a.size(), 23);
+  EXPECT_TRUE(a.is_inline());
+  a += '!';
+  EXPECT_FALSE(a.is_inline());
+  EXPECT_EQ(a, "twenty-three chars long!");
+  EXPECT_EQ(a.c_str()[a.size()], '\0');
+
+  Str b = a;
+  EXPECT_NE(b.data(), a.data());
+  const char *heap = b.data();
+  Str c = std::move(b); // steals the heap buffer
+  EXPECT_EQ(c.data(), heap);
+  EXPECT_TRUE(b.empty());
+
+  c.append(c); // appending itself while reallocating
+  EXPECT_EQ(c.size(), 48);
+  EXPECT_EQ(std::string_view(c).substr(24), "twenty-three chars long!");
+
+  Str small{"key"};
+  c = small;
+  EXPECT_EQ(c, "key");
+  EXPECT_LT(c, Str("kez"));
+  EXPECT_EQ(std::hash<Str>{}(c), std::hash<std::string_view>{}("key"));
+
+  // A 63-char buffer holds what the 23-char one spills.
+  strings::basic_sso_string<63> wide{std::string_view(a)};
+  EXPECT_TRUE(wide.is_inline());
+}
+
+TEST(small_string_optimization, sso_string_resize_and_overwrite) {
+  strings::sso_string s = "id-";
+  s.resize_and_overwrite(40, [](char *p, size_t n) {
+    EXPECT_EQ(std::string_view(p, 3), "id-"); // old contents kept
+    std::memset(p + 3, 'x', n - 3 - 10);
+    return n - 10; // may finish shorter than asked
+  });
+  EXPECT_EQ(s.size(), 30);
+  EXPECT_EQ(s.back(), 'x');
+  EXPECT_EQ(s.c_str()[30], '\0');
+
+  s.resize(32, '-');
+  EXPECT_EQ(std::string_view(s).substr(28), "xx--");
+  s.resize(2);
+  EXPECT_EQ(s, "id");
+}
+
+namespace {
+
+/// Key lengths shaped like typical map keys: mostly short identifiers, a
+/// bulge of 16-31 char names and tags (UUIDs without dashes, dotted paths),
+/// and a thin tail of long ones.
+std::vector<std::string> make_keys(size_t count) {
+  std::mt19937 gen(42);
+  std::discrete_distribution<int> bucket({30, 35, 20, 10, 5});
+  const std::pair<int, int> ranges[] = {{4, 15}, {16, 23}, {24, 31}, {32, 63}, {64, 128}};
+  std::uniform_int_distribution<int> letter('a', 'z');
+  std::vector<std::string> keys;
+  keys.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    auto [lo, hi] = ranges[bucket(gen)];
+    std::string k(std::uniform_int_distribution<int>(lo, hi)(gen), ' ');
+    for (char &c : k)
+      c = static_cast<char>(letter(gen));
+    keys.push_back(std::move(k));
+  }
+  return keys;
+}
+
+struct KeyTimings {
+  uint64_t construct, copy, compare, hash;
+};
+
+template <typename Str> KeyTimings key_workload(const std::vector<std::string> &src, size_t &sink) {
+  KeyTimings t{};
+  std::vector<Str> keys;
+  keys.reserve(src.size());
+  {
+    Timer timer("construct");
+    for (const auto &s : src)
+      keys.emplace_back(std::string_view(s));
+    t.construct = timer.eclipse();
+  }
+  {
+    std::vector<Str> copies;
+    copies.reserve(keys.size());
+    Timer timer("copy");
+    for (const auto &k : keys)
+      copies.push_back(k);
+    t.copy = timer.eclipse();
+    sink += copies.back().size();
+  }
+  {
+    Timer timer("compare");
+    for (size_t i = 1; i < keys.size(); ++i)
+      sink += keys[i - 1] < keys[i];
+    t.compare = timer.eclipse();
+  }
+  {
+    std::hash<Str> h;
+    Timer timer("hash");
+    for (const auto &k : keys)
+      sink += h(k);
+    t.hash = timer.eclipse();
+  }
+  return t;
+}
+
+} // namespace
+
+TEST(small_string_optimization, sso_string_key_benchmark) {
+  const auto keys = make_keys(1000000);
+  size_t a = 0, b = 0, c = 0, d = 0;
+  auto std_t = key_workload<std::string>(keys, a);
+  auto sso23 = key_workload<strings::basic_sso_string<23>>(keys, b);
+  auto sso31 = key_workload<strings::basic_sso_string<31>>(keys, c);
+  auto sso63 = key_workload<strings::basic_sso_string<63>>(keys, d);
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(a, c);
+  EXPECT_EQ(a, d);
+
+#ifndef NDEBUG
+  auto row = [&](const char *name, size_t size, const KeyTimings &t) {
+    auto ms = [](uint64_t ns) { return ns / 1e6; };
+    std::cout << name << " (sizeof " << size << "): construct " << ms(t.construct) << " ms, copy "
+              << ms(t.copy) << " ms, compare " << ms(t.compare) << " ms, hash " << ms(t.hash)
+              << " ms\n";
+  };
+  std::cout << keys.size() << " keys:\n";
+  row("std::string        ", sizeof(std::string), std_t);
+  row("basic_sso_string<23>", sizeof(strings::basic_sso_string<23>), sso23);
+  row("basic_sso_string<31>", sizeof(strings::basic_sso_string<31>), sso31);
+  row("basic_sso_string<63>", sizeof(strings::basic_sso_string<63>), sso63);
+#else
+  (void)std_t, (void)sso23, (void)sso31, (void)sso63;
+#endif
+}
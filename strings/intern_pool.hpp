@@ -0,0 +1,208 @@
+#pragma once
+
+// DESCRIPTION:
+//  String interning: every distinct string is stored once and named by a
+//  32-bit symbol id.
+//
+//  * intern(s) returns the symbol for s, adding it on first sight. Equal
+//    strings get equal symbols, so equality and hashing are integer ops.
+//  * view(sym) returns the string. The characters live in arena chunks that
+//    are never moved or freed before the pool, so the view stays valid.
+//  * order() snapshots the lexicographic rank of every symbol so far; its
+//    comparator orders two symbols with two array loads. Symbols interned
+//    after the snapshot fall back to comparing their strings.
+//
+//  Thread safety: intern() takes one of kShards mutexes, picked by the
+//  string's hash. view() takes no lock: ids index a table of blocks that
+//  double in size and are never reallocated.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace strings {
+
+struct symbol {
+  uint32_t id;
+  friend bool operator==(symbol, symbol) = default;
+};
+
+class intern_pool;
+
+/// Lexicographic ranks of a pool's symbols, as of the order() call.
+class symbol_order {
+public:
+  bool operator()(symbol a, symbol b) const noexcept {
+    if (a.id < ranks_.size() && b.id < ranks_.size())
+      return ranks_[a.id] < ranks_[b.id];
+    return less_by_text(a, b);
+  }
+
+  /// Position of `s` among the snapshot's strings; only for symbols that
+  /// existed when the snapshot was taken.
+  [[nodiscard]] uint32_t rank(symbol s) const noexcept { return ranks_[s.id]; }
+  [[nodiscard]] size_t size() const noexcept { return ranks_.size(); }
+
+private:
+  friend class intern_pool;
+  symbol_order(const intern_pool *pool, std::vector<uint32_t> ranks)
+      : pool_(pool), ranks_(std::move(ranks)) {}
+  bool less_by_text(symbol a, symbol b) const noexcept;
+
+  const intern_pool *pool_;
+  std::vector<uint32_t> ranks_;
+};
+
+class intern_pool {
+public:
+  static constexpr size_t kShards = 16;
+
+  intern_pool() = default;
+  intern_pool(const intern_pool &) = delete;
+  intern_pool &operator=(const intern_pool &) = delete;
+
+  ~intern_pool() {
+    for (size_t b = 0; b < kBlocks; ++b)
+      delete[] blocks_[b].load(std::memory_order_relaxed);
+  }
+
+  symbol intern(std::string_view s) {
+    const size_t h = std::hash<std::string_view>{}(s);
+    Shard &shard = shards_[h % kShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (auto it = shard.index.find(s); it != shard.index.end())
+      return {it->second};
+
+    const std::string_view stored = shard.store(s);
+    const auto id = next_id_.fetch_add(1, std::memory_order_relaxed);
+    slot(id) = stored;
+    shard.index.emplace(stored, id);
+    return {id};
+  }
+
+  /// The symbol for s if it has been interned.
+  [[nodiscard]] std::optional<symbol> find(std::string_view s) const {
+    const Shard &shard = shards_[std::hash<std::string_view>{}(s) % kShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (auto it = shard.index.find(s); it != shard.index.end())
+      return symbol{it->second};
+    return std::nullopt;
+  }
+
+  /// The string of a symbol from this pool. Lock-free.
+  [[nodiscard]] std::string_view view(symbol s) const noexcept {
+    auto [block, offset] = locate(s.id);
+    return blocks_[block].load(std::memory_order_acquire)[offset];
+  }
+
+  /// Distinct strings interned so far.
+  [[nodiscard]] size_t size() const noexcept { return next_id_.load(std::memory_order_relaxed); }
+
+  /// Bytes of string data held (each distinct string once).
+  [[nodiscard]] size_t bytes() const {
+    size_t total = 0;
+    for (const Shard &shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      total += shard.bytes;
+    }
+    return total;
+  }
+
+  /// Snapshot the lexicographic order of all symbols interned so far.
+  [[nodiscard]] symbol_order order() const {
+    std::vector<uint32_t> ids;
+    {
+      // With every shard held, no id is handed out without its slot filled.
+      std::array<std::unique_lock<std::mutex>, kShards> locks;
+      for (size_t i = 0; i < kShards; ++i)
+        locks[i] = std::unique_lock<std::mutex>(shards_[i].mutex);
+      ids.resize(size());
+    }
+    for (uint32_t i = 0; i < ids.size(); ++i)
+      ids[i] = i;
+    std::sort(ids.begin(), ids.end(),
+              [this](uint32_t a, uint32_t b) { return view({a}) < view({b}); });
+    std::vector<uint32_t> ranks(ids.size());
+    for (uint32_t r = 0; r < ids.size(); ++r)
+      ranks[ids[r]] = r;
+    return {this, std::move(ranks)};
+  }
+
+private:
+  // Block b holds ids [kFirstBlock * (2^b - 1), kFirstBlock * (2^(b+1) - 1)).
+  static constexpr size_t kFirstBlockBits = 10;
+  static constexpr size_t kFirstBlock = size_t{1} << kFirstBlockBits;
+  static constexpr size_t kBlocks = 33 - kFirstBlockBits; // enough for every uint32_t id
+  static constexpr size_t kChunkSize = 64 * 1024;
+
+  struct Shard {
+    mutable std::mutex mutex;
+    std::unordered_map<std::string_view, uint32_t> index;
+    std::vector<std::unique_ptr<char[]>> chunks;
+    char *cursor = nullptr;
+    size_t room = 0;
+    size_t bytes = 0;
+
+    std::string_view store(std::string_view s) {
+      bytes += s.size();
+      if (s.size() > kChunkSize / 4) { // big strings get their own allocation
+        chunks.push_back(std::make_unique_for_overwrite<char[]>(s.size()));
+        std::memcpy(chunks.back().get(), s.data(), s.size());
+        return {chunks.back().get(), s.size()};
+      }
+      if (s.size() > room) {
+        chunks.push_back(std::make_unique_for_overwrite<char[]>(kChunkSize));
+        cursor = chunks.back().get();
+        room = kChunkSize;
+      }
+      std::memcpy(cursor, s.data(), s.size());
+      std::string_view stored{cursor, s.size()};
+      cursor += s.size();
+      room -= s.size();
+      return stored;
+    }
+  };
+
+  static std::pair<size_t, size_t> locate(uint32_t id) noexcept {
+    const size_t biased = size_t{id} + kFirstBlock;
+    const size_t top = std::bit_width(biased) - 1;
+    return {top - kFirstBlockBits, biased - (size_t{1} << top)};
+  }
+
+  std::string_view &slot(uint32_t id) {
+    auto [block, offset] = locate(id);
+    std::string_view *p = blocks_[block].load(std::memory_order_acquire);
+    if (!p) {
+      auto *fresh = new std::string_view[kFirstBlock << block];
+      if (blocks_[block].compare_exchange_strong(p, fresh, std::memory_order_acq_rel))
+        p = fresh;
+      else
+        delete[] fresh; // another shard got there first; p is theirs
+    }
+    return p[offset];
+  }
+
+  std::array<Shard, kShards> shards_;
+  std::atomic<uint32_t> next_id_{0};
+  std::array<std::atomic<std::string_view *>, kBlocks> blocks_{};
+};
+
+inline bool symbol_order::less_by_text(symbol a, symbol b) const noexcept {
+  return pool_->view(a) < pool_->view(b);
+}
+
+} // end of namespace strings
+
+template <> struct std::hash<strings::symbol> {
+  size_t operator()(strings::symbol s) const noexcept { return std::hash<uint32_t>{}(s.id); }
+};
@@ -0,0 +1,89 @@
+#include "intern_pool.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(intern_pool, equal_strings_share_a_symbol) {
+  strings::intern_pool pool;
+  std::string a = "Smith", b = "Smith";
+  const auto s1 = pool.intern(a);
+  const auto s2 = pool.intern(b);
+  const auto s3 = pool.intern("Jones");
+  EXPECT_EQ(s1, s2);
+  EXPECT_NE(s1, s3);
+  EXPECT_EQ(pool.size(), 2);
+  EXPECT_EQ(pool.bytes(), 10);
+
+  // The pool holds its own copy.
+  a.assign("changed");
+  EXPECT_EQ(pool.view(s1), "Smith");
+  EXPECT_EQ(pool.view(s1).data(), pool.view(s2).data());
+  EXPECT_EQ(pool.find("Jones"), s3);
+  EXPECT_EQ(pool.find("Brown"), std::nullopt);
+
+  // Past the first id block, and a string bigger than an arena chunk.
+  std::vector<strings::symbol> syms;
+  for (int i = 0; i < 5000; ++i)
+    syms.push_back(pool.intern("name-" + std::to_string(i)));
+  const std::string big(100000, 'x');
+  const auto s_big = pool.intern(big);
+  EXPECT_EQ(pool.view(syms[4321]), "name-4321");
+  EXPECT_EQ(pool.view(s_big), big);
+  EXPECT_EQ(pool.view(s1), "Smith");
+}
+
+TEST(intern_pool, order_snapshot) {
+  strings::intern_pool pool;
+  const std::vector<std::string> words = {"pear", "apple", "fig", "banana", "cherry"};
+  std::vector<strings::symbol> syms;
+  for (const auto &w : words)
+    syms.push_back(pool.intern(w));
+
+  const auto order = pool.order();
+  EXPECT_EQ(order.rank(syms[1]), 0); // apple
+  EXPECT_EQ(order.rank(syms[0]), 4); // pear
+
+  std::sort(syms.begin(), syms.end(), order);
+  std::vector<std::string_view> sorted;
+  for (auto s : syms)
+    sorted.push_back(pool.view(s));
+  EXPECT_EQ(sorted, (std::vector<std::string_view>{"apple", "banana", "cherry", "fig", "pear"}));
+
+  // Newer symbols are still ordered, by their text.
+  const auto date = pool.intern("date");
+  EXPECT_TRUE(order(syms[2], date));  // cherry < date
+  EXPECT_FALSE(order(syms[3], date)); // fig > date
+}
+
+TEST(intern_pool, concurrent_intern) {
+  strings::intern_pool pool;
+  constexpr int threads = 4;
+  constexpr int names = 20000;
+
+  // Every thread interns the same names in a different order; they must
+  // agree on every symbol.
+  std::vector<std::vector<strings::symbol>> seen(threads, std::vector<strings::symbol>(names));
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t)
+    workers.emplace_back([&, t] {
+      for (int k = 0; k < names; ++k) {
+        const int i = (k * 7919 + t * 1237) % names;
+        seen[t][i] = pool.intern("user" + std::to_string(i));
+        EXPECT_EQ(pool.view(seen[t][i]), "user" + std::to_string(i));
+      }
+    });
+  for (auto &w : workers)
+    w.join();
+
+  EXPECT_EQ(pool.size(), names);
+  for (int t = 1; t < threads; ++t)
+    EXPECT_EQ(seen[t], seen[0]);
+  std::set<uint32_t> ids;
+  for (auto s : seen[0])
+    ids.insert(s.id);
+  EXPECT_EQ(ids.size(), names);
+  EXPECT_EQ(*ids.rbegin(), names - 1); // ids are dense
+}
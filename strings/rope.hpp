@@ -0,0 +1,324 @@
+#pragma once
+
+// DESCRIPTION:
+//  A rope: a string kept as a tree of slices of shared, immutable chunks.
+//
+//  * append(s) copies s into a private tail chunk. A full tail is sealed into
+//    the tree as a leaf and a bigger one started (kMinTail up to kMaxTail),
+//    so bytes already written are never moved again, unlike std::string's
+//    reallocate-and-copy growth.
+//  * append(rope) and operator+ join the two trees in O(log pieces); no
+//    bytes are copied except the other rope's tail (at most kMaxTail).
+//  * substr() and copies share chunks; only nodes along the cut are new.
+//  * for_each_chunk() walks the pieces in order as string_views, and
+//    write_to(fd) hands them to writev, so output needs no flattening.
+//
+//  The tree is kept height-balanced (AVL-style joins), so at(), substr()
+//  and concatenation stay O(log pieces) however the rope was built.
+//
+//  A rope is a value: copies are independent, but not thread-safe to
+//  mutate concurrently (like std::string). Chunks are shared between copies
+//  through atomic reference counts, so copies may live on other threads.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <climits>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace strings {
+
+class rope {
+public:
+  static constexpr size_t kMinTail = 1024;
+  static constexpr size_t kMaxTail = 64 * 1024;
+
+  rope() = default;
+  rope(std::string_view s) { append(s); }
+
+  rope(const rope &other) : root_(other.root_) { append_tail_of(other); }
+  rope(rope &&other) noexcept
+      : root_(std::move(other.root_)), tail_(std::move(other.tail_)),
+        tail_begin_(std::exchange(other.tail_begin_, 0)),
+        tail_end_(std::exchange(other.tail_end_, 0)),
+        tail_capacity_(std::exchange(other.tail_capacity_, 0)) {}
+  rope &operator=(const rope &other) {
+    if (this != &other)
+      *this = rope(other);
+    return *this;
+  }
+  rope &operator=(rope &&other) noexcept {
+    root_ = std::move(other.root_);
+    tail_ = std::move(other.tail_);
+    tail_begin_ = std::exchange(other.tail_begin_, 0);
+    tail_end_ = std::exchange(other.tail_end_, 0);
+    tail_capacity_ = std::exchange(other.tail_capacity_, 0);
+    return *this;
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return tree_size() + tail_end_ - tail_begin_; }
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+  rope &append(std::string_view s) {
+    while (!s.empty()) {
+      if (tail_end_ == tail_capacity_)
+        new_tail(s.size());
+      const size_t n = std::min(s.size(), tail_capacity_ - tail_end_);
+      std::memcpy(tail_.get() + tail_end_, s.data(), n);
+      tail_end_ += n;
+      s.remove_prefix(n);
+    }
+    return *this;
+  }
+
+  rope &append(char c) { return append(std::string_view(&c, 1)); }
+
+  /// Link `other` in after this rope's text; its chunks are shared.
+  rope &append(const rope &other) {
+    if (&other == this) {
+      rope copy(other);
+      return append(copy);
+    }
+    seal_tail();
+    root_ = concat(root_, other.root_);
+    append_tail_of(other);
+    return *this;
+  }
+
+  rope &operator+=(std::string_view s) { return append(s); }
+  rope &operator+=(const rope &other) { return append(other); }
+  rope &operator+=(char c) { return append(c); }
+
+  friend rope operator+(rope a, const rope &b) { return std::move(a.append(b)); }
+
+  /// Chars [pos, pos + len) as a rope sharing this one's chunks.
+  [[nodiscard]] rope substr(size_t pos, size_t len = std::string_view::npos) const {
+    if (pos > size())
+      throw std::out_of_range("rope::substr");
+    len = std::min(len, size() - pos);
+    rope out;
+    const size_t tree = tree_size();
+    if (pos < tree)
+      out.root_ = slice(root_, pos, std::min(len, tree - pos));
+    if (pos + len > tree) {
+      const size_t from = pos > tree ? pos - tree : 0;
+      out.append(tail_text().substr(from, pos + len - tree - from));
+    }
+    return out;
+  }
+
+  [[nodiscard]] char at(size_t pos) const {
+    if (pos >= size())
+      throw std::out_of_range("rope::at");
+    if (pos >= tree_size())
+      return tail_text()[pos - tree_size()];
+    const Node *n = root_.get();
+    while (!n->is_leaf()) {
+      const size_t left = n->left->size;
+      if (pos < left) {
+        n = n->left.get();
+      } else {
+        pos -= left;
+        n = n->right.get();
+      }
+    }
+    return n->chunk[n->offset + pos];
+  }
+
+  /// Call f(std::string_view) for each piece of text, in order.
+  template <typename F> void for_each_chunk(F &&f) const {
+    if (root_)
+      visit(root_.get(), f);
+    if (tail_end_ != tail_begin_)
+      f(tail_text());
+  }
+
+  /// Number of pieces for_each_chunk() produces.
+  [[nodiscard]] size_t chunk_count() const {
+    size_t n = 0;
+    for_each_chunk([&n](std::string_view) { ++n; });
+    return n;
+  }
+
+  [[nodiscard]] std::string str() const {
+    std::string out;
+    out.reserve(size());
+    for_each_chunk([&out](std::string_view piece) { out.append(piece); });
+    return out;
+  }
+
+  friend std::ostream &operator<<(std::ostream &os, const rope &r) {
+    r.for_each_chunk([&os](std::string_view piece) { os.write(piece.data(), piece.size()); });
+    return os;
+  }
+
+  friend bool operator==(const rope &a, std::string_view b) {
+    if (a.size() != b.size())
+      return false;
+    bool equal = true;
+    a.for_each_chunk([&](std::string_view piece) {
+      equal = equal && b.substr(0, piece.size()) == piece;
+      b.remove_prefix(piece.size());
+    });
+    return equal;
+  }
+
+#if defined(__unix__) || defined(__APPLE__)
+  /// Write everything to fd with writev, IOV_MAX pieces per call.
+  /// Returns false (errno set) on a write error.
+  bool write_to(int fd) const {
+    std::vector<iovec> iov;
+    iov.reserve(std::min<size_t>(chunk_count(), IOV_MAX));
+    bool ok = true;
+    auto flush = [&] {
+      size_t first = 0;
+      while (ok && first < iov.size()) {
+        ssize_t n = ::writev(fd, iov.data() + first, static_cast<int>(iov.size() - first));
+        if (n < 0) {
+          ok = errno == EINTR;
+          continue;
+        }
+        // Skip what was written; a short write may stop mid-piece.
+        for (auto left = static_cast<size_t>(n); left && first < iov.size();) {
+          const size_t step = std::min(left, iov[first].iov_len);
+          iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + step;
+          iov[first].iov_len -= step;
+          left -= step;
+          if (iov[first].iov_len == 0)
+            ++first;
+        }
+      }
+      iov.clear();
+    };
+    for_each_chunk([&](std::string_view piece) {
+      iov.push_back({const_cast<char *>(piece.data()), piece.size()});
+      if (iov.size() == IOV_MAX)
+        flush();
+    });
+    flush();
+    return ok;
+  }
+#endif
+
+private:
+  // A leaf is a slice of a chunk; an inner node joins two subtrees.
+  struct Node {
+    size_t size;
+    int depth;
+    std::shared_ptr<const char[]> chunk; // leaves only
+    size_t offset = 0;
+    std::shared_ptr<const Node> left, right; // inner nodes only
+
+    [[nodiscard]] bool is_leaf() const noexcept { return !left; }
+  };
+  using NodePtr = std::shared_ptr<const Node>;
+
+  [[nodiscard]] size_t tree_size() const noexcept { return root_ ? root_->size : 0; }
+  [[nodiscard]] std::string_view tail_text() const noexcept {
+    return {tail_.get() + tail_begin_, tail_end_ - tail_begin_};
+  }
+
+  static NodePtr leaf(std::shared_ptr<const char[]> chunk, size_t offset, size_t size) {
+    return std::make_shared<const Node>(Node{size, 0, std::move(chunk), offset, {}, {}});
+  }
+
+  static NodePtr node(NodePtr a, NodePtr b) {
+    const int depth = std::max(a->depth, b->depth) + 1;
+    const size_t size = a->size + b->size;
+    return std::make_shared<const Node>(Node{size, depth, {}, 0, std::move(a), std::move(b)});
+  }
+
+  /// Join two balanced trees into one (AVL join): walk down the taller
+  /// one's inner edge to a subtree of about the other's height, link there
+  /// and rotate on the way back up. O(height difference).
+  static NodePtr concat(NodePtr a, NodePtr b) {
+    if (!a)
+      return b;
+    if (!b)
+      return a;
+    if (a->depth > b->depth + 1) {
+      NodePtr r = concat(a->right, std::move(b));
+      if (r->depth <= a->left->depth + 1)
+        return node(a->left, std::move(r));
+      if (r->left->depth <= r->right->depth)
+        return node(node(a->left, r->left), r->right);
+      return node(node(a->left, r->left->left), node(r->left->right, r->right));
+    }
+    if (b->depth > a->depth + 1) {
+      NodePtr l = concat(std::move(a), b->left);
+      if (l->depth <= b->right->depth + 1)
+        return node(std::move(l), b->right);
+      if (l->right->depth <= l->left->depth)
+        return node(l->left, node(l->right, b->right));
+      return node(node(l->left, l->right->left), node(l->right->right, b->right));
+    }
+    return node(std::move(a), std::move(b));
+  }
+
+  static NodePtr slice(const NodePtr &n, size_t pos, size_t len) {
+    if (len == 0)
+      return nullptr;
+    if (pos == 0 && len == n->size)
+      return n;
+    if (n->is_leaf())
+      return leaf(n->chunk, n->offset + pos, len);
+    const size_t left = n->left->size;
+    if (pos + len <= left)
+      return slice(n->left, pos, len);
+    if (pos >= left)
+      return slice(n->right, pos - left, len);
+    return concat(slice(n->left, pos, left - pos), slice(n->right, 0, pos + len - left));
+  }
+
+  template <typename F> static void visit(const Node *n, F &f) {
+    while (!n->is_leaf()) {
+      visit(n->left.get(), f);
+      n = n->right.get();
+    }
+    f(std::string_view(n->chunk.get() + n->offset, n->size));
+  }
+
+  /// Move the tail's text into the tree. The chunk stays our tail: the new
+  /// leaf covers only [tail_begin_, tail_end_), so later appends past it
+  /// touch bytes no leaf can see.
+  void seal_tail() {
+    if (tail_end_ == tail_begin_)
+      return;
+    root_ = concat(std::move(root_), leaf(tail_, tail_begin_, tail_end_ - tail_begin_));
+    tail_begin_ = tail_end_;
+  }
+
+  void new_tail(size_t wanted) {
+    const size_t grown = std::clamp(std::max(wanted, tree_size() / 8), kMinTail, kMaxTail);
+    seal_tail();
+    tail_ = std::make_shared_for_overwrite<char[]>(grown);
+    tail_begin_ = tail_end_ = 0;
+    tail_capacity_ = grown;
+  }
+
+  void append_tail_of(const rope &other) {
+    if (other.tail_end_ != other.tail_begin_)
+      append(other.tail_text());
+  }
+
+  NodePtr root_;
+  // Only this rope writes to tail_, and only at or past tail_end_.
+  std::shared_ptr<char[]> tail_;
+  size_t tail_begin_ = 0;
+  size_t tail_end_ = 0;
+  size_t tail_capacity_ = 0;
+};
+
+} // end of namespace strings
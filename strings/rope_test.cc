@@ -0,0 +1,167 @@
+#include "my_timer.h"
+#include "rope.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+TEST(rope, append_concat_substr) {
+  strings::rope r;
+  std::string expected;
+  for (int i = 0; i < 20000; ++i) {
+    const std::string line = "line " + std::to_string(i) + '\n';
+    r += line;
+    expected += line;
+  }
+  EXPECT_EQ(r.size(), expected.size());
+  EXPECT_GT(r.chunk_count(), 1); // spread over several chunks
+  EXPECT_EQ(r.str(), expected);
+  EXPECT_EQ(r.at(123456), expected[123456]);
+
+  // Substrings across chunk boundaries, and into the unsealed tail.
+  for (size_t pos : {size_t{0}, size_t{1000}, size_t{65530}, expected.size() - 10}) {
+    const auto sub = r.substr(pos, 70000);
+    EXPECT_EQ(sub, std::string_view(expected).substr(pos, 70000));
+  }
+
+  // Concatenation shares chunks; the operands are unchanged.
+  strings::rope head("header\n");
+  strings::rope joined = head + r + strings::rope("footer\n");
+  EXPECT_EQ(joined, "header\n" + expected + "footer\n");
+  EXPECT_EQ(head, "header\n");
+  joined.append(joined);
+  EXPECT_EQ(joined.size(), 2 * (expected.size() + 14));
+
+  // Appending to a copy does not show up in the original, even though the
+  // copy shares the original's chunks.
+  strings::rope copy = r;
+  copy += "more";
+  r += "else";
+  EXPECT_EQ(copy.substr(copy.size() - 10), "19999\nmore");
+  EXPECT_EQ(r.substr(r.size() - 4), "else");
+}
+
+TEST(rope, balanced_after_many_joins) {
+  // 10k tiny ropes joined one by one stay shallow enough to index quickly.
+  strings::rope r;
+  std::string expected;
+  for (int i = 0; i < 10000; ++i) {
+    strings::rope piece(std::to_string(i % 10));
+    r += piece;
+    expected += std::to_string(i % 10);
+  }
+  EXPECT_EQ(r.chunk_count(), 10000); // one leaf per piece
+  EXPECT_EQ(r.str(), expected);
+  for (size_t i = 0; i < expected.size(); i += 997)
+    EXPECT_EQ(r.at(i), expected[i]);
+  EXPECT_EQ(r.substr(5000, 20), expected.substr(5000, 20));
+}
+
+TEST(rope, write_to_fd) {
+  strings::rope r;
+  for (int i = 0; i < 5000; ++i)
+    r += "0123456789abcdef0123456789abcdef\n";
+  r += strings::rope("tail");
+
+  char path[] = "/tmp/rope_test_XXXXXX";
+  const int fd = ::mkstemp(path);
+  ASSERT_GE(fd, 0);
+  EXPECT_TRUE(r.write_to(fd));
+  ::close(fd);
+
+  std::FILE *f = std::fopen(path, "rb");
+  ASSERT_NE(f, nullptr);
+  std::string back(r.size() + 1, '\0');
+  back.resize(std::fread(back.data(), 1, back.size(), f));
+  std::fclose(f);
+  ::unlink(path);
+  EXPECT_EQ(r, back);
+}
+
+namespace {
+
+/// One line of a report: "row <i>: id=<i * 7919> value=<i / 3.0>\n".
+template <typename Out> void report_line(Out &out, int i) {
+  char buf[64];
+  out += "row ";
+  out += std::string_view(buf, std::to_chars(buf, buf + 64, i).ptr - buf);
+  out += ": id=";
+  out += std::string_view(buf, std::to_chars(buf, buf + 64, i * 7919).ptr - buf);
+  out += " value=";
+  out += std::string_view(buf, std::to_chars(buf, buf + 64, i / 3.0).ptr - buf);
+  out += '\n';
+}
+
+} // namespace
+
+TEST(rope, report_benchmark) {
+  // ~8MB report: 64 sections of 4096 lines, built then joined in order.
+  constexpr int sections = 64, lines = 4096;
+
+  Timer t1("std::string");
+  std::string s;
+  {
+    std::vector<std::string> parts(sections);
+    for (int p = 0; p < sections; ++p)
+      for (int i = 0; i < lines; ++i)
+        report_line(parts[p], p * lines + i);
+    for (const auto &part : parts)
+      s += part;
+  }
+  auto string_ns = t1.eclipse();
+
+  Timer t2("ostringstream");
+  std::ostringstream os;
+  {
+    std::vector<std::ostringstream> parts(sections);
+    for (int p = 0; p < sections; ++p)
+      for (int i = 0; i < lines; ++i) {
+        const int n = p * lines + i;
+        parts[p] << "row " << n << ": id=" << n * 7919 << " value=" << n / 3.0 << '\n';
+      }
+    for (const auto &part : parts)
+      os << part.rdbuf()->view();
+  }
+  auto stream_ns = t2.eclipse();
+
+  Timer t3("rope");
+  strings::rope r;
+  {
+    std::vector<strings::rope> parts(sections);
+    for (int p = 0; p < sections; ++p)
+      for (int i = 0; i < lines; ++i)
+        report_line(parts[p], p * lines + i);
+    for (const auto &part : parts)
+      r += part;
+  }
+  auto rope_ns = t3.eclipse();
+  EXPECT_EQ(r, s);
+  // ostream prints doubles to 6 digits, to_chars to the shortest round trip,
+  // so only the line count matches.
+  EXPECT_EQ(std::count(os.view().begin(), os.view().end(), '\n'), sections * lines);
+
+  // Output: one write of the flat string against one writev of the pieces.
+  const int null_fd = ::open("/dev/null", O_WRONLY);
+  ASSERT_GE(null_fd, 0);
+  Timer t4("write string");
+  EXPECT_EQ(::write(null_fd, s.data(), s.size()), static_cast<ssize_t>(s.size()));
+  auto write_ns = t4.eclipse();
+  Timer t5("writev rope");
+  EXPECT_TRUE(r.write_to(null_fd));
+  auto writev_ns = t5.eclipse();
+  ::close(null_fd);
+
+#ifndef NDEBUG
+  std::cout << s.size() / 1024 << " KB report, ms: std::string " << string_ns / 1e6
+            << ", ostringstream " << stream_ns / 1e6 << ", rope " << rope_ns / 1e6 << " ("
+            << r.chunk_count() << " chunks); output: write " << write_ns / 1e3
+            << " us, writev " << writev_ns / 1e3 << " us\n";
+#else
+  (void)string_ns, (void)stream_ns, (void)rope_ns, (void)write_ns, (void)writev_ns;
+#endif
+}
@@ -0,0 +1,415 @@
+#pragma once
+
+// DESCRIPTION:
+//  String search kernels that look at 16 (SSE) or 32 (AVX2) bytes per step:
+//
+//    find_byte       first occurrence of a char            (memchr)
+//    find_last_byte  last occurrence of a char             (memrchr)
+//    count_byte      number of occurrences of a char       (std::count)
+//    find_first_of   first char that is in a char_set      (strpbrk)
+//    find_substring  first occurrence of a string          (string_view::find)
+//
+//  Each kernel compares a whole block at once, turns the result into a bit
+//  mask (one bit per byte) and takes the lowest (or highest) set bit as the
+//  match. Loads are unaligned and never go past the end of the input; the
+//  last partial block is done byte by byte. All of them return n when there
+//  is no match.
+//
+//  * find_first_of looks up every byte of a block in the set's 256-bit
+//    table with two pshufb nibble lookups ("truffle"), so its speed does not
+//    depend on the set size. Sets of up to 3 chars use plain compares.
+//  * find_substring compares the needle's first and last chars at 32
+//    positions at once and runs memcmp only where both match (Mula's
+//    "generic SIMD" search). Worst case, like string_view::find, is O(n*m).
+//
+//  The instruction set is picked at run time, once (best_isa()); the build
+//  does not assume anything past x86-64's SSE2. Every kernel also takes an
+//  explicit isa, which tests and benchmarks use to run each tier. Other
+//  targets get the scalar loops.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define STRINGS_SIMD_X86 1
+#endif
+
+namespace strings::simd {
+
+/// Kernel tiers, weakest first. sse42 is the 128-bit tier that also has
+/// pshufb (SSSE3, which every SSE4.2 CPU has).
+enum class isa { scalar, sse2, sse42, avx2 };
+
+inline isa best_isa() noexcept {
+#ifdef STRINGS_SIMD_X86
+  static const isa best = __builtin_cpu_supports("avx2")     ? isa::avx2
+                          : __builtin_cpu_supports("sse4.2") ? isa::sse42
+                                                             : isa::sse2;
+  return best;
+#else
+  return isa::scalar;
+#endif
+}
+
+inline const char *isa_name(isa which) noexcept {
+  constexpr const char *names[] = {"scalar", "sse2", "sse4.2", "avx2"};
+  return names[static_cast<int>(which)];
+}
+
+namespace detail {
+struct kernels;
+} // namespace detail
+
+/// A set of byte values, with the lookup tables the SIMD kernels use.
+class char_set {
+public:
+  char_set() = default;
+  explicit char_set(std::string_view chars) noexcept {
+    for (char c : chars) {
+      const auto b = static_cast<uint8_t>(c);
+      if (contains(c))
+        continue;
+      bits_[b >> 6] |= uint64_t{1} << (b & 63);
+      if (b < 0x80)
+        lo_high_clear_[b & 15] |= static_cast<uint8_t>(1u << (b >> 4));
+      else
+        lo_high_set_[b & 15] |= static_cast<uint8_t>(1u << ((b >> 4) - 8));
+      if (size_ < small_.size())
+        small_[size_] = c;
+      ++size_;
+    }
+  }
+
+  [[nodiscard]] bool contains(char c) const noexcept {
+    const auto b = static_cast<uint8_t>(c);
+    return (bits_[b >> 6] >> (b & 63)) & 1;
+  }
+  [[nodiscard]] size_t size() const noexcept { return size_; }
+
+private:
+  friend struct detail::kernels;
+
+  std::array<uint64_t, 4> bits_{};
+  // For byte b = hi:lo (nibbles), bit hi of lo_high_clear_[lo] (b < 0x80) or
+  // bit hi - 8 of lo_high_set_[lo] (b >= 0x80) is set when b is in the set.
+  std::array<uint8_t, 16> lo_high_clear_{};
+  std::array<uint8_t, 16> lo_high_set_{};
+  std::array<char, 3> small_{}; // the members, when there are at most 3
+  size_t size_ = 0;
+};
+
+struct detail::kernels {
+  // ---- scalar ----
+
+  static size_t find_byte_scalar(const char *p, size_t i, size_t n, char c) noexcept {
+    for (; i < n; ++i)
+      if (p[i] == c)
+        return i;
+    return n;
+  }
+
+  /// Last c in [p, p + end), or `none`.
+  static size_t find_last_scalar(const char *p, size_t end, char c, size_t none) noexcept {
+    while (end > 0)
+      if (p[--end] == c)
+        return end;
+    return none;
+  }
+
+  static size_t count_scalar(const char *p, size_t i, size_t n, char c) noexcept {
+    size_t total = 0;
+    for (; i < n; ++i)
+      total += p[i] == c;
+    return total;
+  }
+
+  static size_t find_first_of_scalar(const char *p, size_t i, size_t n,
+                                     const char_set &set) noexcept {
+    for (; i < n; ++i)
+      if (set.contains(p[i]))
+        return i;
+    return n;
+  }
+
+  static size_t find_substring_scalar(const char *p, size_t i, size_t n,
+                                      std::string_view needle) noexcept {
+    const size_t at = std::string_view(p + i, n - i).find(needle);
+    return at == std::string_view::npos ? n : i + at;
+  }
+
+#ifdef STRINGS_SIMD_X86
+  // ---- SSE2 / SSE4.2, 16 bytes per step ----
+
+  static size_t find_byte_sse2(const char *p, size_t n, char c) noexcept {
+    const __m128i needle = _mm_set1_epi8(c);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+      if (unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle)))
+        return i + __builtin_ctz(mask);
+    }
+    return find_byte_scalar(p, i, n, c);
+  }
+
+  static size_t find_last_sse2(const char *p, size_t n, char c) noexcept {
+    const __m128i needle = _mm_set1_epi8(c);
+    size_t i = n;
+    for (; i >= 16; i -= 16) {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i - 16));
+      if (unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle)))
+        return i - 16 + (31 - __builtin_clz(mask));
+    }
+    return find_last_scalar(p, i, c, n);
+  }
+
+  static size_t count_sse2(const char *p, size_t n, char c) noexcept {
+    const __m128i needle = _mm_set1_epi8(c);
+    size_t i = 0, total = 0;
+    while (i + 16 <= n) {
+      // Each byte lane counts hits (cmpeq gives -1); flush before it wraps.
+      __m128i acc = _mm_setzero_si128();
+      for (int k = 0; k < 255 && i + 16 <= n; ++k, i += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(block, needle));
+      }
+      __m128i sums = _mm_sad_epu8(acc, _mm_setzero_si128());
+      total += static_cast<size_t>(_mm_cvtsi128_si64(sums)) +
+               static_cast<size_t>(_mm_extract_epi16(sums, 4));
+    }
+    return total + count_scalar(p, i, n, c);
+  }
+
+  static size_t find_small_set_sse2(const char *p, size_t n, const char_set &set) noexcept {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+      __m128i hits = _mm_setzero_si128();
+      for (size_t k = 0; k < set.size_; ++k)
+        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, _mm_set1_epi8(set.small_[k])));
+      if (unsigned mask = _mm_movemask_epi8(hits))
+        return i + __builtin_ctz(mask);
+    }
+    return find_first_of_scalar(p, i, n, set);
+  }
+
+  __attribute__((target("sse4.2"))) static size_t
+  find_first_of_sse42(const char *p, size_t n, const char_set &set) noexcept {
+    const __m128i high_clear =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(set.lo_high_clear_.data()));
+    const __m128i high_set =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(set.lo_high_set_.data()));
+    const __m128i bit_of =
+        _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const __m128i top = _mm_set1_epi8(-128), seven = _mm_set1_epi8(7);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+      // pshufb returns 0 for index bytes with the top bit set, so each
+      // lookup only answers for its half of the byte range.
+      __m128i row = _mm_or_si128(_mm_shuffle_epi8(high_clear, v),
+                                 _mm_shuffle_epi8(high_set, _mm_xor_si128(v, top)));
+      __m128i bit = _mm_shuffle_epi8(bit_of, _mm_and_si128(_mm_srli_epi16(v, 4), seven));
+      __m128i miss = _mm_cmpeq_epi8(_mm_and_si128(row, bit), _mm_setzero_si128());
+      if (unsigned mask = ~_mm_movemask_epi8(miss) & 0xffff)
+        return i + __builtin_ctz(mask);
+    }
+    return find_first_of_scalar(p, i, n, set);
+  }
+
+  static size_t find_substring_sse2(const char *p, size_t n, std::string_view needle) noexcept {
+    const size_t m = needle.size();
+    const __m128i first = _mm_set1_epi8(needle.front()), last = _mm_set1_epi8(needle.back());
+    size_t i = 0;
+    for (; i + m - 1 + 16 <= n; i += 16) {
+      __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+      __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i + m - 1));
+      unsigned mask = _mm_movemask_epi8(
+          _mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last)));
+      for (; mask; mask &= mask - 1) {
+        const size_t at = i + __builtin_ctz(mask);
+        if (std::memcmp(p + at + 1, needle.data() + 1, m - 2) == 0)
+          return at;
+      }
+    }
+    return find_substring_scalar(p, i, n, needle);
+  }
+
+  // ---- AVX2, 32 bytes per step ----
+
+  __attribute__((target("avx2"))) static size_t find_byte_avx2(const char *p, size_t n,
+                                                                char c) noexcept {
+    const __m256i needle = _mm256_set1_epi8(c);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+      __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+      if (unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle)))
+        return i + __builtin_ctz(mask);
+    }
+    return find_byte_sse2(p + i, n - i, c) + i;
+  }
+
+  __attribute__((target("avx2"))) static size_t find_last_avx2(const char *p, size_t n,
+                                                                char c) noexcept {
+    const __m256i needle = _mm256_set1_epi8(c);
+    size_t i = n;
+    for (; i >= 32; i -= 32) {
+      __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i - 32));
+      if (unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle)))
+        return i - 32 + (31 - __builtin_clz(mask));
+    }
+    const size_t head = find_last_sse2(p, i, c);
+    return head == i ? n : head;
+  }
+
+  __attribute__((target("avx2"))) static size_t count_avx2(const char *p, size_t n,
+                                                            char c) noexcept {
+    const __m256i needle = _mm256_set1_epi8(c);
+    size_t i = 0, total = 0;
+    while (i + 32 <= n) {
+      __m256i acc = _mm256_setzero_si256();
+      for (int k = 0; k < 255 && i + 32 <= n; ++k, i += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+        acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(block, needle));
+      }
+      __m256i sums = _mm256_sad_epu8(acc, _mm256_setzero_si256());
+      total += static_cast<size_t>(_mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1) +
+                                   _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3));
+    }
+    return total + count_scalar(p, i, n, c);
+  }
+
+  __attribute__((target("avx2"))) static size_t find_small_set_avx2(const char *p, size_t n,
+                                                                     const char_set &set) noexcept {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+      __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+      __m256i hits = _mm256_setzero_si256();
+      for (size_t k = 0; k < set.size_; ++k)
+        hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(set.small_[k])));
+      if (unsigned mask = _mm256_movemask_epi8(hits))
+        return i + __builtin_ctz(mask);
+    }
+    return find_small_set_sse2(p + i, n - i, set) + i;
+  }
+
+  __attribute__((target("avx2"))) static size_t find_first_of_avx2(const char *p, size_t n,
+                                                                    const char_set &set) noexcept {
+    const __m256i high_clear = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(set.lo_high_clear_.data())));
+    const __m256i high_set = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(set.lo_high_set_.data())));
+    const __m256i bit_of =
+        _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8,
+                         16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const __m256i top = _mm256_set1_epi8(-128), seven = _mm256_set1_epi8(7);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+      __m256i row = _mm256_or_si256(_mm256_shuffle_epi8(high_clear, v),
+                                    _mm256_shuffle_epi8(high_set, _mm256_xor_si256(v, top)));
+      __m256i bit = _mm256_shuffle_epi8(bit_of, _mm256_and_si256(_mm256_srli_epi16(v, 4), seven));
+      __m256i miss = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), _mm256_setzero_si256());
+      if (unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(miss)))
+        return i + __builtin_ctz(mask);
+    }
+    return find_first_of_sse42(p + i, n - i, set) + i;
+  }
+
+  __attribute__((target("avx2"))) static size_t
+  find_substring_avx2(const char *p, size_t n, std::string_view needle) noexcept {
+    const size_t m = needle.size();
+    const __m256i first = _mm256_set1_epi8(needle.front()), last = _mm256_set1_epi8(needle.back());
+    size_t i = 0;
+    for (; i + m - 1 + 32 <= n; i += 32) {
+      __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+      __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i + m - 1));
+      unsigned mask = _mm256_movemask_epi8(
+          _mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, last)));
+      for (; mask; mask &= mask - 1) {
+        const size_t at = i + __builtin_ctz(mask);
+        if (std::memcmp(p + at + 1, needle.data() + 1, m - 2) == 0)
+          return at;
+      }
+    }
+    return find_substring_sse2(p + i, n - i, needle) + i;
+  }
+#endif
+};
+
+/// Index of the first `c` in [p, p + n), or n.
+inline size_t find_byte(const char *p, size_t n, char c, isa use = best_isa()) noexcept {
+#ifdef STRINGS_SIMD_X86
+  if (use == isa::avx2)
+    return detail::kernels::find_byte_avx2(p, n, c);
+  if (use != isa::scalar)
+    return detail::kernels::find_byte_sse2(p, n, c);
+#endif
+  return detail::kernels::find_byte_scalar(p, 0, n, c);
+}
+
+/// Index of the last `c` in [p, p + n), or n.
+inline size_t find_last_byte(const char *p, size_t n, char c, isa use = best_isa()) noexcept {
+#ifdef STRINGS_SIMD_X86
+  if (use == isa::avx2)
+    return detail::kernels::find_last_avx2(p, n, c);
+  if (use != isa::scalar)
+    return detail::kernels::find_last_sse2(p, n, c);
+#endif
+  return detail::kernels::find_last_scalar(p, n, c, n);
+}
+
+/// Number of `c` in [p, p + n).
+inline size_t count_byte(const char *p, size_t n, char c, isa use = best_isa()) noexcept {
+#ifdef STRINGS_SIMD_X86
+  if (use == isa::avx2)
+    return detail::kernels::count_avx2(p, n, c);
+  if (use != isa::scalar)
+    return detail::kernels::count_sse2(p, n, c);
+#endif
+  return detail::kernels::count_scalar(p, 0, n, c);
+}
+
+/// Index of the first byte of [p, p + n) that is in `set`, or n.
+inline size_t find_first_of(const char *p, size_t n, const char_set &set,
+                            isa use = best_isa()) noexcept {
+#ifdef STRINGS_SIMD_X86
+  if (set.size() <= 3) {
+    if (use == isa::avx2)
+      return detail::kernels::find_small_set_avx2(p, n, set);
+    if (use != isa::scalar)
+      return detail::kernels::find_small_set_sse2(p, n, set);
+  } else {
+    if (use == isa::avx2)
+      return detail::kernels::find_first_of_avx2(p, n, set);
+    if (use == isa::sse42)
+      return detail::kernels::find_first_of_sse42(p, n, set);
+  }
+#endif
+  return detail::kernels::find_first_of_scalar(p, 0, n, set);
+}
+
+/// Index of the first occurrence of `needle` in [p, p + n), or n. An empty
+/// needle is found at 0.
+inline size_t find_substring(const char *p, size_t n, std::string_view needle,
+                             isa use = best_isa()) noexcept {
+  const size_t m = needle.size();
+  if (m == 0)
+    return 0;
+  if (m > n)
+    return n;
+  if (m == 1)
+    return find_byte(p, n, needle[0], use);
+#ifdef STRINGS_SIMD_X86
+  if (use == isa::avx2)
+    return detail::kernels::find_substring_avx2(p, n, needle);
+  if (use != isa::scalar)
+    return detail::kernels::find_substring_sse2(p, n, needle);
+#endif
+  return detail::kernels::find_substring_scalar(p, 0, n, needle);
+}
+
+} // end of namespace strings::simd
@@ -0,0 +1,176 @@
+#include "my_timer.h"
+#include "simd_find.hpp"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <gtest/gtest.h>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace simd = strings::simd;
+
+namespace {
+
+std::vector<simd::isa> supported_isas() {
+  std::vector<simd::isa> out;
+  for (auto which : {simd::isa::scalar, simd::isa::sse2, simd::isa::sse42, simd::isa::avx2})
+    if (which <= simd::best_isa())
+      out.push_back(which);
+  return out;
+}
+
+size_t as_index(size_t pos, size_t n) { return pos == std::string_view::npos ? n : pos; }
+
+} // namespace
+
+TEST(simd_find, matches_std_on_random_text) {
+  std::mt19937 gen(43);
+  // A small alphabet makes matches, near misses and repeats common; bytes
+  // with the top bit set exercise the other half of the nibble tables.
+  const std::string alphabet = "abcab,;\t\xe9\xff";
+  std::uniform_int_distribution<size_t> pick(0, alphabet.size() - 1);
+  const std::string sets[] = {"x", ",;", "\t,;", "c;\xff\t", "\xe9,\x01\x7f\x80", "zyxwvu"};
+  const std::string needles[] = {"ab", "abc", "bca,", "\xe9\xff", "cab,;\tab", "zz"};
+
+  for (size_t n : {0, 1, 15, 16, 17, 31, 32, 33, 63, 100, 257, 1000}) {
+    for (int round = 0; round < 20; ++round) {
+      std::string text(n, ' ');
+      for (char &c : text)
+        c = alphabet[pick(gen)];
+      const std::string_view sv = text;
+      const char *p = text.data();
+
+      for (auto which : supported_isas()) {
+        SCOPED_TRACE(std::string(simd::isa_name(which)) + ", n = " + std::to_string(n));
+        for (char c : {'a', ',', '\xff', 'q'}) {
+          EXPECT_EQ(simd::find_byte(p, n, c, which), as_index(sv.find(c), n));
+          EXPECT_EQ(simd::find_last_byte(p, n, c, which), as_index(sv.rfind(c), n));
+          EXPECT_EQ(simd::count_byte(p, n, c, which),
+                    static_cast<size_t>(std::count(sv.begin(), sv.end(), c)));
+        }
+        for (const auto &set : sets)
+          EXPECT_EQ(simd::find_first_of(p, n, simd::char_set(set), which),
+                    as_index(sv.find_first_of(set), n));
+        for (const auto &needle : needles)
+          EXPECT_EQ(simd::find_substring(p, n, needle, which), as_index(sv.find(needle), n));
+      }
+    }
+  }
+}
+
+TEST(simd_find, edge_cases) {
+  // Matches in the last partial block and right at block boundaries.
+  std::string text(70, '.');
+  text[69] = 'x';
+  text[31] = text[32] = 'y';
+  for (auto which : supported_isas()) {
+    EXPECT_EQ(simd::find_byte(text.data(), text.size(), 'x', which), 69);
+    EXPECT_EQ(simd::find_last_byte(text.data(), text.size(), 'y', which), 32);
+    EXPECT_EQ(simd::find_substring(text.data(), text.size(), "y.", which), 32);
+    EXPECT_EQ(simd::find_substring(text.data(), text.size(), "..x", which), 67);
+    EXPECT_EQ(simd::find_first_of(text.data(), text.size(), simd::char_set("xyz!"), which), 31);
+  }
+  EXPECT_EQ(simd::find_substring("abc", 3, ""), 0);
+  EXPECT_EQ(simd::find_substring("abc", 3, "abcd"), 3);
+
+  // Counts above the 255-block flush of the byte-lane accumulators.
+  const std::string all_x(100000, 'x');
+  EXPECT_EQ(simd::count_byte(all_x.data(), all_x.size(), 'x'), all_x.size());
+
+  simd::char_set set("aab\xff");
+  EXPECT_EQ(set.size(), 3);
+  EXPECT_TRUE(set.contains('\xff'));
+  EXPECT_FALSE(set.contains('c'));
+}
+
+namespace {
+
+/// Bytes scanned per nanosecond, i.e. GB/s.
+double gbps(size_t bytes, size_t rounds, uint64_t ns) {
+  return static_cast<double>(bytes) * rounds / static_cast<double>(ns);
+}
+
+template <typename Kernel> double measure(const std::string &text, size_t rounds, Kernel kernel) {
+  size_t sink = 0;
+  Timer t("kernel");
+  for (size_t r = 0; r < rounds; ++r)
+    sink += kernel(text.data(), text.size());
+  auto ns = t.eclipse();
+  EXPECT_NE(sink, size_t{1}); // keep the result alive
+  return gbps(text.size(), rounds, ns);
+}
+
+} // namespace
+
+TEST(simd_find, throughput_benchmark) {
+  // Lowercase prose-like text; the searched-for bytes never occur, so every
+  // kernel scans the whole buffer (count scans it regardless).
+  constexpr size_t bytes = 16 << 20;
+  constexpr size_t rounds = 8;
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<int> letter('a', 'z');
+  std::string text(bytes, ' ');
+  for (size_t i = 0; i < bytes; ++i)
+    text[i] = i % 7 == 6 ? ' ' : static_cast<char>(letter(gen));
+
+  const simd::char_set digits("0123456789");
+  const simd::char_set punct(",;");
+  const std::string needle = "needle!";
+
+  struct Row {
+    const char *name;
+    std::function<size_t(const char *, size_t, simd::isa)> kernel;
+    std::function<size_t(const char *, size_t)> baseline;
+    const char *baseline_name;
+  };
+  const Row rows[] = {
+      {"find_byte",
+       [](const char *p, size_t n, simd::isa w) { return simd::find_byte(p, n, '#', w); },
+       [](const char *p, size_t n) {
+         // '#' is not in the text; like find_byte, answer n when not found.
+         const auto *hit = static_cast<const char *>(std::memchr(p, '#', n));
+         return hit ? static_cast<size_t>(hit - p) : n;
+       },
+       "memchr"},
+      {"find_last_byte",
+       [](const char *p, size_t n, simd::isa w) { return simd::find_last_byte(p, n, '#', w); },
+       [](const char *p, size_t n) { return std::string_view(p, n).rfind('#'); }, "rfind"},
+      {"count_byte",
+       [](const char *p, size_t n, simd::isa w) { return simd::count_byte(p, n, 'e', w); },
+       [](const char *p, size_t n) { return static_cast<size_t>(std::count(p, p + n, 'e')); },
+       "std::count"},
+      {"find_first_of(2)",
+       [&](const char *p, size_t n, simd::isa w) { return simd::find_first_of(p, n, punct, w); },
+       [](const char *p, size_t n) { return std::string_view(p, n).find_first_of(",;"); },
+       "find_first_of"},
+      {"find_first_of(10)",
+       [&](const char *p, size_t n, simd::isa w) { return simd::find_first_of(p, n, digits, w); },
+       [](const char *p, size_t n) { return std::string_view(p, n).find_first_of("0123456789"); },
+       "find_first_of"},
+      {"find_substring",
+       [&](const char *p, size_t n, simd::isa w) { return simd::find_substring(p, n, needle, w); },
+       [&](const char *p, size_t n) { return std::string_view(p, n).find(needle); }, "find"},
+  };
+
+#ifndef NDEBUG
+  std::cout << "GB/s over " << (bytes >> 20) << " MB:\n";
+#endif
+  for (const auto &row : rows) {
+    std::ostringstream line;
+    line << std::setprecision(3) << row.name << ": " << row.baseline_name << ' '
+         << measure(text, rounds, row.baseline);
+    for (auto which : supported_isas()) {
+      const double ours = measure(text, rounds, [&](const char *p, size_t n) {
+        return row.kernel(p, n, which);
+      });
+      line << ", " << simd::isa_name(which) << ' ' << ours;
+    }
+#ifndef NDEBUG
+    std::cout << "  " << line.str() << '\n';
+#endif
+  }
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+// DESCRIPTION:
+//  A lazy, allocation-free split of a std::string_view.
+//
+//      for (std::string_view field : strings::split(line, ','))
+//      for (std::string_view word : strings::split(text, strings::any_of{" \t\n"}))
+//      for (std::string_view item : strings::split(list, ", "))
+//
+//  Pieces are string_views into the original text, found one at a time as
+//  the range is walked, with the vectorized searches from simd_find.hpp.
+//  Semantics match std::views::split: empty text gives no pieces, adjacent
+//  delimiters give empty pieces, and a trailing delimiter gives a trailing
+//  empty piece. A multi-char delimiter must not be empty.
+
+#include "simd_find.hpp"
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <ranges>
+#include <string_view>
+
+namespace strings {
+
+/// Split wherever any one of `chars` occurs.
+struct any_of {
+  std::string_view chars;
+};
+
+namespace detail {
+
+struct CharDelimiter {
+  char c;
+  size_t find(const char *p, size_t n) const noexcept { return simd::find_byte(p, n, c); }
+  size_t length() const noexcept { return 1; }
+};
+
+struct SequenceDelimiter {
+  std::string_view seq;
+  size_t find(const char *p, size_t n) const noexcept { return simd::find_substring(p, n, seq); }
+  size_t length() const noexcept { return seq.size(); }
+};
+
+struct AnyOfDelimiter {
+  simd::char_set chars;
+  size_t find(const char *p, size_t n) const noexcept { return simd::find_first_of(p, n, chars); }
+  size_t length() const noexcept { return 1; }
+};
+
+} // namespace detail
+
+template <typename Delimiter>
+class split_view : public std::ranges::view_interface<split_view<Delimiter>> {
+public:
+  class iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::string_view;
+
+    iterator() = default;
+
+    std::string_view operator*() const noexcept { return {text_.data() + begin_, end_ - begin_}; }
+
+    iterator &operator++() noexcept {
+      if (end_ == text_.size()) {
+        // The piece just read ran to the end of the text: nothing follows.
+        begin_ = end_ = npos;
+      } else {
+        find_piece(end_ + delimiter_.length());
+      }
+      return *this;
+    }
+    iterator operator++(int) noexcept {
+      iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    friend bool operator==(const iterator &a, const iterator &b) noexcept {
+      return a.begin_ == b.begin_;
+    }
+    friend bool operator==(const iterator &it, std::default_sentinel_t) noexcept {
+      return it.begin_ == npos;
+    }
+
+  private:
+    friend class split_view;
+    static constexpr size_t npos = std::string_view::npos;
+
+    iterator(std::string_view text, Delimiter delimiter) noexcept
+        : text_(text), delimiter_(delimiter) {
+      if (text_.empty())
+        begin_ = end_ = npos;
+      else
+        find_piece(0);
+    }
+
+    void find_piece(size_t from) noexcept {
+      begin_ = from;
+      end_ = from + delimiter_.find(text_.data() + from, text_.size() - from);
+    }
+
+    std::string_view text_;
+    Delimiter delimiter_{};
+    size_t begin_ = npos; // npos once past the last piece
+    size_t end_ = npos;   // the delimiter's position, or text_.size()
+  };
+
+  split_view() = default;
+  split_view(std::string_view text, Delimiter delimiter) noexcept
+      : text_(text), delimiter_(delimiter) {}
+
+  iterator begin() const noexcept { return iterator(text_, delimiter_); }
+  std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+  std::string_view text_;
+  Delimiter delimiter_{};
+};
+
+inline split_view<detail::CharDelimiter> split(std::string_view text, char delimiter) noexcept {
+  return {text, {delimiter}};
+}
+
+inline split_view<detail::SequenceDelimiter> split(std::string_view text,
+                                                   std::string_view delimiter) noexcept {
+  assert(!delimiter.empty());
+  return {text, {delimiter}};
+}
+
+inline split_view<detail::AnyOfDelimiter> split(std::string_view text, any_of delimiters) noexcept {
+  assert(!delimiters.chars.empty());
+  return {text, {simd::char_set(delimiters.chars)}};
+}
+
+} // end of namespace strings
+
+template <typename Delimiter>
+inline constexpr bool std::ranges::enable_borrowed_range<strings::split_view<Delimiter>> = true;
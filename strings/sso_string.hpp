@@ -0,0 +1,258 @@
+#pragma once
+
+// DESCRIPTION:
+//  A string with a configurable small-string buffer.
+//
+//  libstdc++'s std::string keeps up to 15 chars inline; longer strings go to
+//  the heap. Many keys (identifiers, paths, UUIDs, 20-30 char tags) are just
+//  over that, and pay a malloc on every construct and copy.
+//  basic_sso_string<N> keeps up to N chars inline and only allocates above
+//  that; `heap_threshold` is N, spelled out for callers sizing their keys.
+//
+//  Layout is the libstdc++ one: data pointer, size, and a union of the heap
+//  capacity with the inline buffer, so data() never branches. The cost is
+//  sizeof == N + 1 + 2 words rounded up, and copies/moves of inline strings
+//  copy the buffer.
+//
+//  resize_and_overwrite(n, op) grows without zero-filling: op writes into
+//  the raw buffer and returns the final size, as in C++23.
+
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace strings {
+
+template <size_t N> class basic_sso_string {
+  static_assert(N >= sizeof(size_t), "the inline buffer also holds the heap capacity");
+
+public:
+  using value_type = char;
+  using size_type = size_t;
+  using iterator = char *;
+  using const_iterator = const char *;
+
+  static constexpr size_t heap_threshold = N; // longer strings allocate
+  static constexpr size_t npos = std::string_view::npos;
+
+  basic_sso_string() noexcept { inline_[0] = '\0'; }
+  basic_sso_string(const char *s) : basic_sso_string(std::string_view(s)) {}
+  basic_sso_string(const char *s, size_t n) : basic_sso_string(std::string_view(s, n)) {}
+  explicit basic_sso_string(std::string_view sv) { init(sv.data(), sv.size()); }
+  basic_sso_string(size_t n, char c) {
+    init(nullptr, n);
+    std::memset(data_, c, n);
+  }
+
+  basic_sso_string(const basic_sso_string &other) { init(other.data_, other.size_); }
+
+  basic_sso_string(basic_sso_string &&other) noexcept : size_(other.size_) {
+    if (other.is_inline()) {
+      std::memcpy(inline_, other.inline_, size_ + 1);
+    } else {
+      data_ = other.data_;
+      capacity_ = other.capacity_;
+      other.data_ = other.inline_;
+    }
+    other.size_ = 0;
+    other.inline_[0] = '\0';
+  }
+
+  basic_sso_string &operator=(const basic_sso_string &other) {
+    if (this != &other)
+      assign(other.data_, other.size_);
+    return *this;
+  }
+
+  basic_sso_string &operator=(basic_sso_string &&other) noexcept {
+    if (this == &other)
+      return *this;
+    if (other.is_inline()) {
+      assign(other.data_, other.size_); // fits in whatever we have
+    } else {
+      release();
+      data_ = other.data_;
+      size_ = other.size_;
+      capacity_ = other.capacity_;
+      other.data_ = other.inline_;
+    }
+    other.size_ = 0;
+    other.inline_[0] = '\0';
+    return *this;
+  }
+
+  basic_sso_string &operator=(std::string_view sv) { return assign(sv.data(), sv.size()); }
+  basic_sso_string &operator=(const char *s) { return *this = std::string_view(s); }
+
+  ~basic_sso_string() { release(); }
+
+  [[nodiscard]] size_t size() const noexcept { return size_; }
+  [[nodiscard]] size_t length() const noexcept { return size_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] size_t capacity() const noexcept { return is_inline() ? N : capacity_; }
+  [[nodiscard]] bool is_inline() const noexcept { return data_ == inline_; }
+
+  char *data() noexcept { return data_; }
+  const char *data() const noexcept { return data_; }
+  const char *c_str() const noexcept { return data_; }
+
+  char &operator[](size_t i) noexcept { return data_[i]; }
+  const char &operator[](size_t i) const noexcept { return data_[i]; }
+  char &back() noexcept { return data_[size_ - 1]; }
+
+  iterator begin() noexcept { return data_; }
+  iterator end() noexcept { return data_ + size_; }
+  const_iterator begin() const noexcept { return data_; }
+  const_iterator end() const noexcept { return data_ + size_; }
+
+  operator std::string_view() const noexcept { return {data_, size_}; }
+  [[nodiscard]] std::string str() const { return {data_, size_}; }
+
+  basic_sso_string &assign(const char *s, size_t n) {
+    if (n > capacity()) {
+      // s may point into our own buffer; copy before releasing it.
+      basic_sso_string fresh(std::string_view(s, n));
+      *this = std::move(fresh);
+      return *this;
+    }
+    std::memmove(data_, s, n);
+    set_size(n);
+    return *this;
+  }
+
+  void reserve(size_t n) {
+    if (n > capacity())
+      reallocate(n);
+  }
+
+  void resize(size_t n, char c = '\0') {
+    const size_t old = size_;
+    resize_and_overwrite(n, [&](char *p, size_t m) {
+      if (m > old)
+        std::memset(p + old, c, m - old);
+      return m;
+    });
+  }
+
+  /// Grow (or shrink) to n chars without initializing the new ones, then let
+  /// op(data, n) write them; op returns the final size, at most n.
+  template <typename Op> void resize_and_overwrite(size_t n, Op op) {
+    reserve(n);
+    const size_t final_size = static_cast<size_t>(std::move(op)(data_, n));
+    set_size(final_size);
+  }
+
+  basic_sso_string &append(std::string_view sv) {
+    const size_t old = size_;
+    if (old + sv.size() > capacity()) {
+      // sv may alias our buffer, which reallocate() frees.
+      const bool aliased = std::less_equal<>{}(data_, sv.data()) &&
+                           std::less<>{}(sv.data(), data_ + old);
+      const size_t offset = aliased ? static_cast<size_t>(sv.data() - data_) : 0;
+      reallocate(std::max(old + sv.size(), 2 * capacity()));
+      if (aliased)
+        sv = {data_ + offset, sv.size()};
+    }
+    std::memcpy(data_ + old, sv.data(), sv.size());
+    set_size(old + sv.size());
+    return *this;
+  }
+  basic_sso_string &operator+=(std::string_view sv) { return append(sv); }
+  basic_sso_string &operator+=(char c) {
+    push_back(c);
+    return *this;
+  }
+
+  void push_back(char c) {
+    if (size_ == capacity())
+      reallocate(2 * capacity());
+    data_[size_] = c;
+    set_size(size_ + 1);
+  }
+
+  void clear() noexcept { set_size(0); }
+
+  [[nodiscard]] size_t find(char c, size_t pos = 0) const noexcept {
+    return std::string_view(*this).find(c, pos);
+  }
+  [[nodiscard]] size_t find(std::string_view sv, size_t pos = 0) const noexcept {
+    return std::string_view(*this).find(sv, pos);
+  }
+
+  friend bool operator==(const basic_sso_string &a, const basic_sso_string &b) noexcept {
+    return a.size_ == b.size_ && std::memcmp(a.data_, b.data_, a.size_) == 0;
+  }
+  friend bool operator==(const basic_sso_string &a, std::string_view b) noexcept {
+    return std::string_view(a) == b;
+  }
+  friend bool operator==(const basic_sso_string &a, const char *b) noexcept {
+    return std::string_view(a) == b;
+  }
+  friend std::strong_ordering operator<=>(const basic_sso_string &a,
+                                          const basic_sso_string &b) noexcept {
+    return std::string_view(a) <=> std::string_view(b);
+  }
+  friend std::strong_ordering operator<=>(const basic_sso_string &a, std::string_view b) noexcept {
+    return std::string_view(a) <=> b;
+  }
+  friend std::strong_ordering operator<=>(const basic_sso_string &a, const char *b) noexcept {
+    return std::string_view(a) <=> b;
+  }
+
+  friend std::ostream &operator<<(std::ostream &os, const basic_sso_string &s) {
+    return os << std::string_view(s);
+  }
+
+private:
+  void init(const char *s, size_t n) {
+    if (n > N) {
+      data_ = new char[n + 1];
+      capacity_ = n;
+    }
+    if (s)
+      std::memcpy(data_, s, n);
+    set_size(n);
+  }
+
+  void reallocate(size_t n) {
+    char *fresh = new char[n + 1];
+    std::memcpy(fresh, data_, size_ + 1);
+    release();
+    data_ = fresh;
+    capacity_ = n;
+  }
+
+  void release() noexcept {
+    if (!is_inline())
+      delete[] data_;
+    data_ = inline_;
+  }
+
+  void set_size(size_t n) noexcept {
+    size_ = n;
+    data_[n] = '\0';
+  }
+
+  char *data_ = inline_;
+  size_t size_ = 0;
+  union {
+    size_t capacity_; // when on the heap
+    char inline_[N + 1];
+  };
+};
+
+using sso_string = basic_sso_string<23>;
+
+} // end of namespace strings
+
+template <size_t N> struct std::hash<strings::basic_sso_string<N>> {
+  size_t operator()(const strings::basic_sso_string<N> &s) const noexcept {
+    return std::hash<std::string_view>{}(s);
+  }
+};
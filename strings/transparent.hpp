@@ -0,0 +1,50 @@
+#pragma once
+
+// DESCRIPTION:
+//  Heterogeneous ("transparent") lookup for string-keyed containers.
+//
+//  std::unordered_map<std::string, V>::find only takes a std::string, so
+//  m.find(sv) or m.find("literal") first builds a temporary std::string,
+//  which allocates for anything past the 15-char SSO buffer. With a hash
+//  and an equality that declare is_transparent and accept string_view,
+//  find/contains/count/equal_range take the argument as it is (C++20).
+//  Ordered containers get the same from std::less<>.
+//
+//  string_hash hashes like std::hash<std::string_view>, so a std::string,
+//  a string_view, a literal and an sso_string of the same text all collide
+//  as they should.
+//
+//  Insertion still builds the std::string key, as it must; try_emplace and
+//  operator[] take a std::string.
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace strings {
+
+struct string_hash {
+  using is_transparent = void;
+  size_t operator()(std::string_view s) const noexcept {
+    return std::hash<std::string_view>{}(s);
+  }
+};
+
+struct string_equal {
+  using is_transparent = void;
+  bool operator()(std::string_view a, std::string_view b) const noexcept { return a == b; }
+};
+
+template <typename V>
+using string_map = std::unordered_map<std::string, V, string_hash, string_equal>;
+using string_set = std::unordered_set<std::string, string_hash, string_equal>;
+
+template <typename V> using ordered_string_map = std::map<std::string, V, std::less<>>;
+using ordered_string_set = std::set<std::string, std::less<>>;
+
+} // end of namespace strings
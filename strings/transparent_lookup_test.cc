@@ -0,0 +1,125 @@
+#include "my_timer.h"
+#include "transparent.hpp"
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <new>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Count this thread's heap allocations. The replacement operator new/delete
+// is global to the program, which is why this file is built as its own test
+// binary (see CMakeLists.txt) rather than into cpp_weekly.
+namespace {
+thread_local constinit size_t allocations = 0;
+
+/// Allocations made on this thread while the object is alive.
+class AllocationCounter {
+public:
+  AllocationCounter() : start_(allocations) {}
+  [[nodiscard]] size_t count() const { return allocations - start_; }
+
+private:
+  size_t start_;
+};
+} // namespace
+
+// noinline: once inlined, g++ sees memory from operator new reach free()
+// and -Wall warns (-Wmismatched-new-delete).
+__attribute__((noinline)) void *operator new(size_t size) {
+  ++allocations;
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void *p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+// Past the 15-char SSO buffer, so a temporary std::string would allocate.
+const std::vector<std::string> kKeys = {
+    "configuration.network.timeout", "configuration.network.retries",
+    "configuration.storage.path",    "configuration.storage.quota_bytes",
+    "metrics.exporter.endpoint",     "metrics.exporter.interval_seconds",
+};
+
+} // namespace
+
+TEST(transparent_lookup, lookups_do_not_allocate) {
+  strings::string_map<int> map;
+  strings::string_set set;
+  strings::ordered_string_map<int> ordered;
+  for (size_t i = 0; i < kKeys.size(); ++i) {
+    map.emplace(kKeys[i], static_cast<int>(i));
+    set.insert(kKeys[i]);
+    ordered.emplace(kKeys[i], static_cast<int>(i));
+  }
+
+  const std::string text = "key=metrics.exporter.endpoint;";
+  const std::string_view sv = std::string_view(text).substr(4, 25);
+  const char *literal = "configuration.storage.path";
+  {
+    AllocationCounter counter;
+    EXPECT_EQ(map.find(sv)->second, 4);
+    EXPECT_TRUE(map.contains(literal));
+    EXPECT_EQ(map.count("configuration.network.retries"), 1);
+    EXPECT_EQ(map.find("configuration.missing.key.name"), map.end());
+    EXPECT_TRUE(set.contains(sv));
+    EXPECT_EQ(set.count(literal), 1);
+    EXPECT_EQ(ordered.find(sv)->second, 4);
+    EXPECT_TRUE(ordered.contains(literal));
+    EXPECT_EQ(counter.count(), 0);
+  }
+
+  // The same lookups on a plain map build a std::string each time.
+  std::unordered_map<std::string, int> plain(map.begin(), map.end());
+  {
+    AllocationCounter counter;
+    EXPECT_EQ(plain.find(std::string(sv))->second, 4);
+    EXPECT_TRUE(plain.contains(literal));
+    EXPECT_EQ(counter.count(), 2);
+  }
+}
+
+TEST(transparent_lookup, lookup_benchmark) {
+  constexpr size_t rounds = 1000000;
+  std::unordered_map<std::string, int> plain;
+  strings::string_map<int> transparent;
+  for (size_t i = 0; i < kKeys.size(); ++i) {
+    plain.emplace(kKeys[i], static_cast<int>(i));
+    transparent.emplace(kKeys[i], static_cast<int>(i));
+  }
+  std::vector<std::string_view> queries(kKeys.begin(), kKeys.end());
+
+  long a = 0, b = 0;
+  size_t plain_allocs, transparent_allocs;
+  Timer t1("std::string temporary");
+  {
+    AllocationCounter counter;
+    for (size_t r = 0; r < rounds; ++r)
+      a += plain.find(std::string(queries[r % queries.size()]))->second;
+    plain_allocs = counter.count();
+  }
+  auto plain_ns = t1.eclipse();
+  Timer t2("transparent");
+  {
+    AllocationCounter counter;
+    for (size_t r = 0; r < rounds; ++r)
+      b += transparent.find(queries[r % queries.size()])->second;
+    transparent_allocs = counter.count();
+  }
+  auto transparent_ns = t2.eclipse();
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(plain_allocs, rounds);
+  EXPECT_EQ(transparent_allocs, 0);
+
+#ifndef NDEBUG
+  std::cout << rounds << " string_view lookups, ns each: via std::string "
+            << static_cast<double>(plain_ns) / rounds << ", transparent "
+            << static_cast<double>(transparent_ns) / rounds << '\n';
+#else
+  (void)plain_ns, (void)transparent_ns;
+#endif
+}
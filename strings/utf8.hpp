@@ -0,0 +1,678 @@
+#pragma once
+
+// DESCRIPTION:
+//  UTF-8 validation, and transcoding between UTF-8 and UTF-16 / UTF-32.
+//
+//    validate    is [p, p + n) well-formed UTF-8 (no overlong forms, no
+//                surrogates, nothing past U+10FFFF, nothing cut off)?
+//    to_utf16    UTF-8 -> UTF-16, writes at most n units
+//    to_utf32    UTF-8 -> UTF-32, writes at most n units
+//    from_utf16  UTF-16 -> UTF-8, writes at most 3 * n bytes
+//    from_utf32  UTF-32 -> UTF-8, writes at most 4 * n bytes
+//
+//  The transcoders write into the caller's buffer (the bounds above always
+//  fit) and return the number of units written, or nullopt if the input is
+//  not valid; they validate as they go.
+//
+//  * validate uses the lookup algorithm of Keiser and Lemire ("Validating
+//    UTF-8 in less than one instruction per byte", 2021): three pshufb
+//    table lookups on the high and low nibbles of each byte and the high
+//    nibble of the byte before it flag every bad two-byte pattern, and a
+//    saturating subtract checks the 3rd and 4th bytes of long sequences.
+//    All-ASCII blocks skip the lookups. The last partial block is padded
+//    with zeros, so a sequence cut off at the end looks like one cut off by
+//    an ASCII byte.
+//  * The transcoders widen (or narrow) the ASCII runs in registers. With
+//    AVX2, runs of U+0800..U+FFFF (CJK and most other non-Latin scripts)
+//    between UTF-8 and UTF-16 are done 8 characters at a time: a pshufb puts
+//    each 3-byte sequence in a 32-bit lane and shifts and masks do the
+//    rest. Everything else is decoded one sequence at a time.
+//
+//  The instruction set comes from strings::simd::best_isa(). validate needs
+//  pshufb (sse42 tier or better); with sse2 it runs the scalar loop, which
+//  skips ASCII 8 bytes at a time.
+
+#include "simd_find.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+
+namespace strings::utf8 {
+
+using simd::isa;
+
+namespace detail {
+
+struct kernels {
+  // ---- scalar ----
+
+  /// Length of the UTF-8 sequence at s[i] (its code point in cp), or 0 if
+  /// it is not a valid sequence.
+  static size_t decode(const uint8_t *s, size_t i, size_t n, char32_t &cp) noexcept {
+    const uint8_t lead = s[i];
+    if (lead < 0x80) {
+      cp = lead;
+      return 1;
+    }
+    size_t len;
+    char32_t min;
+    if (lead >= 0xc2 && lead <= 0xdf) {
+      len = 2, cp = lead & 0x1f, min = 0x80;
+    } else if ((lead & 0xf0) == 0xe0) {
+      len = 3, cp = lead & 0x0f, min = 0x800;
+    } else if (lead >= 0xf0 && lead <= 0xf4) {
+      len = 4, cp = lead & 0x07, min = 0x10000;
+    } else {
+      return 0; // continuation byte, overlong C0/C1, or F5..FF
+    }
+    if (n - i < len)
+      return 0;
+    for (size_t k = 1; k < len; ++k) {
+      const uint8_t c = s[i + k];
+      if ((c & 0xc0) != 0x80)
+        return 0;
+      cp = (cp << 6) | (c & 0x3f);
+    }
+    if (cp < min || cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff))
+      return 0;
+    return len;
+  }
+
+  /// Write a Unicode scalar value as UTF-8.
+  static char *encode(char32_t cp, char *out) noexcept {
+    if (cp < 0x80) {
+      *out++ = static_cast<char>(cp);
+    } else if (cp < 0x800) {
+      *out++ = static_cast<char>(0xc0 | (cp >> 6));
+      *out++ = static_cast<char>(0x80 | (cp & 0x3f));
+    } else if (cp < 0x10000) {
+      *out++ = static_cast<char>(0xe0 | (cp >> 12));
+      *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+      *out++ = static_cast<char>(0x80 | (cp & 0x3f));
+    } else {
+      *out++ = static_cast<char>(0xf0 | (cp >> 18));
+      *out++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+      *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+      *out++ = static_cast<char>(0x80 | (cp & 0x3f));
+    }
+    return out;
+  }
+
+  static bool validate_scalar(const uint8_t *s, size_t i, size_t n) noexcept {
+    while (i < n) {
+      uint64_t word;
+      if (i + 8 <= n && (std::memcpy(&word, s + i, 8), (word & 0x8080808080808080) == 0)) {
+        i += 8;
+        continue;
+      }
+      char32_t cp;
+      const size_t len = decode(s, i, n, cp);
+      if (len == 0)
+        return false;
+      i += len;
+    }
+    return true;
+  }
+
+  /// Decode the sequences that start in [i, end) into out; i ends at the
+  /// first sequence at or past end. False on invalid input.
+  template <typename Unit>
+  static bool utf8_to_scalar(const uint8_t *s, size_t &i, size_t end, size_t n,
+                             Unit *&out) noexcept {
+    while (i < end) {
+      char32_t cp;
+      const size_t len = decode(s, i, n, cp);
+      if (len == 0)
+        return false;
+      i += len;
+      if (sizeof(Unit) == 2 && cp >= 0x10000) {
+        cp -= 0x10000;
+        *out++ = static_cast<Unit>(0xd800 + (cp >> 10));
+        *out++ = static_cast<Unit>(0xdc00 + (cp & 0x3ff));
+      } else {
+        *out++ = static_cast<Unit>(cp);
+      }
+    }
+    return true;
+  }
+
+  /// Decode the run of non-ASCII sequences at i, up to the next ASCII byte,
+  /// so that the SIMD loop can take over again there.
+  template <typename Unit>
+  static bool utf8_to_run(const uint8_t *s, size_t &i, size_t n, Unit *&out) noexcept {
+    do {
+      if (!utf8_to_scalar(s, i, i + 1, n, out))
+        return false;
+    } while (i < n && s[i] >= 0x80);
+    return true;
+  }
+
+  /// UTF-16 units [i, end) to UTF-8; a pair may read one unit past end.
+  static bool utf16_to_scalar(const char16_t *p, size_t &i, size_t end, size_t n,
+                              char *&out) noexcept {
+    while (i < end) {
+      char32_t cp = p[i++];
+      if (cp >= 0xd800 && cp <= 0xdfff) {
+        if (cp > 0xdbff || i == n || p[i] < 0xdc00 || p[i] > 0xdfff)
+          return false; // unpaired surrogate
+        cp = 0x10000 + ((cp - 0xd800) << 10) + (p[i++] - 0xdc00);
+      }
+      out = encode(cp, out);
+    }
+    return true;
+  }
+
+  static bool utf32_to_scalar(const char32_t *p, size_t &i, size_t end, char *&out) noexcept {
+    for (; i < end; ++i) {
+      const char32_t cp = p[i];
+      if (cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff))
+        return false;
+      out = encode(cp, out);
+    }
+    return true;
+  }
+
+  // Keiser-Lemire error classes. A pair of bytes (previous, current) is bad
+  // iff its three lookups share a set bit.
+  static constexpr uint8_t kTooShort = 1 << 0;     // lead then non-continuation
+  static constexpr uint8_t kTooLong = 1 << 1;      // ASCII then continuation
+  static constexpr uint8_t kOverlong3 = 1 << 2;    // E0 80..9F
+  static constexpr uint8_t kTooLarge = 1 << 3;     // F4 90..BF, F5.. 90..BF
+  static constexpr uint8_t kSurrogate = 1 << 4;    // ED A0..BF
+  static constexpr uint8_t kOverlong2 = 1 << 5;    // C0..C1 any
+  static constexpr uint8_t kTooLarge1000 = 1 << 6; // F5.. 80..8F
+  static constexpr uint8_t kOverlong4 = 1 << 6;    // F0 80..8F
+  static constexpr uint8_t kTwoConts = 1 << 7;     // continuation then continuation
+  static constexpr uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+
+  /// Indexed by the previous byte's high nibble.
+  static constexpr std::array<uint8_t, 16> kByte1High = {
+      kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, // ASCII
+      kTwoConts, kTwoConts, kTwoConts, kTwoConts,                         // continuation
+      kTooShort | kOverlong2,                                             // C0..CF
+      kTooShort,                                                          // D0..DF
+      kTooShort | kOverlong3 | kSurrogate,                                // E0..EF
+      kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,                 // F0..FF
+  };
+  /// Indexed by the previous byte's low nibble.
+  static constexpr std::array<uint8_t, 16> kByte1Low = {
+      kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+      kCarry | kOverlong2,
+      kCarry,
+      kCarry,
+      kCarry | kTooLarge,
+      kCarry | kTooLarge | kTooLarge1000,
+      kCarry | kTooLarge | kTooLarge1000,
+      kCarry | kTooLarge | kTooLarge1000,
+      kCarry | kTooLarge | kTooLarge1000,
+      kCarry | kTooLarge | kTooLarge1000,
+      kCarry | kTooLarge | kTooLarge1000,
+      kCarry | kTooLarge | kTooLarge1000,
+      kCarry | kTooLarge | kTooLarge1000,
+      kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+      kCarry | kTooLarge | kTooLarge1000,
+      kCarry | kTooLarge | kTooLarge1000,
+  };
+  /// Indexed by the current byte's high nibble.
+  static constexpr std::array<uint8_t, 16> kByte2High = {
+      kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+      kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4, // 80..8F
+      kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,                  // 90..9F
+      kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,                  // A0..AF
+      kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,                  // B0..BF
+      kTooShort, kTooShort, kTooShort, kTooShort,
+  };
+
+#ifdef STRINGS_SIMD_X86
+  // ---- SSE2 / SSE4.2, 16 bytes per step ----
+
+  __attribute__((target("sse4.2"))) static __m128i check_block_sse42(__m128i input,
+                                                                    __m128i prev) noexcept {
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    const __m128i prev1 = _mm_alignr_epi8(input, prev, 15);
+    const __m128i byte_1_high = _mm_shuffle_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(kByte1High.data())),
+        _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+    const __m128i byte_1_low =
+        _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(kByte1Low.data())),
+                         _mm_and_si128(prev1, nibble));
+    const __m128i byte_2_high = _mm_shuffle_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(kByte2High.data())),
+        _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+    const __m128i special = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+    // Bytes 3 and 4 of a sequence must be continuations (and nothing else
+    // may be two continuations in a row): 80 where E0.. is 2 back or F0.. 3.
+    const __m128i prev2 = _mm_alignr_epi8(input, prev, 14);
+    const __m128i prev3 = _mm_alignr_epi8(input, prev, 13);
+    const __m128i must_continue =
+        _mm_and_si128(_mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8(0xe0 - 0x80)),
+                                   _mm_subs_epu8(prev3, _mm_set1_epi8(0xf0 - 0x80))),
+                      _mm_set1_epi8(-128));
+    return _mm_xor_si128(must_continue, special);
+  }
+
+  __attribute__((target("sse4.2"))) static bool validate_sse42(const char *p, size_t n) noexcept {
+    // Nonzero where the block ends inside a sequence.
+    const __m128i max_complete =
+        _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, static_cast<char>(0xef),
+                      static_cast<char>(0xdf), static_cast<char>(0xbf));
+    __m128i error = _mm_setzero_si128(), prev = _mm_setzero_si128();
+    __m128i prev_incomplete = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+      const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+      if (_mm_movemask_epi8(input) == 0) {
+        error = _mm_or_si128(error, prev_incomplete);
+        prev_incomplete = _mm_setzero_si128();
+      } else {
+        error = _mm_or_si128(error, check_block_sse42(input, prev));
+        prev_incomplete = _mm_subs_epu8(input, max_complete);
+      }
+      prev = input;
+    }
+    alignas(16) char last[16] = {};
+    std::memcpy(last, p + i, n - i);
+    error = _mm_or_si128(error, check_block_sse42(_mm_load_si128(reinterpret_cast<__m128i *>(last)),
+                                                  prev));
+    return _mm_testz_si128(error, error);
+  }
+
+  template <typename Unit>
+  static std::optional<size_t> utf8_to_sse2(const char *p, size_t n, Unit *out) noexcept {
+    const auto *s = reinterpret_cast<const uint8_t *>(p);
+    const __m128i zero = _mm_setzero_si128();
+    Unit *o = out;
+    size_t i = 0;
+    while (i + 16 <= n) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+      // Widen all 16 bytes; only the ASCII prefix is kept. Every input byte
+      // becomes at most one unit, so o + 16 <= out + i + 16 <= out + n. After
+      // non-ASCII text, the next block starts at the next ASCII byte.
+      const __m128i lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+      if constexpr (sizeof(Unit) == 2) {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(o), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(o + 8), hi);
+      } else {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(o), _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(o + 4), _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(o + 8), _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(o + 12), _mm_unpackhi_epi16(hi, zero));
+      }
+      const unsigned mask = _mm_movemask_epi8(v);
+      if (mask == 0) {
+        i += 16, o += 16;
+        continue;
+      }
+      i += __builtin_ctz(mask), o += __builtin_ctz(mask);
+      if (!utf8_to_run(s, i, n, o))
+        return std::nullopt;
+    }
+    if (!utf8_to_scalar(s, i, n, n, o))
+      return std::nullopt;
+    return static_cast<size_t>(o - out);
+  }
+
+  static std::optional<size_t> utf16_to_sse2(const char16_t *p, size_t n, char *out) noexcept {
+    const __m128i non_ascii = _mm_set1_epi16(static_cast<short>(0xff80));
+    char *o = out;
+    size_t i = 0;
+    while (i + 16 <= n) {
+      const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+      const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i + 8));
+      const __m128i high = _mm_and_si128(_mm_or_si128(a, b), non_ascii);
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(high, _mm_setzero_si128())) == 0xffff) {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(o), _mm_packus_epi16(a, b));
+        i += 16, o += 16;
+      } else if (!utf16_to_scalar(p, i, i + 16, n, o)) {
+        return std::nullopt;
+      }
+    }
+    if (!utf16_to_scalar(p, i, n, n, o))
+      return std::nullopt;
+    return static_cast<size_t>(o - out);
+  }
+
+  static std::optional<size_t> utf32_to_sse2(const char32_t *p, size_t n, char *out) noexcept {
+    const __m128i non_ascii = _mm_set1_epi32(static_cast<int>(0xffffff80));
+    char *o = out;
+    size_t i = 0;
+    while (i + 16 <= n) {
+      __m128i v[4];
+      for (int k = 0; k < 4; ++k)
+        v[k] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i + 4 * k));
+      const __m128i any = _mm_or_si128(_mm_or_si128(v[0], v[1]), _mm_or_si128(v[2], v[3]));
+      const __m128i high = _mm_and_si128(any, non_ascii);
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(high, _mm_setzero_si128())) == 0xffff) {
+        const __m128i packed =
+            _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(o), packed);
+        i += 16, o += 16;
+      } else if (!utf32_to_scalar(p, i, i + 16, o)) {
+        return std::nullopt;
+      }
+    }
+    if (!utf32_to_scalar(p, i, n, o))
+      return std::nullopt;
+    return static_cast<size_t>(o - out);
+  }
+
+  // ---- AVX2, 32 bytes per step ----
+
+  /// The 32 bytes ending N before `input`, from `prev` and `input`.
+  template <int N>
+  __attribute__((target("avx2"))) static __m256i prev_avx2(__m256i input, __m256i prev) noexcept {
+    return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - N);
+  }
+
+  __attribute__((target("avx2"))) static __m256i load_table_avx2(const uint8_t *table) noexcept {
+    return _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(table)));
+  }
+
+  __attribute__((target("avx2"))) static __m256i check_block_avx2(__m256i input,
+                                                                  __m256i prev) noexcept {
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i prev1 = prev_avx2<1>(input, prev);
+    const __m256i byte_1_high = _mm256_shuffle_epi8(
+        load_table_avx2(kByte1High.data()), _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+    const __m256i byte_1_low =
+        _mm256_shuffle_epi8(load_table_avx2(kByte1Low.data()), _mm256_and_si256(prev1, nibble));
+    const __m256i byte_2_high = _mm256_shuffle_epi8(
+        load_table_avx2(kByte2High.data()), _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+    const __m256i special =
+        _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+    const __m256i must_continue = _mm256_and_si256(
+        _mm256_or_si256(_mm256_subs_epu8(prev_avx2<2>(input, prev), _mm256_set1_epi8(0xe0 - 0x80)),
+                        _mm256_subs_epu8(prev_avx2<3>(input, prev),
+                                         _mm256_set1_epi8(0xf0 - 0x80))),
+        _mm256_set1_epi8(-128));
+    return _mm256_xor_si256(must_continue, special);
+  }
+
+  __attribute__((target("avx2"))) static bool validate_avx2(const char *p, size_t n) noexcept {
+    const __m256i max_complete = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, static_cast<char>(0xef), static_cast<char>(0xdf),
+        static_cast<char>(0xbf));
+    __m256i error = _mm256_setzero_si256(), prev = _mm256_setzero_si256();
+    __m256i prev_incomplete = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+      const __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+      if (_mm256_movemask_epi8(input) == 0) {
+        error = _mm256_or_si256(error, prev_incomplete);
+        prev_incomplete = _mm256_setzero_si256();
+      } else {
+        error = _mm256_or_si256(error, check_block_avx2(input, prev));
+        prev_incomplete = _mm256_subs_epu8(input, max_complete);
+      }
+      prev = input;
+    }
+    alignas(32) char last[32] = {};
+    std::memcpy(last, p + i, n - i);
+    error = _mm256_or_si256(
+        error, check_block_avx2(_mm256_load_si256(reinterpret_cast<__m256i *>(last)), prev));
+    return _mm256_testz_si256(error, error);
+  }
+
+  /// Decode up to 8 three-byte sequences at s[0, 24) into units; returns
+  /// how many of them, from the front, were valid 3-byte sequences. Writes
+  /// 8 units regardless.
+  template <typename Unit>
+  __attribute__((target("avx2"))) static size_t three_byte_to_avx2(const uint8_t *s,
+                                                                   Unit *out) noexcept {
+    const __m256i v = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 12)), 1);
+    // One sequence per 32-bit lane, lead byte on top: 00 b0 b1 b2.
+    const __m256i lanes = _mm256_shuffle_epi8(
+        v, _mm256_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1, 2, 1, 0, -1, 5,
+                            4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1));
+    const __m256i cp = _mm256_or_si256(
+        _mm256_and_si256(lanes, _mm256_set1_epi32(0x3f)),
+        _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(lanes, 2), _mm256_set1_epi32(0xfc0)),
+                        _mm256_and_si256(_mm256_srli_epi32(lanes, 4), _mm256_set1_epi32(0xf000))));
+    const __m256i is_1110_10_10 = _mm256_cmpeq_epi32(
+        _mm256_and_si256(lanes, _mm256_set1_epi32(0xf0c0c0)), _mm256_set1_epi32(0xe08080));
+    const __m256i overlong = _mm256_cmpgt_epi32(_mm256_set1_epi32(0x800), cp);
+    const __m256i surrogate = _mm256_cmpeq_epi32(
+        _mm256_and_si256(cp, _mm256_set1_epi32(0xf800)), _mm256_set1_epi32(0xd800));
+    const __m256i bad = _mm256_or_si256(_mm256_andnot_si256(is_1110_10_10, _mm256_set1_epi8(-1)),
+                                        _mm256_or_si256(overlong, surrogate));
+    if constexpr (sizeof(Unit) == 4) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), cp);
+    } else {
+      const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(cp, cp), 0x08);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm256_castsi256_si128(packed));
+    }
+    const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(bad));
+    return mask ? __builtin_ctz(mask) / 4 : 8;
+  }
+
+  /// Encode up to 8 units at p as 3 bytes each; returns how many of them,
+  /// from the front, are in U+0800..U+FFFF and not surrogates. Writes 28
+  /// bytes regardless.
+  __attribute__((target("avx2"))) static size_t three_byte_from_avx2(const char16_t *p,
+                                                                     char *out) noexcept {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    const __m128i below_800 = _mm_cmpeq_epi16(_mm_max_epu16(v, _mm_set1_epi16(0x800)),
+                                               _mm_set1_epi16(0x800));
+    const __m128i surrogate = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(-0x800)),
+                                              _mm_set1_epi16(static_cast<short>(0xd800)));
+    // max(v, 0x800) == 0x800 also holds for v == 0x800 itself.
+    const __m128i exact_800 = _mm_cmpeq_epi16(v, _mm_set1_epi16(0x800));
+    const __m128i bad = _mm_or_si128(_mm_andnot_si128(exact_800, below_800), surrogate);
+    // Per 32-bit lane: b0 b1 b2 00 in memory order.
+    const __m256i u = _mm256_cvtepu16_epi32(v);
+    const __m256i b0 = _mm256_or_si256(_mm256_srli_epi32(u, 12), _mm256_set1_epi32(0xe0));
+    const __m256i b1 = _mm256_or_si256(
+        _mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(u, 6), _mm256_set1_epi32(0x3f)), 8),
+        _mm256_set1_epi32(0x8000));
+    const __m256i b2 = _mm256_or_si256(
+        _mm256_slli_epi32(_mm256_and_si256(u, _mm256_set1_epi32(0x3f)), 16),
+        _mm256_set1_epi32(0x800000));
+    const __m256i bytes = _mm256_shuffle_epi8(
+        _mm256_or_si256(b0, _mm256_or_si256(b1, b2)),
+        _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1, 0, 1, 2, 4, 5, 6,
+                         8, 9, 10, 12, 13, 14, -1, -1, -1, -1));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm256_castsi256_si128(bytes));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 12), _mm256_extracti128_si256(bytes, 1));
+    const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(bad));
+    return mask ? __builtin_ctz(mask) / 2 : 8;
+  }
+
+  template <typename Unit>
+  __attribute__((target("avx2"))) static std::optional<size_t>
+  utf8_to_avx2(const char *p, size_t n, Unit *out) noexcept {
+    const auto *s = reinterpret_cast<const uint8_t *>(p);
+    Unit *o = out;
+    size_t i = 0;
+    while (i + 32 <= n) {
+      const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+      const __m128i lo = _mm256_castsi256_si128(v), hi = _mm256_extracti128_si256(v, 1);
+      if constexpr (sizeof(Unit) == 2) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(o), _mm256_cvtepu8_epi16(lo));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(o + 16), _mm256_cvtepu8_epi16(hi));
+      } else {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(o), _mm256_cvtepu8_epi32(lo));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(o + 8),
+                            _mm256_cvtepu8_epi32(_mm_srli_si128(lo, 8)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(o + 16), _mm256_cvtepu8_epi32(hi));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(o + 24),
+                            _mm256_cvtepu8_epi32(_mm_srli_si128(hi, 8)));
+      }
+      const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(v));
+      if (mask == 0) {
+        i += 32, o += 32;
+        continue;
+      }
+      i += __builtin_ctz(mask), o += __builtin_ctz(mask);
+      // The non-ASCII run: up to 8 three-byte sequences at a time, else one
+      // sequence of another length. o + 8 <= out + i + 8 <= out + n.
+      do {
+        const size_t k = i + 28 <= n ? three_byte_to_avx2(s + i, o) : 0;
+        if (k) {
+          i += 3 * k, o += k;
+        } else if (!utf8_to_scalar(s, i, i + 1, n, o)) {
+          return std::nullopt;
+        }
+      } while (i < n && s[i] >= 0x80);
+    }
+    const auto tail = utf8_to_sse2(p + i, n - i, o);
+    if (!tail)
+      return std::nullopt;
+    return static_cast<size_t>(o - out) + *tail;
+  }
+
+  __attribute__((target("avx2"))) static std::optional<size_t>
+  utf16_to_avx2(const char16_t *p, size_t n, char *out) noexcept {
+    const __m256i non_ascii = _mm256_set1_epi16(static_cast<short>(0xff80));
+    char *o = out;
+    size_t i = 0;
+    while (i + 32 <= n) {
+      const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+      const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i + 16));
+      // packus works per 128-bit lane; put the quarters back in order. Units
+      // past the ASCII prefix come out as junk that is written over later;
+      // o + 32 <= out + 3 * (i + 32) <= out + 3 * n.
+      const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(o), packed);
+      const __m256i zero = _mm256_setzero_si256();
+      const uint64_t ascii =
+          static_cast<uint32_t>(_mm256_movemask_epi8(
+              _mm256_cmpeq_epi16(_mm256_and_si256(a, non_ascii), zero))) |
+          uint64_t{static_cast<uint32_t>(
+              _mm256_movemask_epi8(_mm256_cmpeq_epi16(_mm256_and_si256(b, non_ascii), zero)))}
+              << 32;
+      if (ascii == ~uint64_t{0}) {
+        i += 32, o += 32;
+        continue;
+      }
+      const auto prefix = static_cast<size_t>(__builtin_ctzll(~ascii) / 2);
+      i += prefix, o += prefix;
+      // The non-ASCII run, as in utf8_to_avx2. o + 28 <= out + 3 * (i + 16).
+      do {
+        const size_t k = i + 16 <= n ? three_byte_from_avx2(p + i, o) : 0;
+        if (k) {
+          i += k, o += 3 * k;
+        } else if (!utf16_to_scalar(p, i, i + 1, n, o)) {
+          return std::nullopt;
+        }
+      } while (i < n && p[i] >= 0x80);
+    }
+    const auto tail = utf16_to_sse2(p + i, n - i, o);
+    if (!tail)
+      return std::nullopt;
+    return static_cast<size_t>(o - out) + *tail;
+  }
+
+  __attribute__((target("avx2"))) static std::optional<size_t>
+  utf32_to_avx2(const char32_t *p, size_t n, char *out) noexcept {
+    const __m256i non_ascii = _mm256_set1_epi32(static_cast<int>(0xffffff80));
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    char *o = out;
+    size_t i = 0;
+    while (i + 32 <= n) {
+      __m256i v[4];
+      for (int k = 0; k < 4; ++k)
+        v[k] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i + 8 * k));
+      const __m256i any = _mm256_or_si256(_mm256_or_si256(v[0], v[1]), _mm256_or_si256(v[2], v[3]));
+      if (_mm256_testz_si256(any, non_ascii)) {
+        // Per lane, the packs leave 4-byte groups in the order 0 2 4 6 1 3 5 7.
+        const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(v[0], v[1]),
+                                                   _mm256_packs_epi32(v[2], v[3]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(o),
+                            _mm256_permutevar8x32_epi32(packed, order));
+        i += 32, o += 32;
+      } else if (!utf32_to_scalar(p, i, i + 32, o)) {
+        return std::nullopt;
+      }
+    }
+    const auto tail = utf32_to_sse2(p + i, n - i, o);
+    if (!tail)
+      return std::nullopt;
+    return static_cast<size_t>(o - out) + *tail;
+  }
+#endif
+};
+
+} // end of namespace detail
+
+/// Whether [p, p + n) is well-formed UTF-8.
+inline bool validate(const char *p, size_t n, isa use = simd::best_isa()) noexcept {
+#ifdef STRINGS_SIMD_X86
+  if (use == isa::avx2)
+    return detail::kernels::validate_avx2(p, n);
+  if (use == isa::sse42)
+    return detail::kernels::validate_sse42(p, n);
+#endif
+  return detail::kernels::validate_scalar(reinterpret_cast<const uint8_t *>(p), 0, n);
+}
+
+namespace detail {
+template <typename Unit>
+std::optional<size_t> utf8_to(const char *p, size_t n, Unit *out, isa use) noexcept {
+#ifdef STRINGS_SIMD_X86
+  if (use == isa::avx2)
+    return kernels::utf8_to_avx2(p, n, out);
+  if (use != isa::scalar)
+    return kernels::utf8_to_sse2(p, n, out);
+#endif
+  size_t i = 0;
+  Unit *o = out;
+  if (!kernels::utf8_to_scalar(reinterpret_cast<const uint8_t *>(p), i, n, n, o))
+    return std::nullopt;
+  return static_cast<size_t>(o - out);
+}
+} // end of namespace detail
+
+/// UTF-8 to UTF-16 into out[0, n); units written, or nullopt if invalid.
+inline std::optional<size_t> to_utf16(const char *p, size_t n, char16_t *out,
+                                      isa use = simd::best_isa()) noexcept {
+  return detail::utf8_to(p, n, out, use);
+}
+
+/// UTF-8 to UTF-32 into out[0, n); units written, or nullopt if invalid.
+inline std::optional<size_t> to_utf32(const char *p, size_t n, char32_t *out,
+                                      isa use = simd::best_isa()) noexcept {
+  return detail::utf8_to(p, n, out, use);
+}
+
+/// UTF-16 to UTF-8 into out[0, 3n); bytes written, or nullopt if p has an
+/// unpaired surrogate.
+inline std::optional<size_t> from_utf16(const char16_t *p, size_t n, char *out,
+                                        isa use = simd::best_isa()) noexcept {
+#ifdef STRINGS_SIMD_X86
+  if (use == isa::avx2)
+    return detail::kernels::utf16_to_avx2(p, n, out);
+  if (use != isa::scalar)
+    return detail::kernels::utf16_to_sse2(p, n, out);
+#endif
+  size_t i = 0;
+  char *o = out;
+  if (!detail::kernels::utf16_to_scalar(p, i, n, n, o))
+    return std::nullopt;
+  return static_cast<size_t>(o - out);
+}
+
+/// UTF-32 to UTF-8 into out[0, 4n); bytes written, or nullopt if p has a
+/// surrogate or a value past U+10FFFF.
+inline std::optional<size_t> from_utf32(const char32_t *p, size_t n, char *out,
+                                        isa use = simd::best_isa()) noexcept {
+#ifdef STRINGS_SIMD_X86
+  if (use == isa::avx2)
+    return detail::kernels::utf32_to_avx2(p, n, out);
+  if (use != isa::scalar)
+    return detail::kernels::utf32_to_sse2(p, n, out);
+#endif
+  size_t i = 0;
+  char *o = out;
+  if (!detail::kernels::utf32_to_scalar(p, i, n, o))
+    return std::nullopt;
+  return static_cast<size_t>(o - out);
+}
+
+} // end of namespace strings::utf8
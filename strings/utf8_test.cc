@@ -0,0 +1,244 @@
+#include "my_timer.h"
+#include "utf8.hpp"
+#include <gtest/gtest.h>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace simd = strings::simd;
+namespace utf8 = strings::utf8;
+
+namespace {
+
+std::vector<simd::isa> supported_isas() {
+  std::vector<simd::isa> out;
+  for (auto which : {simd::isa::scalar, simd::isa::sse2, simd::isa::sse42, simd::isa::avx2})
+    if (which <= simd::best_isa())
+      out.push_back(which);
+  return out;
+}
+
+// ASCII, 2-, 3- and 4-byte sequences, and the edges of each range.
+const std::string kMixed = "plain ascii, café ÿĀ ߿ࠀ 中文 ퟿"
+                           " ￿ \U00010000 \U0001f600 \U0010ffff.";
+const std::u16string kMixed16 = u"plain ascii, café ÿĀ ߿ࠀ 中文 "
+                                u"퟿ ￿ \U00010000 \U0001f600 \U0010ffff.";
+const std::u32string kMixed32 = U"plain ascii, café ÿĀ ߿ࠀ 中文 "
+                                U"퟿ ￿ \U00010000 \U0001f600 \U0010ffff.";
+
+} // namespace
+
+TEST(utf8, validate) {
+  const std::string valid[] = {"", "a", kMixed, "\xc2\x80", "\xdf\xbf", "\xe0\xa0\x80",
+                               "\xed\x9f\xbf", "\xee\x80\x80", "\xf0\x90\x80\x80",
+                               "\xf4\x8f\xbf\xbf"};
+  const std::string invalid[] = {
+      "\x80",             // stray continuation
+      "\xbf",             //
+      "\xc0\x80",         // overlong 2-byte
+      "\xc1\xbf",         //
+      "\xe0\x80\x80",     // overlong 3-byte
+      "\xe0\x9f\xbf",     //
+      "\xed\xa0\x80",     // surrogate U+D800
+      "\xed\xbf\xbf",     // surrogate U+DFFF
+      "\xf0\x80\x80\x80", // overlong 4-byte
+      "\xf0\x8f\xbf\xbf", //
+      "\xf4\x90\x80\x80", // U+110000
+      "\xf5\x80\x80\x80", // lead past F4
+      "\xff",             //
+      "\xc2",             // cut off
+      "\xe4\xb8",         //
+      "\xf0\x9f\x98",     //
+      "\xc2\x41",         // lead then ASCII
+      "\xe4\xb8\xad\x80", // one continuation too many
+      "\xf0\x9f\x98\x80\x80",
+  };
+  // Each case at every offset across the first two blocks, with ASCII or
+  // valid multi-byte text around it, so block edges split every sequence.
+  for (auto which : supported_isas()) {
+    SCOPED_TRACE(simd::isa_name(which));
+    for (size_t at = 0; at < 70; ++at) {
+      for (const std::string &filler : {std::string(100, 'x'), kMixed + kMixed}) {
+        // Cut the filler on a sequence boundary.
+        size_t cut = at;
+        while (cut < filler.size() && (filler[cut] & 0xc0) == 0x80)
+          ++cut;
+        const std::string head = filler.substr(0, cut);
+        for (const auto &ok : valid) {
+          const std::string text = head + ok + "tail";
+          ASSERT_TRUE(utf8::validate(text.data(), text.size(), which)) << at;
+          ASSERT_TRUE(utf8::validate(text.data(), head.size() + ok.size(), which)) << at;
+        }
+        for (const auto &bad : invalid) {
+          const std::string text = head + bad + filler.substr(cut);
+          ASSERT_FALSE(utf8::validate(text.data(), text.size(), which)) << at << ' ' << bad;
+          ASSERT_FALSE(utf8::validate(text.data(), head.size() + bad.size(), which)) << at;
+        }
+      }
+    }
+  }
+
+  // Random damage to valid text: every tier agrees with the scalar one.
+  std::mt19937 gen(11);
+  std::string text;
+  for (int i = 0; i < 40; ++i)
+    text += kMixed;
+  for (int round = 0; round < 3000; ++round) {
+    std::string damaged = text;
+    for (int k = round % 3; k >= 0; --k)
+      damaged[gen() % damaged.size()] = static_cast<char>(gen());
+    const size_t n = gen() % damaged.size();
+    const bool expected = utf8::validate(damaged.data(), n, simd::isa::scalar);
+    for (auto which : supported_isas())
+      ASSERT_EQ(utf8::validate(damaged.data(), n, which), expected) << round;
+  }
+}
+
+TEST(utf8, transcode) {
+  std::string text;
+  std::u16string text16;
+  std::u32string text32;
+  for (int i = 0; i < 10; ++i) {
+    text += kMixed + std::string(i * 7, 'a');
+    text16 += kMixed16 + std::u16string(i * 7, u'a');
+    text32 += kMixed32 + std::u32string(i * 7, U'a');
+  }
+  for (auto which : supported_isas()) {
+    SCOPED_TRACE(simd::isa_name(which));
+    for (size_t n = 0; n <= text.size(); n += (n < 100 ? 1 : 37)) {
+      // Cut on a sequence boundary and compare with the literals' prefixes.
+      while ((text[n] & 0xc0) == 0x80)
+        ++n;
+      std::u16string u16(n, u'\0');
+      std::u32string u32(n, U'\0');
+      const auto n16 = utf8::to_utf16(text.data(), n, u16.data(), which);
+      const auto n32 = utf8::to_utf32(text.data(), n, u32.data(), which);
+      ASSERT_TRUE(n16 && n32) << n;
+      u16.resize(*n16);
+      u32.resize(*n32);
+      ASSERT_EQ(u16, text16.substr(0, u16.size()));
+      ASSERT_EQ(u32, text32.substr(0, u32.size()));
+
+      std::string back(4 * n, '\0');
+      auto m = utf8::from_utf16(u16.data(), u16.size(), back.data(), which);
+      ASSERT_TRUE(m);
+      ASSERT_EQ(back.substr(0, *m), text.substr(0, n));
+      m = utf8::from_utf32(u32.data(), u32.size(), back.data(), which);
+      ASSERT_TRUE(m);
+      ASSERT_EQ(back.substr(0, *m), text.substr(0, n));
+    }
+
+    // Invalid input anywhere is reported, in a SIMD block or the tail.
+    std::string bad = text;
+    std::u16string bad16 = text16;
+    std::u32string bad32 = text32;
+    char16_t buf16[4096];
+    char32_t buf32[4096];
+    char buf8[4 * 4096];
+    for (size_t at : {size_t{3}, size_t{40}, text32.size() - 2}) {
+      bad[at] = '\xff';
+      EXPECT_FALSE(utf8::to_utf16(bad.data(), bad.size(), buf16, which));
+      EXPECT_FALSE(utf8::to_utf32(bad.data(), bad.size(), buf32, which));
+      bad16[at] = 0xdc00; // low surrogate alone
+      EXPECT_FALSE(utf8::from_utf16(bad16.data(), bad16.size(), buf8, which));
+      bad32[at] = 0x110000;
+      EXPECT_FALSE(utf8::from_utf32(bad32.data(), bad32.size(), buf8, which));
+      bad32[at] = 0xd800;
+      EXPECT_FALSE(utf8::from_utf32(bad32.data(), bad32.size(), buf8, which));
+      bad = text, bad16 = text16, bad32 = text32;
+    }
+    const char16_t high_at_end[] = {u'a', 0xd83d};
+    EXPECT_FALSE(utf8::from_utf16(high_at_end, 2, buf8, which));
+
+    // Long runs of 3-byte sequences, the edges of their range among them,
+    // with one bad sequence (or unit) at each position in the run.
+    const std::u16string run16 = u"中文ࠀ퟿￿字符串测试一二三四五六七八九十";
+    std::string run;
+    for (char16_t c : run16)
+      run.append(buf8, utf8::detail::kernels::encode(c, buf8));
+    for (size_t at = 0; at < run16.size(); ++at) {
+      for (const char *bad3 : {"\xe0\x9f\xbf", "\xed\xa0\x80", "\xe4\xb8\x41"}) {
+        std::string damaged = run + run;
+        damaged.replace(3 * at, 3, bad3);
+        EXPECT_FALSE(utf8::to_utf16(damaged.data(), damaged.size(), buf16, which)) << at;
+        EXPECT_FALSE(utf8::to_utf32(damaged.data(), damaged.size(), buf32, which)) << at;
+      }
+      std::u16string damaged16 = run16 + run16;
+      damaged16[at] = 0xdfff;
+      EXPECT_FALSE(utf8::from_utf16(damaged16.data(), damaged16.size(), buf8, which)) << at;
+      damaged16[at] = u'a'; // valid, but not 3 bytes
+      const std::string expected = std::string(run, 0, 3 * at) + 'a' + run.substr(3 * at + 3) + run;
+      const auto m = utf8::from_utf16(damaged16.data(), damaged16.size(), buf8, which);
+      ASSERT_TRUE(m);
+      EXPECT_EQ(std::string(buf8, *m), expected);
+      const auto m16 = utf8::to_utf16(expected.data(), expected.size(), buf16, which);
+      ASSERT_TRUE(m16);
+      EXPECT_EQ(std::u16string(buf16, *m16), damaged16);
+    }
+  }
+}
+
+namespace {
+
+/// 16 MB of text: mostly ASCII with some Latin-1, or mostly CJK with ASCII
+/// punctuation and spaces.
+std::string make_text(bool cjk) {
+  std::mt19937 gen(cjk ? 2 : 1);
+  std::string out;
+  char buf[4];
+  while (out.size() < (16 << 20)) {
+    const unsigned r = gen() % 100;
+    char32_t cp;
+    if (!cjk)
+      cp = r < 97 ? U'a' + gen() % 26 : (r < 99 ? U' ' : U'é');
+    else
+      cp = r < 85 ? U'一' + gen() % 0x5000 : (r < 95 ? U'。' : U' ');
+    out.append(buf, strings::utf8::detail::kernels::encode(cp, buf));
+  }
+  return out;
+}
+
+double gbps(size_t bytes, size_t rounds, uint64_t ns) {
+  return static_cast<double>(bytes) * rounds / static_cast<double>(ns);
+}
+
+} // namespace
+
+TEST(utf8, throughput_benchmark) {
+  constexpr size_t rounds = 4;
+  for (bool cjk : {false, true}) {
+    const std::string text = make_text(cjk);
+    std::vector<char16_t> u16(text.size());
+    std::vector<char32_t> u32(text.size());
+    std::vector<char> back(3 * text.size());
+    size_t n16 = 0;
+
+    std::ostringstream line;
+    line << std::setprecision(3) << (cjk ? "CJK-heavy" : "ASCII-heavy") << ", GB/s of UTF-8:";
+    for (auto which : supported_isas()) {
+      Timer t1("validate");
+      for (size_t r = 0; r < rounds; ++r)
+        EXPECT_TRUE(utf8::validate(text.data(), text.size(), which));
+      const double v = gbps(text.size(), rounds, t1.eclipse());
+      Timer t2("to_utf16");
+      for (size_t r = 0; r < rounds; ++r)
+        n16 = *utf8::to_utf16(text.data(), text.size(), u16.data(), which);
+      const double to16 = gbps(text.size(), rounds, t2.eclipse());
+      Timer t3("to_utf32");
+      for (size_t r = 0; r < rounds; ++r)
+        EXPECT_TRUE(utf8::to_utf32(text.data(), text.size(), u32.data(), which));
+      const double to32 = gbps(text.size(), rounds, t3.eclipse());
+      Timer t4("from_utf16");
+      for (size_t r = 0; r < rounds; ++r)
+        EXPECT_EQ(utf8::from_utf16(u16.data(), n16, back.data(), which), text.size());
+      const double from16 = gbps(text.size(), rounds, t4.eclipse());
+      line << "\n  " << simd::isa_name(which) << ": validate " << v << ", to_utf16 " << to16
+           << ", to_utf32 " << to32 << ", from_utf16 " << from16;
+    }
+#ifndef NDEBUG
+    std::cout << line.str() << '\n';
+#endif
+  }
+}
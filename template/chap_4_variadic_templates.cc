@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "internal_check_conds.h"
+#include "object_pool.hpp"
 
 template <typename T> void print(T arg) { std::cout << arg << '\n'; }
 
@@ -213,10 +214,12 @@ void print_using_fold_expression(Types const &...args) {
 }
 
 TEST(chap4_variadic_templates, fold_expression_traverse_test) {
-  // init binary tree structure.
-  Node *root = new Node{};
-  root->left = new Node{1};
-  root->left->right = new Node{2};
+  // init binary tree structure. Nodes live in a pool, which frees them all
+  // at once; Node is trivially destructible.
+  allocators::object_pool<Node> nodes;
+  Node *root = nodes.create();
+  root->left = nodes.create(1);
+  root->left->right = nodes.create(2);
 
   // traverse binary tree.
   Node *node = traverse(root, left, right);
@@ -1,3 +1,4 @@
+#include "aligned_buffer.hpp"
 #include "internal_check_conds.h"
 #include <gtest/gtest.h>
 #include <iostream>
@@ -209,7 +210,7 @@ template <typename T> class VectorSum3;
 
 template <typename T> class Vector {
 public:
-  explicit Vector(int size) : my_size(size), data(new T[my_size]) {}
+  explicit Vector(int size) : my_size(size), data(my_size) {}
 
   const T &operator[](int i) const {
     check_index(i);
@@ -234,7 +235,8 @@ private:
 
 private:
   size_t my_size;
-  T *data;
+  // Cache-line aligned and not zeroed; every element is assigned before use.
+  containers::aligned_buffer<T> data;
 };
 
 template <typename T>
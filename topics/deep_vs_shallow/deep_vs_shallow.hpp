@@ -1,9 +1,13 @@
 #pragma once
 
+#include "reference_cnt.h"
+#include "small_vector.hpp"
 #include <cassert>
 #include <iostream>
 #include <string>
 
+// Shallow keeps its raw fixed buffer on purpose: its copy shares the pointer
+// and both copies delete it, which is what this demo shows.
 class Shallow {
 private:
   int *data_ = nullptr;
@@ -40,31 +44,100 @@ public:
 
 class Deep {
 private:
-  int *data_ = nullptr;
-  constexpr static size_t capacity_ = 10;
-  size_t num_elements_ = 0;
+  // The first 10 elements live inside the object; more spill to the heap.
+  containers::small_vector<int, 10> data_;
 
 public:
-  explicit Deep() { data_ = new int[capacity_](); }
-  Deep(const Deep &rhs) {
-    data_ = new int[capacity_];
-    for (size_t i = 0; i < capacity_; ++i)
-      data_[i] = rhs.data_[i];
-    num_elements_ = rhs.num_elements_;
+  explicit Deep() = default;
+  Deep(const Deep &rhs) = default;
+  Deep &operator=(const Deep &rhs) = default;
+
+  void add(int elem) { data_.push_back(elem); }
+  int &getElemAt(unsigned idx) {
+    assert(idx < data_.size() && "index is out of range.");
+    return data_[idx];
   }
-  ~Deep() { delete[] data_; }
-  void add(int elem) {
-    if (num_elements_ >= capacity_) {
-      std::cerr << "Full buffer, exiting.\n";
-      return;
-    }
-    data_[num_elements_++] = elem;
+
+  [[nodiscard]] int *begin() { return data_.begin(); }
+  [[nodiscard]] int *end() { return data_.end(); }
+  [[nodiscard]] const int *begin() const { return data_.begin(); }
+  [[nodiscard]] const int *end() const { return data_.end(); }
+};
+
+/// Shares its storage on copy like Shallow, but the storage is reference
+/// counted, so it is freed exactly once. The first write through a buffer
+/// whose storage is shared clones it first, so copies never see each other's
+/// writes, like Deep. Copying is O(1); only copies that are written to pay
+/// for a deep copy.
+///
+/// A mutable reference or pointer into the storage (non-const getElemAt,
+/// begin, end) would let a later copy see writes through it. So, as the
+/// old copy-on-write std::string did, handing one out marks the storage
+/// unshareable, and from then on copies of this buffer are deep.
+class CowBuffer {
+private:
+  struct Storage : public reference_count::Object {
+    containers::small_vector<int, 10> data;
+    bool unshareable = false; // a mutable reference into data is out
+  };
+
+  reference_count::ref<Storage> storage_{new Storage};
+
+  /// rhs's storage, or a copy of it if it must not be shared.
+  static reference_count::ref<Storage> share(const CowBuffer &rhs) {
+    if (!rhs.storage_->unshareable)
+      return rhs.storage_;
+    auto *copy = new Storage(*rhs.storage_);
+    copy->unshareable = false;
+    return reference_count::ref<Storage>{copy};
   }
+
+  /// Make the storage ours alone before writing to it.
+  Storage &mutableStorage() {
+    if (storage_->getRefCount() > 1)
+      storage_ = reference_count::ref<Storage>{new Storage(*storage_)};
+    return *storage_;
+  }
+
+  /// As mutableStorage(), for handing out a reference into it.
+  Storage &leakedStorage() {
+    Storage &storage = mutableStorage();
+    storage.unshareable = true;
+    return storage;
+  }
+
+public:
+  explicit CowBuffer() = default;
+
+  // No move operations: a moved-from ref is null, so moves copy instead.
+  CowBuffer(const CowBuffer &rhs) : storage_(share(rhs)) {}
+  CowBuffer &operator=(const CowBuffer &rhs) {
+    if (this != &rhs)
+      storage_ = share(rhs);
+    return *this;
+  }
+
+  void add(int elem) { mutableStorage().data.push_back(elem); }
+
   int &getElemAt(unsigned idx) {
-    assert(idx < num_elements_ && "index is out of range.");
-    return data_[idx];
+    assert(idx < storage_->data.size() && "index is out of range.");
+    return leakedStorage().data[idx];
   }
 
-  [[nodiscard]] int *begin() { return data_; }
-  [[nodiscard]] int *end() { return data_ + num_elements_; }
-};
\ No newline at end of file
+  [[nodiscard]] int getElemAt(unsigned idx) const {
+    assert(idx < storage_->data.size() && "index is out of range.");
+    return storage_->data[idx];
+  }
+
+  [[nodiscard]] size_t size() const { return storage_->data.size(); }
+
+  /// True if another CowBuffer currently shares this one's storage.
+  [[nodiscard]] bool shared() const { return storage_->getRefCount() > 1; }
+
+  /// Mutable iteration unshares the storage and keeps it unshared; iterate
+  /// a const CowBuffer to read without copying.
+  [[nodiscard]] int *begin() { return leakedStorage().data.begin(); }
+  [[nodiscard]] int *end() { return leakedStorage().data.end(); }
+  [[nodiscard]] const int *begin() const { return storage_->data.begin(); }
+  [[nodiscard]] const int *end() const { return storage_->data.end(); }
+};
@@ -1,7 +1,10 @@
 #include "deep_vs_shallow.hpp"
+#include "my_timer.h"
 #include <algorithm>
 #include <gtest/gtest.h>
 #include <iterator>
+#include <numeric>
+#include <utility>
 
 TEST(deep_vs_shallow, basic_test) {
   std::ostringstream oss;
@@ -47,4 +50,98 @@ TEST(deep_vs_shallow, basic_test) {
 #endif
 
   EXPECT_TRUE(oss.str() == act_output);
-}
\ No newline at end of file
+}
+
+TEST(deep_vs_shallow, copy_on_write) {
+  CowBuffer a;
+  for (int i = 0; i < 10; ++i)
+    a.add(i);
+
+  CowBuffer b = a;
+  EXPECT_TRUE(a.shared());
+  EXPECT_EQ(std::as_const(b).getElemAt(3), 3);
+  EXPECT_TRUE(a.shared()); // reading does not unshare
+
+  b.getElemAt(0) = 100;
+  EXPECT_FALSE(a.shared());
+  EXPECT_FALSE(b.shared());
+  EXPECT_EQ(std::as_const(a).getElemAt(0), 0);
+  EXPECT_EQ(std::as_const(b).getElemAt(0), 100);
+
+  {
+    CowBuffer c = a;
+    CowBuffer d = c;
+    EXPECT_TRUE(a.shared());
+  }
+  EXPECT_FALSE(a.shared());
+}
+
+TEST(deep_vs_shallow, copy_on_write_after_reference) {
+  CowBuffer a;
+  for (int i = 0; i < 10; ++i)
+    a.add(i);
+
+  // A copy made while a reference into a is out does not share with it.
+  int &r = a.getElemAt(0);
+  CowBuffer b = a;
+  EXPECT_FALSE(a.shared());
+  r = 42;
+  EXPECT_EQ(std::as_const(a).getElemAt(0), 42);
+  EXPECT_EQ(std::as_const(b).getElemAt(0), 0);
+
+  // The same for a pointer from begin(), and for assignment.
+  int *p = b.begin();
+  CowBuffer c;
+  c = b;
+  p[1] = 43;
+  EXPECT_EQ(std::as_const(b).getElemAt(1), 43);
+  EXPECT_EQ(std::as_const(c).getElemAt(1), 1);
+
+  // Copies of the copies, never written through a reference, share again.
+  CowBuffer d = c;
+  EXPECT_TRUE(c.shared());
+}
+
+namespace {
+
+/// Copy a full buffer `copies` times, read every element of each copy, and
+/// write to one copy in `write_every`.
+template <typename Buffer> uint64_t copy_read_mostly(const Buffer &origin, size_t copies,
+                                                     size_t write_every, long &checksum) {
+  Timer t("copy_read_mostly");
+  for (size_t i = 0; i < copies; ++i) {
+    Buffer copy(origin);
+    if (i % write_every == 0)
+      copy.getElemAt(i % 10) = static_cast<int>(i);
+    const Buffer &reader = copy;
+    checksum += std::accumulate(reader.begin(), reader.end(), 0L);
+  }
+  return t.eclipse();
+}
+
+} // namespace
+
+TEST(deep_vs_shallow, copy_on_write_benchmark) {
+  constexpr size_t copies = 1'000'000;
+  constexpr size_t write_every = 16;
+
+  Deep deep;
+  CowBuffer cow;
+  for (int i = 0; i < 10; ++i) {
+    deep.add(i);
+    cow.add(i);
+  }
+
+  long deep_sum = 0, cow_sum = 0;
+  auto deep_ns = copy_read_mostly(deep, copies, write_every, deep_sum);
+  auto cow_ns = copy_read_mostly(cow, copies, write_every, cow_sum);
+  EXPECT_EQ(deep_sum, cow_sum);
+
+#ifndef NDEBUG
+  std::cout << "copy + read, 1 write in " << write_every << ": Deep "
+            << static_cast<double>(deep_ns) / copies << "ns/copy, CowBuffer "
+            << static_cast<double>(cow_ns) / copies << "ns/copy\n";
+#else
+  (void)deep_ns, (void)cow_ns;
+#endif
+}
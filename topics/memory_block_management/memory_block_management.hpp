@@ -10,64 +10,147 @@
 //
 //  Originally published here:
 //    https://docs.microsoft.com/en-us/cpp/cpp/move-constructors-and-move-assignment-operators-cpp?view=vs-2017
+//
+//  BasicMemoryBlock<Alloc, LogPolicy> is allocator-aware, so blocks can be
+//  carved out of an allocators::Arena (see allocators/arena.hpp) instead of
+//  one heap allocation each. Tracing every special member is a compile-time
+//  policy: VerboseLog reproduces the original output, NoLog compiles away.
+//  `MemoryBlock` keeps the original behaviour.
 
+#include "relocation.hpp"
 #include <algorithm>
 #include <iostream>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+struct VerboseLog {
+  static void construct(size_t len) {
+    std::cout << "In MemoryBlock(size_t). length = " << len << ".\n";
+  }
+  static void destroy(size_t len, bool has_resource) {
+    std::cout << "In ~MemoryBlock(). length = " << len << ".\n";
+    if (has_resource)
+      std::cout << "Deleting resource.\n";
+  }
+  static void copy_construct(size_t len) {
+    std::cout << "In MemoryBlock(const MemoryBlock &). length = " << len << ". "
+              << "Copying resource.\n";
+  }
+  static void copy_assign(size_t len) {
+    std::cout << "In operator=(const MemoryBlock &). length = " << len << ". "
+              << "Copying resource.\n";
+  }
+  static void move_construct(size_t len) {
+    std::cout << "In MemoryBlock(MemoryBlock &&). length = " << len << ". Moving resource.\n";
+  }
+  static void move_assign(size_t len) {
+    std::cout << "In operator=(MemoryBlock &&). length = " << len << ".\n";
+  }
+};
+
+struct NoLog {
+  static void construct(size_t) {}
+  static void destroy(size_t, bool) {}
+  static void copy_construct(size_t) {}
+  static void copy_assign(size_t) {}
+  static void move_construct(size_t) {}
+  static void move_assign(size_t) {}
+};
 
-class MemoryBlock {
+template <typename Alloc = std::allocator<int>, typename LogPolicy = VerboseLog>
+class BasicMemoryBlock {
 private:
-  size_t length_; // The length of the resources.
-  int *data_;     // The resource
+  using Traits = std::allocator_traits<Alloc>;
+  static_assert(std::is_same_v<typename Traits::value_type, int>, "MemoryBlock stores ints");
+
+  [[no_unique_address]] Alloc alloc_;
+  size_t length_ = 0;   // The length of the resources.
+  int *data_ = nullptr; // The resource
 
 public:
-  explicit MemoryBlock(size_t len);
+  using allocator_type = Alloc;
+  /// The block is a pointer, a length and the allocator, none of which care
+  /// about their address (for stateless or trivially copyable allocators),
+  /// so containers may relocate it with memcpy (see
+  /// containers/relocation.hpp). The move constructor is then not called,
+  /// and VerboseLog does not print it.
+  using trivially_relocatable =
+      containers::relocatable_tag<BasicMemoryBlock, std::is_empty_v<Alloc> ||
+                                                        std::is_trivially_copyable_v<Alloc>>;
+
+  explicit BasicMemoryBlock(size_t len, const Alloc &alloc = Alloc());
   // copy constructor
-  MemoryBlock(const MemoryBlock &mem_obj);
+  BasicMemoryBlock(const BasicMemoryBlock &mem_obj);
   // copy assignment operator
-  MemoryBlock &operator=(const MemoryBlock &mem_obj);
+  BasicMemoryBlock &operator=(const BasicMemoryBlock &mem_obj);
   // move constructor
-  MemoryBlock(MemoryBlock &&mem_obj) noexcept;
+  BasicMemoryBlock(BasicMemoryBlock &&mem_obj) noexcept;
   // move assignment operator
-  MemoryBlock &operator=(MemoryBlock &&mem_obj) noexcept;
+  BasicMemoryBlock &operator=(BasicMemoryBlock &&mem_obj) noexcept;
   // destructor
-  ~MemoryBlock();
+  ~BasicMemoryBlock();
 
   // retrieves the length of the data resource.
   [[nodiscard]] size_t length() const { return length_; }
+  [[nodiscard]] int *data() { return data_; }
+  [[nodiscard]] const int *data() const { return data_; }
+  [[nodiscard]] allocator_type get_allocator() const { return alloc_; }
+
+private:
+  void reset() {
+    if (data_ != nullptr)
+      Traits::deallocate(alloc_, data_, length_);
+    data_ = nullptr;
+    length_ = 0;
+  }
 };
 
-MemoryBlock::MemoryBlock(size_t len) : length_(len), data_(new int[len]) {
-  std::cout << "In MemoryBlock(size_t). length = " << length_ << ".\n";
+using MemoryBlock = BasicMemoryBlock<>;
+
+template <typename Alloc, typename LogPolicy>
+BasicMemoryBlock<Alloc, LogPolicy>::BasicMemoryBlock(size_t len, const Alloc &alloc)
+    : alloc_(alloc), length_(len), data_(Traits::allocate(alloc_, len)) {
+  LogPolicy::construct(length_);
+}
+
+template <typename Alloc, typename LogPolicy>
+BasicMemoryBlock<Alloc, LogPolicy>::~BasicMemoryBlock() {
+  LogPolicy::destroy(length_, data_ != nullptr);
+  reset();
 }
 
-MemoryBlock::~MemoryBlock() {
-  std::cout << "In ~MemoryBlock(). length = " << length_ << ".\n";
-  if (data_ != nullptr)
-    std::cout << "Deleting resource.\n";
-  delete data_;
+template <typename Alloc, typename LogPolicy>
+BasicMemoryBlock<Alloc, LogPolicy>::BasicMemoryBlock(const BasicMemoryBlock &mem_obj)
+    : alloc_(Traits::select_on_container_copy_construction(mem_obj.alloc_)),
+      length_(mem_obj.length_), data_(Traits::allocate(alloc_, length_)) {
+  LogPolicy::copy_construct(length_);
+  std::copy(mem_obj.data_, mem_obj.data_ + length_, data_);
 }
 
-MemoryBlock &MemoryBlock::operator=(const MemoryBlock &mem_obj) {
-  std::cout << "In operator=(const MemoryBlock &). length = "
-            << mem_obj.length() << ". "
-            << "Copying resource.\n";
+template <typename Alloc, typename LogPolicy>
+BasicMemoryBlock<Alloc, LogPolicy> &
+BasicMemoryBlock<Alloc, LogPolicy>::operator=(const BasicMemoryBlock &mem_obj) {
+  LogPolicy::copy_assign(mem_obj.length());
   if (this == &mem_obj)
     return *this;
 
   // free the existing resource.
-  delete[] data_;
+  reset();
 
+  if constexpr (Traits::propagate_on_container_copy_assignment::value)
+    alloc_ = mem_obj.alloc_;
+  data_ = Traits::allocate(alloc_, mem_obj.length_);
   length_ = mem_obj.length_;
-  data_ = new int[length_];
   std::copy(mem_obj.data_, mem_obj.data_ + length_, data_);
 
   return *this;
 }
 
-MemoryBlock::MemoryBlock(MemoryBlock &&mem_obj) noexcept
-    : length_(0), data_(nullptr) {
-  std::cout << "In MemoryBlock(MemoryBlock &&). length = " << mem_obj.length_
-            << ". Moving resource.\n";
+template <typename Alloc, typename LogPolicy>
+BasicMemoryBlock<Alloc, LogPolicy>::BasicMemoryBlock(BasicMemoryBlock &&mem_obj) noexcept
+    : alloc_(std::move(mem_obj.alloc_)) {
+  LogPolicy::move_construct(mem_obj.length_);
 
   // Copy the data pointer and its length from the source object.
   data_ = mem_obj.data_;
@@ -79,16 +162,31 @@ MemoryBlock::MemoryBlock(MemoryBlock &&mem_obj) noexcept
   mem_obj.length_ = 0;
 }
 
-MemoryBlock &MemoryBlock::operator=(MemoryBlock &&mem_obj) noexcept {
-  std::cout << "In operator=(MemoryBlock &&). length = " << mem_obj.length_
-            << ".\n";
+template <typename Alloc, typename LogPolicy>
+BasicMemoryBlock<Alloc, LogPolicy> &
+BasicMemoryBlock<Alloc, LogPolicy>::operator=(BasicMemoryBlock &&mem_obj) noexcept {
+  LogPolicy::move_assign(mem_obj.length_);
 
   // is this is the specified MemoryBlock object, return this directly.
   if (this == &mem_obj)
     return *this;
 
   // free the existing resource.
-  delete[] data_;
+  reset();
+
+  // Memory from a different, non-propagating allocator can't be adopted;
+  // copy the contents instead.
+  if constexpr (!Traits::propagate_on_container_move_assignment::value &&
+                !Traits::is_always_equal::value) {
+    if (alloc_ != mem_obj.alloc_) {
+      data_ = Traits::allocate(alloc_, mem_obj.length_);
+      length_ = mem_obj.length_;
+      std::copy(mem_obj.data_, mem_obj.data_ + length_, data_);
+      return *this;
+    }
+  }
+  if constexpr (Traits::propagate_on_container_move_assignment::value)
+    alloc_ = std::move(mem_obj.alloc_);
 
   // copy the data pointer and its length from the source object.
   data_ = mem_obj.data_;
@@ -100,4 +198,4 @@ MemoryBlock &MemoryBlock::operator=(MemoryBlock &&mem_obj) noexcept {
   mem_obj.length_ = 0;
 
   return *this;
-}
\ No newline at end of file
+}
@@ -1,5 +1,9 @@
+#include "arena.hpp"
 #include "memory_block_management.hpp"
+#include "my_timer.h"
+#include "small_vector.hpp"
 #include <gtest/gtest.h>
+#include <memory_resource>
 
 TEST(memory_block, basic_test) {
   std::stringstream oss;
@@ -48,4 +52,97 @@ TEST(memory_block, basic_test) {
 
   // FIXME: seems gcc and clang has different results, so disable this checking.
   // EXPECT_TRUE(oss.str() == act_output);
-}
\ No newline at end of file
+}
+
+TEST(memory_block, relocatable_pool) {
+  // Same sequence as basic_test, in a container that relocates MemoryBlock
+  // with memmove: growth and the mid insert print no move or destroy lines.
+  testing::internal::CaptureStdout();
+
+  containers::relocatable_vector<MemoryBlock> pool;
+  pool.emplace_back(25);
+  pool.emplace_back(75);
+  pool.emplace(pool.begin() + 1, 50);
+  EXPECT_EQ(pool[1].length(), 50);
+  pool.clear();
+
+  EXPECT_EQ(testing::internal::GetCapturedStdout(),
+            "In MemoryBlock(size_t). length = 25.\n"
+            "In MemoryBlock(size_t). length = 75.\n"
+            "In MemoryBlock(size_t). length = 50.\n"
+            "In ~MemoryBlock(). length = 25.\n"
+            "Deleting resource.\n"
+            "In ~MemoryBlock(). length = 50.\n"
+            "Deleting resource.\n"
+            "In ~MemoryBlock(). length = 75.\n"
+            "Deleting resource.\n");
+}
+
+TEST(memory_block, arena_backed_blocks) {
+  using ArenaBlock = BasicMemoryBlock<allocators::ArenaAllocator<int>, NoLog>;
+  allocators::Arena arena;
+  allocators::ArenaAllocator<int> alloc{arena};
+
+  testing::internal::CaptureStdout();
+  {
+    std::vector<ArenaBlock> pool;
+    pool.emplace_back(25, alloc);
+    pool.emplace_back(75, alloc);
+    pool.insert(pool.begin() + 1, ArenaBlock{50, alloc});
+    std::fill_n(pool[1].data(), pool[1].length(), 7);
+
+    ArenaBlock copy = pool[1];
+    EXPECT_EQ(copy.length(), 50);
+    EXPECT_EQ(copy.data()[49], 7);
+    EXPECT_NE(copy.data(), pool[1].data());
+  }
+  // NoLog: nothing is printed.
+  EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+  EXPECT_EQ(arena.bytes_allocated(), (25 + 75 + 50 + 50) * sizeof(int));
+}
+
+TEST(memory_block, million_blocks_benchmark) {
+  constexpr size_t num_blocks = 1000000;
+  constexpr size_t block_len = 16;
+  uint64_t heap_time, arena_time, pmr_time;
+
+  {
+    Timer T("MemoryBlock with std::allocator");
+    std::vector<BasicMemoryBlock<std::allocator<int>, NoLog>> blocks;
+    blocks.reserve(num_blocks);
+    for (size_t i = 0; i < num_blocks; ++i)
+      blocks.emplace_back(block_len);
+    blocks.clear();
+    heap_time = T.eclipse();
+  }
+
+  allocators::Arena arena;
+  {
+    Timer T("MemoryBlock with ArenaAllocator");
+    std::vector<BasicMemoryBlock<allocators::ArenaAllocator<int>, NoLog>> blocks;
+    blocks.reserve(num_blocks);
+    allocators::ArenaAllocator<int> alloc{arena};
+    for (size_t i = 0; i < num_blocks; ++i)
+      blocks.emplace_back(block_len, alloc);
+    blocks.clear();
+    arena.release();
+    arena_time = T.eclipse();
+  }
+
+  {
+    Timer T("MemoryBlock with pmr arena");
+    std::vector<BasicMemoryBlock<std::pmr::polymorphic_allocator<int>, NoLog>> blocks;
+    blocks.reserve(num_blocks);
+    for (size_t i = 0; i < num_blocks; ++i)
+      blocks.emplace_back(block_len, &arena);
+    blocks.clear();
+    arena.release();
+    pmr_time = T.eclipse();
+  }
+
+#ifndef NDEBUG
+  std::cout << "1M blocks, build + drop: std::allocator " << heap_time / 1000000 << "ms, "
+            << "ArenaAllocator " << arena_time / 1000000 << "ms, "
+            << "pmr::polymorphic_allocator(Arena) " << pmr_time / 1000000 << "ms\n";
+#endif
+}
@@ -1,8 +1,156 @@
+#include "my_timer.h"
+#include "split_view.hpp"
 #include <gtest/gtest.h>
-// #include <ranges>
+#include <random>
+#include <ranges>
+#include <sstream>
+#include <string>
 #include <string_view>
+#include <vector>
+
+namespace {
+
+template <typename Range> std::vector<std::string_view> collect(Range &&pieces) {
+  std::vector<std::string_view> out;
+  for (std::string_view piece : pieces)
+    out.push_back(piece);
+  return out;
+}
+
+using Pieces = std::vector<std::string_view>;
+
+} // namespace
 
 TEST(string_split, basic_test) {
-  auto split_strings = std::string_view{
-      "Hello world C++20!"}; // | std::ranges::views::split(' ');
-}
\ No newline at end of file
+  auto split_strings = std::string_view{"Hello world C++20!"} | std::views::split(' ');
+  Pieces words;
+  for (auto &&word : split_strings)
+    words.emplace_back(word.begin(), word.end());
+  EXPECT_EQ(words, (Pieces{"Hello", "world", "C++20!"}));
+
+  EXPECT_EQ(collect(strings::split("Hello world C++20!", ' ')), words);
+}
+
+TEST(string_split, split_view_delimiters) {
+  // Same edge cases as std::views::split.
+  EXPECT_EQ(collect(strings::split("", ',')), Pieces{});
+  EXPECT_EQ(collect(strings::split("a,,b,", ',')), (Pieces{"a", "", "b", ""}));
+  EXPECT_EQ(collect(strings::split(",", ',')), (Pieces{"", ""}));
+  EXPECT_EQ(collect(strings::split("no delimiter", ',')), Pieces{"no delimiter"});
+
+  EXPECT_EQ(collect(strings::split("k1 = v1, k2 = v2,k3", ", ")),
+            (Pieces{"k1 = v1", "k2 = v2,k3"}));
+  EXPECT_EQ(collect(strings::split("a<>>b<>", "<>")), (Pieces{"a", ">b", ""}));
+
+  EXPECT_EQ(collect(strings::split("one two\tthree\nfour", strings::any_of{" \t\n"})),
+            (Pieces{"one", "two", "three", "four"}));
+
+  // Long enough for the 32-byte blocks, delimiters at block edges.
+  std::string text(100, 'x');
+  text[15] = text[31] = text[32] = text[99] = ';';
+  auto pieces = collect(strings::split(text, ';'));
+  EXPECT_EQ(pieces.size(), 5);
+  EXPECT_EQ(pieces[0].size(), 15);
+  EXPECT_EQ(pieces[2], "");
+  EXPECT_EQ(pieces[3].size(), 66);
+  EXPECT_EQ(pieces[4], "");
+
+  // A forward range: walk it twice, use range algorithms on it.
+  auto view = strings::split("a:b:c", ':');
+  static_assert(std::ranges::forward_range<decltype(view)>);
+  EXPECT_EQ(std::ranges::distance(view), 3);
+  EXPECT_EQ(*std::ranges::next(view.begin(), 2), "c");
+}
+
+namespace {
+
+/// Lines of space-separated words, 2-12 letters each, ~16 words per line.
+std::string make_text(size_t bytes) {
+  std::mt19937 gen(340);
+  std::uniform_int_distribution<int> word_len(2, 12), letter('a', 'z'), words_per_line(8, 24);
+  std::string text;
+  text.reserve(bytes + 64);
+  while (text.size() < bytes) {
+    for (int w = words_per_line(gen); w > 0; --w) {
+      for (int l = word_len(gen); l > 0; --l)
+        text.push_back(static_cast<char>(letter(gen)));
+      text.push_back(w > 1 ? ' ' : '\n');
+    }
+  }
+  return text;
+}
+
+struct SplitStats {
+  size_t pieces = 0;
+  size_t bytes = 0;
+  bool operator==(const SplitStats &) const = default;
+};
+
+template <typename Range> SplitStats tally(Range &&pieces) {
+  SplitStats s;
+  for (std::string_view piece : pieces) {
+    ++s.pieces;
+    s.bytes += piece.size();
+  }
+  return s;
+}
+
+} // namespace
+
+TEST(string_split, split_benchmark) {
+  // 1GB of text and a second copy inside an istringstream does not fit a
+  // test run; 64MB is well past every cache level and shows the same rates.
+  constexpr size_t bytes = 64 << 20;
+  const std::string text = make_text(bytes);
+
+  SplitStats ours, ranges, lines;
+  Timer t1("split_view");
+  ours = tally(strings::split(text, '\n'));
+  auto ours_ns = t1.eclipse();
+
+  Timer t2("views::split");
+  for (auto &&piece : std::string_view(text) | std::views::split('\n')) {
+    ++ranges.pieces;
+    ranges.bytes += std::string_view(piece.begin(), piece.end()).size();
+  }
+  auto ranges_ns = t2.eclipse();
+
+  std::istringstream in(text);
+  Timer t3("getline");
+  for (std::string line; std::getline(in, line, '\n');) {
+    ++lines.pieces;
+    lines.bytes += line.size();
+  }
+  auto getline_ns = t3.eclipse();
+  // getline does not report the empty piece after the final '\n'.
+  EXPECT_EQ(ours.pieces, lines.pieces + 1);
+  EXPECT_EQ(ours, ranges);
+
+  Timer t4("split_view words");
+  auto words = tally(strings::split(text, ' '));
+  auto words_ns = t4.eclipse();
+  Timer t5("split_view any_of");
+  auto tokens = tally(strings::split(text, strings::any_of{" \n"}));
+  auto any_ns = t5.eclipse();
+  EXPECT_EQ(tokens.pieces, words.pieces + ours.pieces - 1);
+  SplitStats ranges_words;
+  Timer t6("views::split words");
+  for (auto &&piece : std::string_view(text) | std::views::split(' ')) {
+    ++ranges_words.pieces;
+    ranges_words.bytes += std::string_view(piece.begin(), piece.end()).size();
+  }
+  auto ranges_words_ns = t6.eclipse();
+  EXPECT_EQ(words, ranges_words);
+
+#ifndef NDEBUG
+  auto gbps = [&](uint64_t ns) { return static_cast<double>(text.size()) / ns; };
+  std::cout << text.size() / (1 << 20) << " MB, GB/s. lines (" << ours.pieces
+            << "): split_view " << gbps(ours_ns) << ", views::split " << gbps(ranges_ns)
+            << ", getline " << gbps(getline_ns) << "; words (" << words.pieces
+            << "): split_view ' ' " << gbps(words_ns) << ", any_of \" \\n\" " << gbps(any_ns)
+            << ", views::split ' ' " << gbps(ranges_words_ns) << '\n';
+#else
+  (void)ours_ns, (void)ranges_ns, (void)getline_ns, (void)words_ns, (void)any_ns,
+      (void)ranges_words_ns;
+#endif
+}